@@ -27,7 +27,7 @@ namespace VulkanDemo
         cameraController = new MongooseVK::CameraController(camera);
 
         LOG_TRACE("Loading scene...");
-        renderer.LoadScene(scenes.SPONZA2, environments.CASTLE);
+        renderer.LoadScene(scenes.SPONZA2, environments.CASTLE, {.packed = true, .quantizedPosition = true});
 
         LOG_TRACE("Init ImGui");
         imGuiVulkan.Init(glfwWindow, &renderer);
@@ -1,6 +1,9 @@
 #include <application/demo_application.h>
 #include "application/application.h"
 #include "util/log.h"
+#include "util/profiler.h"
+
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
@@ -17,7 +20,14 @@ int main(int argc, char* argv[])
 
     MongooseVK::Application* application = new VulkanDemo::DemoApplication(config);
 
+    // Traces loading the scene, shaders and pipelines into a file chrome://tracing can open
+    const bool traceStartup = argc > 1 && strcmp(argv[1], "--trace-startup") == 0;
+    if (traceStartup) MongooseVK::Profiler::BeginCapture();
+
     application->Init();
+
+    if (traceStartup) MongooseVK::Profiler::EndCapture("startup_trace.json");
+
     application->Run();
 
     return 0;
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <random>
 #include <backends/imgui_impl_vulkan.h>
 #include <input/camera_controller.h>
 #include <renderer/vulkan/vulkan_image.h>
+#include <renderer/vulkan/vulkan_gpu_scene.h>
 #include <renderer/vulkan/vulkan_texture.h>
 #include <renderer/vulkan/pass/infinite_grid_pass.h>
 #include <renderer/vulkan/pass/post_processing/ssao_pass.h>
 #include <renderer/vulkan/pass/post_processing/tone_mapping_pass.h>
+#include <util/profiler.h>
 
 #include "imgui.h"
 #include "renderer/vulkan/imgui_vulkan.h"
@@ -31,6 +34,143 @@ namespace VulkanDemo
             ImGui::Text(deviceProperties.deviceName);
             ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
             ImGui::Text("%d draw calls", device->GetDrawCallCount(), io.Framerate);
+
+            const MongooseVK::LinearArena& frameArena = device->GetFrameArena();
+            ImGui::Text("Frame arena: %.1f / %.1f KB peak, %u heap fallbacks",
+                        frameArena.GetPeakUsed() / 1024.0f,
+                        frameArena.GetCapacity() / 1024.0f,
+                        frameArena.GetLastOverflowCount());
+
+            const MongooseVK::VulkanUniformRing& uniformRing = device->GetUniformRing();
+            ImGui::Text("Uniform ring: %.1f / %.1f KB peak",
+                        uniformRing.GetPeakUsed() / 1024.0f,
+                        uniformRing.GetFrameSize() / 1024.0f);
+
+            const MongooseVK::PipelineCacheStats pipelineStats = device->GetPipelineCache().GetStats();
+            ImGui::Text("Pipelines: %u created in %.2f ms, %s cache",
+                        pipelineStats.pipelineCount,
+                        pipelineStats.creationTime,
+                        pipelineStats.loadedSize > 0 ? "warm" : "cold");
+
+#ifdef ENABLE_PROFILER
+            ImGui::BeginDisabled(MongooseVK::Profiler::IsCapturing());
+            if (ImGui::Button("Capture CPU trace"))
+                MongooseVK::Profiler::CaptureFrames(120, "frame_trace.json");
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            ImGui::TextUnformatted("120 frames to frame_trace.json");
+#endif
+
+            DrawGpuTimings();
+
+            for (MongooseVK::VulkanGeometryArena* geometryArena: device->GetGeometryArenas())
+            {
+                const MongooseVK::GeometryArenaStats geometryStats = geometryArena->GetStats();
+                ImGui::Separator();
+                ImGui::Text("Geometry arena (%s, %u bytes/vertex): %u allocations",
+                            geometryStats.vertexFormat.packed ? "packed" : "standard",
+                            geometryStats.vertexSize,
+                            geometryStats.allocations);
+                ImGui::Text("Vertices: %.1f / %.1f MB (%.0f%% fragmented)",
+                            geometryStats.vertexUsed * geometryStats.vertexSize / (1024.0f * 1024.0f),
+                            geometryStats.vertexCapacity * geometryStats.vertexSize / (1024.0f * 1024.0f),
+                            geometryStats.vertexFragmentation * 100.0f);
+                ImGui::Text("Indices: %.1f / %.1f MB (%.0f%% fragmented)",
+                            geometryStats.indexUsed * sizeof(uint32_t) / (1024.0f * 1024.0f),
+                            geometryStats.indexCapacity * sizeof(uint32_t) / (1024.0f * 1024.0f),
+                            geometryStats.indexFragmentation * 100.0f);
+            }
+
+            MongooseVK::SceneGraph* sceneGraph = renderer.GetSceneGraph();
+            if (sceneGraph && sceneGraph->gpuScene)
+            {
+                MongooseVK::VulkanGpuScene* gpuScene = sceneGraph->gpuScene;
+                const MongooseVK::GpuCullingStats& cullingStats = gpuScene->GetCullingStats();
+
+                ImGui::Separator();
+
+                bool occlusionCulling = renderer.IsOcclusionCullingEnabled();
+                if (ImGui::Checkbox("Occlusion culling", &occlusionCulling))
+                    renderer.SetOcclusionCulling(occlusionCulling);
+
+                ImGui::Text("Clusters: %u", gpuScene->GetDrawCount());
+                ImGui::Text("Frustum culled: %u", cullingStats.frustumCulled);
+                ImGui::Text("Backface culled: %u", cullingStats.backfaceCulled);
+                ImGui::Text("Occlusion culled: %u", cullingStats.occlusionCulled);
+                ImGui::Text("Drawn: %u early, %u late", cullingStats.drawnEarly, cullingStats.drawnLate);
+            }
+        }
+
+    private:
+        void DrawGpuTimings() const
+        {
+            MongooseVK::VulkanGpuProfiler& profiler = device->GetGpuProfiler();
+
+            ImGui::Separator();
+            ImGui::Text("GPU: %.3f ms/frame", profiler.GetFrameTime());
+
+            if (profiler.IsPipelineStatisticsSupported())
+            {
+                bool pipelineStatistics = profiler.IsPipelineStatisticsEnabled();
+                if (ImGui::Checkbox("Pipeline statistics", &pipelineStatistics))
+                    profiler.SetPipelineStatisticsEnabled(pipelineStatistics);
+            }
+
+            ImGui::SameLine();
+            if (ImGui::Button("Reset timings"))
+                profiler.ResetStats();
+
+            const bool showStatistics = profiler.IsPipelineStatisticsEnabled();
+            const int columnCount = showStatistics ? 9 : 5;
+
+            if (!ImGui::BeginTable("GpuTimings", columnCount, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+                return;
+
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Min ms");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("P99 ms");
+
+            if (showStatistics)
+            {
+                ImGui::TableSetupColumn("Primitives");
+                ImGui::TableSetupColumn("VS invocations");
+                ImGui::TableSetupColumn("FS invocations");
+                ImGui::TableSetupColumn("CS invocations");
+            }
+
+            ImGui::TableHeadersRow();
+
+            for (const MongooseVK::GpuScopeStats& stats: profiler.GetScopeStats())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stats.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.lastTime);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.minTime);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.avgTime);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.p99Time);
+
+                if (showStatistics)
+                {
+                    const MongooseVK::GpuPipelineStatistics& pipelineStatistics = stats.pipelineStatistics;
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.inputAssemblyPrimitives));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.vertexShaderInvocations));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.fragmentShaderInvocations));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.computeShaderInvocations));
+                }
+            }
+
+            ImGui::EndTable();
         }
 
     private:
@@ -108,42 +248,42 @@ namespace VulkanDemo
             // Viewspace Normal
             {
                 auto viewspaceNormal = MongooseVK::VulkanDevice::Get()->GetTexture(
-                    renderer.frameGraph->renderPassResourceMap["viewspace_normal"]->textureHandle);
+                    renderer.frameGraph->GetResource("viewspace_normal")->textureHandle);
 
                 debugTextures.push_back(ImGui_ImplVulkan_AddTexture(sampler,
                                                                     viewspaceNormal->imageView,
-                                                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+                                                                    MongooseVK::ImageUtils::GetShaderReadLayoutFromFormat(viewspaceNormal->createInfo.format)));
             }
 
             // Viewspace Position
             {
                 auto viewspacePosition = MongooseVK::VulkanDevice::Get()->GetTexture(
-                    renderer.frameGraph->renderPassResourceMap["viewspace_position"]->textureHandle);
+                    renderer.frameGraph->GetResource("viewspace_position")->textureHandle);
 
                 debugTextures.push_back(ImGui_ImplVulkan_AddTexture(sampler,
                                                                     viewspacePosition->imageView,
-                                                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+                                                                    MongooseVK::ImageUtils::GetShaderReadLayoutFromFormat(viewspacePosition->createInfo.format)));
             }
 
 
             // Depth map
             {
                 auto depthMap = MongooseVK::VulkanDevice::Get()->GetTexture(
-                    renderer.frameGraph->renderPassResourceMap["depth_map"]->textureHandle);
+                    renderer.frameGraph->GetResource("depth_map")->textureHandle);
 
                 debugTextures.push_back(ImGui_ImplVulkan_AddTexture(depthSampler,
                                                                     depthMap->imageView,
-                                                                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL));
+                                                                    MongooseVK::ImageUtils::GetShaderReadLayoutFromFormat(depthMap->createInfo.format)));
             }
 
             // SSAO
             {
                 auto ssao = MongooseVK::VulkanDevice::Get()->GetTexture(
-                    renderer.frameGraph->renderPassResourceMap["ssao_texture"]->textureHandle);
+                    renderer.frameGraph->GetResource("ssao_texture")->textureHandle);
 
                 debugTextures.push_back(ImGui_ImplVulkan_AddTexture(sampler,
                                                                     ssao->imageView,
-                                                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+                                                                    MongooseVK::ImageUtils::GetShaderReadLayoutFromFormat(ssao->createInfo.format)));
             }
         }
 
@@ -152,8 +292,14 @@ namespace VulkanDemo
             return "GBuffer Viewer";
         }
 
+        virtual void OnOpen() override { renderer.frameGraph->SetDebugViewEnabled("GBufferViewer", true); }
+        virtual void OnClose() override { renderer.frameGraph->SetDebugViewEnabled("GBufferViewer", false); }
+
         virtual void Draw() override
         {
+            // The frame graph only keeps the textures for the UI once it has been compiled with the debug view
+            if (renderer.frameGraph->IsCompilePending()) return;
+
             Init();
 
             const ImVec2 availableSpace = ImGui::GetContentRegionAvail();
@@ -221,13 +367,13 @@ namespace VulkanDemo
             }
 
             MongooseVK::VulkanTexture* shadowMap = MongooseVK::VulkanDevice::Get()->GetTexture(
-                renderer.frameGraph->renderPassResourceMap["directional_shadow_map"]->textureHandle);
+                renderer.frameGraph->GetResource("directional_shadow_map")->textureHandle);
             if (shadowMap->GetImage())
             {
                 for (size_t i = 0; i < MongooseVK::SHADOW_MAP_CASCADE_COUNT; i++)
                 {
                     shadowMapAttachments.push_back(ImGui_ImplVulkan_AddTexture(sampler, shadowMap->GetImageView(i),
-                                                                               VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL));
+                                                                               MongooseVK::ImageUtils::GetShaderReadLayoutFromFormat(shadowMap->createInfo.format)));
                 }
             }
         }
@@ -237,8 +383,14 @@ namespace VulkanDemo
             return "Shadow Map Viewer";
         }
 
+        virtual void OnOpen() override { renderer.frameGraph->SetDebugViewEnabled("ShadowMapViewer", true); }
+        virtual void OnClose() override { renderer.frameGraph->SetDebugViewEnabled("ShadowMapViewer", false); }
+
         virtual void Draw() override
         {
+            // The frame graph only keeps the textures for the UI once it has been compiled with the debug view
+            if (renderer.frameGraph->IsCompilePending()) return;
+
             Init();
 
             const ImVec2 availableSpace = ImGui::GetContentRegionAvail();
@@ -281,10 +433,88 @@ namespace VulkanDemo
             MongooseVK::ImGuiUtils::DrawFloatControl("Intensity", light->intensity, 0.0f, 100.0f, 0.01f, 150.0f);
             MongooseVK::ImGuiUtils::DrawFloatControl("Ambient Intensity", light->ambientIntensity, 0.0f, 100.0f, 0.01f, 150.0f);
             MongooseVK::ImGuiUtils::DrawFloatControl("Cascade split lambda", light->cascadeSplitLambda, 0.01f, 10.0f, 0.01f, 150.0f);
+
+            ImGui::Separator();
+
+            MongooseVK::SceneGraph* sceneGraph = renderer.GetSceneGraph();
+            if (!sceneGraph) return;
+
+            // Timed by the GPU profiler scope the frame graph records around every pass
+            const MongooseVK::GpuScopeStats* binningStats = MongooseVK::VulkanDevice::Get()->GetGpuProfiler().GetScopeStats("LightClusteringPass");
+
+            ImGui::Text("Point lights: %zu, spot lights: %zu", sceneGraph->pointLights.size(), sceneGraph->spotLights.size());
+            ImGui::Text("Light binning: %.3f ms", binningStats ? binningStats->lastTime : 0.0f);
+
+            MongooseVK::ImGuiUtils::DrawIntControl("Scatter count", scatterCount, 1, 1024, 150.0f);
+            MongooseVK::ImGuiUtils::DrawFloatControl("Scatter extent", scatterExtent, 1.0f, 100.0f, 0.1f, 150.0f);
+            MongooseVK::ImGuiUtils::DrawFloatControl("Light radius", scatterRadius, 0.1f, 50.0f, 0.1f, 150.0f);
+
+            if (ImGui::Button("Add point lights"))
+                ScatterPointLights(*sceneGraph);
+
+            ImGui::SameLine();
+            if (ImGui::Button("Add spot lights"))
+                ScatterSpotLights(*sceneGraph);
+
+            ImGui::SameLine();
+            if (ImGui::Button("Clear"))
+            {
+                sceneGraph->pointLights.clear();
+                sceneGraph->spotLights.clear();
+            }
+        }
+
+    private:
+        void ScatterPointLights(MongooseVK::SceneGraph& sceneGraph)
+        {
+            for (int i = 0; i < scatterCount; i++)
+            {
+                MongooseVK::PointLight pointLight{};
+                pointLight.position = RandomPosition();
+                pointLight.color = RandomColor();
+                pointLight.attenuationRadius = scatterRadius;
+
+                sceneGraph.pointLights.push_back(pointLight);
+            }
+        }
+
+        void ScatterSpotLights(MongooseVK::SceneGraph& sceneGraph)
+        {
+            std::uniform_real_distribution<float> tilt(-0.5f, 0.5f);
+
+            for (int i = 0; i < scatterCount; i++)
+            {
+                MongooseVK::SpotLight spotLight{};
+                spotLight.position = RandomPosition();
+                spotLight.color = RandomColor();
+                spotLight.attenuationRadius = scatterRadius;
+                spotLight.direction = glm::normalize(glm::vec3(tilt(random), -1.0f, tilt(random)));
+
+                sceneGraph.spotLights.push_back(spotLight);
+            }
+        }
+
+        glm::vec3 RandomPosition()
+        {
+            std::uniform_real_distribution<float> horizontal(-scatterExtent, scatterExtent);
+            std::uniform_real_distribution<float> vertical(0.0f, scatterExtent * 0.25f);
+
+            return {horizontal(random), vertical(random), horizontal(random)};
+        }
+
+        glm::vec3 RandomColor()
+        {
+            std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+            return {channel(random), channel(random), channel(random)};
         }
 
     private:
         MongooseVK::DirectionalLight* light;
+
+        std::mt19937 random{std::random_device{}()};
+        int scatterCount = 64;
+        float scatterExtent = 20.0f;
+        float scatterRadius = 4.0f;
     };
 
     class PostProcessingWindow final : MongooseVK::ImGuiWindow {
@@ -299,8 +529,8 @@ namespace VulkanDemo
 
         virtual void Draw() override
         {
-            const auto ssaoPass = static_cast<MongooseVK::SSAOPass*>(renderer.frameGraph->renderPasses["SSAOPass"]);
-            const auto toneMappingPass = static_cast<MongooseVK::ToneMappingPass*>(renderer.frameGraph->renderPasses["ToneMappingPass"]);
+            const auto ssaoPass = renderer.frameGraph->GetPass<MongooseVK::SSAOPass>("SSAOPass");
+            const auto toneMappingPass = renderer.frameGraph->GetPass<MongooseVK::ToneMappingPass>("ToneMappingPass");
 
             MongooseVK::ImGuiUtils::DrawFloatControl("SSAO Strength", ssaoPass->ssaoParams.strength, 0.01f, 10.0f,
                                                      0.01f, 150.0f);
@@ -330,7 +560,12 @@ namespace VulkanDemo
 
         virtual void Draw() override
         {
-            const auto gridPass = static_cast<MongooseVK::InfiniteGridPass*>(renderer.frameGraph->renderPasses["InfiniteGridPass"]);
+            const auto gridPass = renderer.frameGraph->GetPass<MongooseVK::InfiniteGridPass>("InfiniteGridPass");
+
+            // A disabled pass is left out of the frame graph schedule entirely
+            bool gridEnabled = renderer.frameGraph->IsPassEnabled("InfiniteGridPass");
+            if (ImGui::Checkbox("Enabled", &gridEnabled))
+                renderer.frameGraph->SetPassEnabled("InfiniteGridPass", gridEnabled);
 
             MongooseVK::ImGuiUtils::DrawFloatControl("Grid size", gridPass->gridParams.gridSize, 0.1f, 1000.0f, 0.1f, 150.0f);
             MongooseVK::ImGuiUtils::DrawFloatControl("Cell size", gridPass->gridParams.gridCellSize, 0.01f, 10.0f, 0.01f, 150.0f);
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+#include "util/job_system.h"
+#include "util/log.h"
+
+// Runs the same fork/join workloads on the old ThreadPool and on the JobSystem for 1 to 64 threads. Both get the
+// same number of threads executing jobs: the pool's workers, or the job system's workers and the thread waiting.
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static constexpr uint32_t BENCH_RUNS = 5;
+        static constexpr uint32_t BENCH_THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+
+        struct Workload {
+            const char* name;
+            uint32_t batches;      // Joined one after the other, like the passes of consecutive frames
+            uint32_t jobsPerBatch;
+            uint32_t workPerJob;   // Iterations of the busy loop
+        };
+
+        static constexpr Workload BENCH_WORKLOADS[] = {
+            {"empty jobs", 1, 100000, 0},
+            {"small jobs", 1, 20000, 2000},
+            {"frames", 200, 16, 20000},
+        };
+
+        static std::atomic<uint64_t> sink = 0;
+
+        // Stands in for the work of a job, the result is kept so it isn't optimized out
+        static void Work(const uint32_t iterations)
+        {
+            uint64_t value = iterations;
+            for (uint32_t i = 0; i < iterations; i++)
+                value = value * 6364136223846793005ull + 1442695040888963407ull;
+
+            sink.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        // Median of the runs in milliseconds
+        static double Measure(const std::function<void()>& run)
+        {
+            std::vector<double> times;
+            for (uint32_t i = 0; i < BENCH_RUNS; i++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                run();
+                times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            std::ranges::sort(times);
+            return times[times.size() / 2];
+        }
+
+        static double RunThreadPool(const Workload& workload, const uint32_t threadCount)
+        {
+            ThreadPool* threadPool = ThreadPool::Create(threadCount);
+
+            const double time = Measure([&] {
+                for (uint32_t batch = 0; batch < workload.batches; batch++)
+                {
+                    std::atomic<uint32_t> pending = workload.jobsPerBatch;
+                    for (uint32_t i = 0; i < workload.jobsPerBatch; i++)
+                    {
+                        threadPool->enqueue([&pending, &workload] {
+                            Work(workload.workPerJob);
+                            pending.fetch_sub(1, std::memory_order_release);
+                        });
+                    }
+
+                    while (pending.load(std::memory_order_acquire) > 0)
+                        std::this_thread::yield();
+                }
+            });
+
+            ThreadPool::Destroy();
+            return time;
+        }
+
+        static double RunJobSystem(const Workload& workload, const uint32_t threadCount)
+        {
+            JobSystem* jobSystem = JobSystem::Create(threadCount - 1);
+
+            const double time = Measure([&] {
+                for (uint32_t batch = 0; batch < workload.batches; batch++)
+                {
+                    JobCounter counter;
+                    for (uint32_t i = 0; i < workload.jobsPerBatch; i++)
+                        jobSystem->Run([&workload] { Work(workload.workPerJob); }, &counter);
+
+                    jobSystem->Wait(counter);
+                }
+            });
+
+            JobSystem::Destroy();
+            return time;
+        }
+    }
+}
+
+int main()
+{
+    using namespace MongooseVK;
+
+    Log::Init();
+
+    std::printf("Hardware threads: %u, median of %u runs in ms\n\n", std::thread::hardware_concurrency(), Utils::BENCH_RUNS);
+
+    for (const Utils::Workload& workload: Utils::BENCH_WORKLOADS)
+    {
+        std::printf("%s: %u x %u jobs, %u iterations each\n", workload.name, workload.batches, workload.jobsPerBatch,
+                    workload.workPerJob);
+        std::printf("%8s %12s %12s %8s\n", "threads", "ThreadPool", "JobSystem", "speedup");
+
+        for (const uint32_t threadCount: Utils::BENCH_THREAD_COUNTS)
+        {
+            const double threadPoolTime = Utils::RunThreadPool(workload, threadCount);
+            const double jobSystemTime = Utils::RunJobSystem(workload, threadCount);
+
+            std::printf("%8u %12.2f %12.2f %7.2fx\n", threadCount, threadPoolTime, jobSystemTime, threadPoolTime / jobSystemTime);
+        }
+
+        std::printf("\n");
+    }
+
+    return 0;
+}
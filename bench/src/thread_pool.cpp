@@ -1,8 +1,9 @@
-#include "util/thread_pool.h"
+#include "thread_pool.h"
 
 namespace MongooseVK
 {
     ThreadPool* ThreadPool::instance = nullptr;
+    thread_local size_t ThreadPool::workerIndex_ = INVALID_WORKER_INDEX;
 
     void ThreadPool::enqueue(std::function<void()> task)
     { {
@@ -20,7 +21,9 @@ namespace MongooseVK
         // Creating worker threads
         for (size_t i = 0; i < num_threads; ++i)
         {
-            threads_.emplace_back([this] {
+            threads_.emplace_back([this, i] {
+                workerIndex_ = i;
+
                 while (true)
                 {
                     std::function<void()> task;
@@ -0,0 +1,91 @@
+#pragma once
+
+// Source: https://www.geeksforgeeks.org/cpp/thread-pool-in-cpp/
+// The engine's thread pool before the job system replaced it, only kept as the baseline of the benchmark
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include "util/core.h"
+
+namespace MongooseVK
+{
+    class ThreadPool {
+    public:
+        static ThreadPool* Create(size_t num_threads = std::thread::hardware_concurrency()) { return new ThreadPool(num_threads); }
+        static ThreadPool* Get() { return instance; }
+        static void Destroy()
+        {
+            delete instance;
+            instance = nullptr;
+        }
+
+        // Enqueue task for execution by the thread pool
+        void enqueue(std::function<void()> task);
+
+        // Enqueue task and return a future holding its result
+        template<typename F>
+        auto submit(F&& task) -> std::future<std::invoke_result_t<F>>
+        {
+            using Result = std::invoke_result_t<F>;
+
+            auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> future = packagedTask->get_future();
+            enqueue([packagedTask] { (*packagedTask)(); });
+
+            return future;
+        }
+
+        // Runs the task on the pool when there is one, otherwise lazily on the thread calling get()
+        template<typename F>
+        static auto Async(F&& task) -> std::future<std::invoke_result_t<F>>
+        {
+            if (instance) return instance->submit(std::forward<F>(task));
+
+            return std::async(std::launch::deferred, std::forward<F>(task));
+        }
+
+        size_t GetThreadCount() const { return threads_.size(); }
+
+        // Index of the calling worker in [0, GetThreadCount()), every thread outside of the pool gets
+        // GetThreadCount(). Lets workers pick per thread resources without locking.
+        size_t GetThreadIndex() const { return workerIndex_ == INVALID_WORKER_INDEX ? threads_.size() : workerIndex_; }
+
+    private:
+        // // Constructor to creates a thread pool with given
+        // number of threads
+        explicit ThreadPool(const size_t num_threads = std::thread::hardware_concurrency());
+
+
+        // Destructor to stop the thread pool
+        ~ThreadPool();
+
+    private:
+        static ThreadPool* instance;
+
+        static constexpr size_t INVALID_WORKER_INDEX = SIZE_MAX;
+        static thread_local size_t workerIndex_;
+
+        // Vector to store worker threads
+        std::vector<std::thread> threads_;
+
+        // Queue of tasks
+        std::queue<std::function<void()>> tasks_;
+
+        // Mutex to synchronize access to shared data
+        std::mutex queue_mutex_;
+
+        // Condition variable to signal changes in the state of
+        // the tasks queue
+        std::condition_variable cv_;
+
+        // Flag to indicate whether the thread pool should stop
+        // or not
+        bool stop_ = false;
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <map>
+
+namespace MongooseVK
+{
+    constexpr uint64_t INVALID_ALLOCATION_OFFSET = UINT64_MAX;
+
+    // Offset allocator over a linear range, the range itself is owned by the caller (e.g. a GPU buffer).
+    // Free blocks are kept sorted by offset so releases coalesce with their neighbours.
+    class FreeListAllocator {
+    public:
+        void Init(uint64_t _capacity);
+        void Grow(uint64_t newCapacity);
+        void Reset();
+
+        uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+        void Free(uint64_t offset, uint64_t size);
+
+        uint64_t GetCapacity() const { return capacity; }
+        uint64_t GetUsed() const { return used; }
+        uint64_t GetLargestFreeBlock() const;
+        uint32_t GetFreeBlockCount() const { return static_cast<uint32_t>(freeBlocks.size()); }
+
+        // 0 when all free space is one block, approaching 1 as it is split into small holes
+        float GetFragmentation() const;
+
+    private:
+        void InsertFreeBlock(uint64_t offset, uint64_t size);
+
+    private:
+        uint64_t capacity = 0;
+        uint64_t used = 0;
+
+        std::map<uint64_t, uint64_t> freeBlocks; // offset -> size
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace MongooseVK
+{
+    // Bump allocator for memory that lives until a known point, e.g. the frame that allocated it being done on
+    // the GPU. Allocating is an atomic add so jobs can share an arena, Reset frees everything at once. Requests
+    // that do not fit go to the heap and are freed on Reset as well.
+    class LinearArena {
+    public:
+        explicit LinearArena(size_t _capacity);
+        ~LinearArena();
+
+        LinearArena(const LinearArena&) = delete;
+        LinearArena& operator=(const LinearArena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // Nothing allocated here gets its destructor called
+        template<typename T>
+        T* Allocate(const size_t count = 1)
+        {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        template<typename T>
+        std::span<T> Copy(std::initializer_list<T> values)
+        {
+            T* data = Allocate<T>(values.size());
+            std::uninitialized_copy(values.begin(), values.end(), data);
+            return {data, values.size()};
+        }
+
+        void Reset();
+
+        size_t GetCapacity() const { return capacity; }
+        size_t GetUsed() const { return offset.load(std::memory_order_relaxed); }
+        size_t GetPeakUsed() const { return peakUsed; }
+
+        // Heap allocations made before the last Reset, stays 0 while the capacity is large enough
+        uint32_t GetLastOverflowCount() const { return lastOverflowCount; }
+
+    private:
+        std::byte* memory = nullptr;
+        size_t capacity = 0;
+        std::atomic<size_t> offset = 0;
+        size_t peakUsed = 0;
+        uint32_t lastOverflowCount = 0;
+
+        struct OverflowAllocation {
+            void* memory;
+            std::align_val_t alignment;
+        };
+
+        std::mutex overflowMutex;
+        std::vector<OverflowAllocation> overflowAllocations{};
+    };
+
+    // Standard allocator handing out arena memory, deallocating is a no-op until the arena is reset
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        ArenaAllocator(LinearArena& _arena): arena(&_arena) {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {}
+
+        T* allocate(const size_t count) { return arena->Allocate<T>(count); }
+        void deallocate(T*, size_t) {}
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+    private:
+        template<typename U>
+        friend class ArenaAllocator;
+
+        LinearArena* arena;
+    };
+
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <unordered_set>
 #include <vulkan/vulkan_core.h>
 #include "renderer/scene.h"
 #include "renderer/vulkan/vulkan_renderpass.h"
@@ -14,21 +15,25 @@ namespace MongooseVK
         class FrameGraphRenderPass;
 
         typedef uint32_t FrameGraphHandle;
+        constexpr FrameGraphHandle INVALID_FRAME_GRAPH_HANDLE = UINT32_MAX;
 
+        // Dense indices resolved by Compile, valid until the next one
         struct FrameGraphResourceHandle {
-            FrameGraphHandle index;
+            FrameGraphHandle index = INVALID_FRAME_GRAPH_HANDLE;
         };
 
         struct FrameGraphNodeHandle {
-            FrameGraphHandle index;
+            FrameGraphHandle index = INVALID_FRAME_GRAPH_HANDLE;
         };
 
         struct ResourceUsage {
             enum class Access { Read, Write, ReadWrite };
 
-            enum class Type { Texture, Buffer };
+            // Virtual resources own no memory and get no barriers, they only order passes that communicate
+            // through memory outside of the graph
+            enum class Type { Texture, Buffer, Virtual };
 
-            enum class Usage { Sampled, Storage, ColorAttachment, DepthStencil, UniformBuffer };
+            enum class Usage { Sampled, Storage, ColorAttachment, DepthStencil, UniformBuffer, TransferSource };
 
             Access access;
             Type type;
@@ -95,17 +100,77 @@ namespace MongooseVK
             ExecuteFunc execute;
         };
 
+        struct FrameGraphResourceAccess {
+            FrameGraphRenderPass* renderPass = nullptr;
+            ResourceUsage::Access access = ResourceUsage::Access::Read;
+        };
+
         struct FrameGraphResource : PoolObject {
             const char* name;
             ResourceUsage::Type type;
             AllocatedBuffer allocatedBuffer;
+            FrameGraphBufferCreateInfo bufferInfo{};
+
+            // Bound with an offset rewritten every frame before Execute. Uniforms are suballocated from the uniform
+            // ring, host written storage buffers keep a region per frame in flight.
+            bool dynamicBinding = false;
+            uint32_t dynamicOffset = 0;
 
             TextureHandle textureHandle = INVALID_TEXTURE_HANDLE;
             TextureCreateInfo textureInfo{};
 
-            FrameGraphPassBase* producer;
-            FrameGraphPassBase* lastWriter;
-            uint32_t refCount = 0;
+            FrameGraphResourceHandle handle{};
+
+            // Filled in by the schedule, only enabled passes count
+            FrameGraphRenderPass* producer = nullptr;   // First writer of the frame
+            FrameGraphRenderPass* lastWriter = nullptr; // Writer of the version the exports and the next frame see
+            uint32_t refCount = 0;                      // Scheduled passes reading the resource
+
+            // Inputs and outputs in declaration order. A read sees the version of the last write declared before
+            // it, reads declared before any write see the contents of the previous frame.
+            std::vector<FrameGraphResourceAccess> accesses{};
+        };
+
+        // Every barrier needed before a pass, recorded with a single vkCmdPipelineBarrier2
+        struct BarrierBatch {
+            std::vector<VkImageMemoryBarrier2> imageBarriers{};
+            std::vector<VkBufferMemoryBarrier2> bufferBarriers{};
+
+            void Record(VkCommandBuffer cmd) const;
+        };
+
+        // Records a pass into secondary command buffers on whichever thread runs it. Render pass instances can only
+        // be begun in the primary command buffer, so the pass is split into a segment per instance and the segments
+        // in between, Execute replays them in order.
+        class FrameGraphCommandRecorder {
+        public:
+            void Record(VulkanDevice* device, FrameGraphRenderPass* renderPass, SceneGraph* scene);
+            void Execute(VkCommandBuffer cmd) const;
+
+            // Called by the pass being recorded, both return the command buffer to continue in
+            VkCommandBuffer BeginRenderPass(VulkanRenderPass* renderPass, const VulkanFramebuffer* framebuffer);
+            VkCommandBuffer EndRenderPass();
+
+        private:
+            struct Segment {
+                VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+                VulkanRenderPass* renderPass = nullptr; // Set for the contents of a render pass instance
+                const VulkanFramebuffer* framebuffer = nullptr;
+            };
+
+            VkCommandBuffer BeginSegment(VulkanRenderPass* renderPass, const VulkanFramebuffer* framebuffer);
+            void EndSegment() const;
+
+        private:
+            VulkanDevice* device = nullptr;
+            std::vector<Segment> segments{};
+        };
+
+        // One scheduled pass, Execute walks these in order
+        struct FrameGraphExecutionStep {
+            FrameGraphRenderPass* renderPass = nullptr;
+            BarrierBatch barriers{};             // Recorded right before the pass
+            FrameGraphCommandRecorder commands{}; // Rerecorded every frame
         };
 
         class PassBuilder {
@@ -148,11 +213,18 @@ namespace MongooseVK
             void Resize(VkExtent2D newResolution);
             void Cleanup();
 
+            // Layout scene geometry passes build their pipelines for, takes effect on the next Compile
+            void SetVertexFormat(const VertexFormat& format) { vertexFormat = format; }
+
             template<typename T>
             void AddRenderPass(const char* name)
             {
                 renderPasses[name] = new T(device, resolution);
-                renderPassList.push_back(renderPasses[name]);
+                renderPasses[name]->SetName(name);
+                renderPasses[name]->SetVertexFormat(vertexFormat);
+                renderPasses[name]->SetGraphSynchronized(true);
+                renderPasses[name]->SetNodeHandle({static_cast<FrameGraphHandle>(registeredPasses.size())});
+                registeredPasses.push_back(renderPasses[name]);
             }
 
             template<typename T, typename SetupFunc, typename ExecuteFunc>
@@ -176,14 +248,45 @@ namespace MongooseVK
             }
 
             void AddExternalResource(const char* name, FrameGraphResource* resource);
-            FrameGraphResource* GetResource(const char* name);
 
-        private:
-            FrameGraphResourceHandle CreateTextureResource(const char* resourceName, TextureCreateInfo& createInfo);
-            FrameGraphResourceHandle CreateBufferResource(const char* resourceName, FrameGraphBufferCreateInfo& createInfo);
+            // Name lookups are meant for setup and debugging and throw for unknown names, per frame code keeps
+            // the handles
+            FrameGraphResourceHandle GetResourceHandle(const char* name) const;
+            FrameGraphResource* GetResource(const char* name) const;
+            FrameGraphResource* GetResource(const FrameGraphResourceHandle handle) const { return resources[handle.index]; }
 
+            FrameGraphNodeHandle GetPassHandle(const char* name) const;
+            FrameGraphRenderPass* GetPass(const char* name) const;
+            FrameGraphRenderPass* GetPass(const FrameGraphNodeHandle handle) const { return registeredPasses[handle.index]; }
+
+            template<typename T>
+            T* GetPass(const char* name) const
+            {
+                return static_cast<T*>(GetPass(name));
+            }
+
+            // Leaves the resource ready for a use outside of the graph once the last pass is done
+            void ExportResource(FrameGraphResource* resource, ResourceUsage usage);
+
+            // Disabled passes are left out of the schedule along with every pass only they depend on. Readers of
+            // their outputs see the previous version, or undefined contents for textures sharing memory. Takes
+            // effect on the next Execute, resources are kept.
+            void SetPassEnabled(const char* name, bool enabled);
+            bool IsPassEnabled(const char* name) const;
+
+            // Debug views make the UI pass read the textures they show. The reads decide how long the textures have
+            // to keep their memory, so the graph has to be compiled again, with Resize, before they take effect.
+            void SetDebugViewEnabled(const char* name, bool enabled);
+            bool IsDebugViewEnabled(const char* name) const;
+            bool IsCompilePending() const { return compilePending; }
+
+        private:
+            void RegisterResource(const std::string& name, FrameGraphResource* resource);
             void DestroyResources();
             void InitializeRenderPasses();
+            void BuildSchedule();
+            void CreateTextures();
+            void BuildBarriers();
             void CreateFrameGraphOutputs();
             RenderPassHandle CreateRenderPass(const std::vector<std::pair<FrameGraphResource*, ResourceUsage>>& outputs);
             PipelineHandle CreatePipeline(PipelineCreateInfo pipelineCreate, RenderPassHandle renderPassHandle,
@@ -193,15 +296,9 @@ namespace MongooseVK
 
             void CreateFrameGraphTextureResource(const char* resourceName, const TextureCreateInfo& createInfo);
             void CreateFrameGraphBufferResource(const char* resourceName, FrameGraphBufferCreateInfo& createInfo);
+            void CreateFrameGraphVirtualResource(const char* resourceName);
 
         public:
-            std::vector<FrameGraphRenderPass*> renderPassList{};
-            std::unordered_map<std::string, FrameGraphRenderPass*> renderPasses;
-            std::unordered_map<std::string, FrameGraphResourceHandle> resourceHandles;
-
-            std::unordered_map<std::string, FrameGraphResource*> renderPassResourceMap;
-            std::unordered_map<std::string, FrameGraphResource*> externalResources;
-
             std::unordered_map<std::string, RenderPassContext> renderContextMap;
 
             std::vector<Scope<FrameGraphPassBase>> passes;
@@ -209,8 +306,37 @@ namespace MongooseVK
         private:
             VulkanDevice* device;
             VkExtent2D resolution;
+            VertexFormat vertexFormat{};
 
             ObjectResourcePool<FrameGraphResource> resourcePool;
+
+            std::unordered_map<std::string, FrameGraphRenderPass*> renderPasses;
+            std::unordered_map<std::string, FrameGraphResource*> renderPassResourceMap;
+            std::unordered_map<std::string, FrameGraphResource*> externalResources;
+
+            std::unordered_map<std::string, FrameGraphResourceHandle> resourceHandles;
+            std::vector<FrameGraphResource*> resources{}; // Indexed by handle, external resources included
+
+            std::vector<FrameGraphRenderPass*> registeredPasses{}; // AddRenderPass order, only breaks ties in the schedule
+            std::vector<FrameGraphRenderPass*> passOrder{};        // Every registered pass, the plan is a subsequence
+            std::unordered_set<std::string> disabledPasses{};      // Kept across Compile
+            bool scheduleDirty = false;
+
+            std::unordered_set<std::string> debugViews{}; // Kept across Compile
+            bool compilePending = false;
+
+            std::vector<std::pair<FrameGraphResource*, ResourceUsage>> exportedResources{};
+            std::vector<FrameGraphExecutionStep> executionPlan{}; // Culled and disabled passes are left out
+            BarrierBatch exportBarriers{};
+            BarrierBatch initialBarriers{}; // Moves the textures into the layouts a frame of a new schedule starts with
+
+            // Layout every texture was left in by the last schedule
+            std::unordered_map<const FrameGraphResource*, VkImageLayout> resourceLayouts{};
+
+            // Textures used in disjoint parts of the pass order share these, each texture lists the ones it
+            // overlaps in memory
+            std::vector<VmaAllocation> transientAllocations{};
+            std::unordered_map<const FrameGraphResource*, std::vector<const FrameGraphResource*>> aliasedResources{};
         };
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <renderer/scene.h>
 #include <renderer/vulkan/vulkan_device.h>
+#include <util/profiler.h>
 
 #include "frame_graph.h"
 
@@ -20,9 +21,41 @@ namespace MongooseVK
 
             VulkanRenderPass* GetRenderPass() const;
 
+            // Render passes are begun and ended through these. Inside the frame graph the pass is recorded as a job
+            // and every render pass instance gets its own secondary command buffer, so the returned
+            // command buffer is the one to record into until the next call.
+            VkCommandBuffer BeginRenderPass(VkCommandBuffer commandBuffer, const VulkanFramebuffer* framebuffer);
+            VkCommandBuffer EndRenderPass(VkCommandBuffer commandBuffer);
+
+            // Set by the frame graph while it records the pass
+            void SetCommandRecorder(FrameGraphCommandRecorder* recorder) { commandRecorder = recorder; }
+
+            void SetVertexFormat(const VertexFormat& format) { vertexFormat = format; }
+
+            void SetName(const std::string& _name)
+            {
+                name = _name;
+                profileName = Profiler::InternName(name);
+            }
+
+            const std::string& GetName() const { return name; }
+            const char* GetProfileName() const { return profileName; } // Outlives the pass, for profiler zones and GPU scopes
+
+            // Set by the frame graph, which then owns every layout transition and barrier around the pass
+            void SetGraphSynchronized(const bool synchronized) { graphSynchronized = synchronized; }
+
+            void SetNodeHandle(const FrameGraphNodeHandle handle) { nodeHandle = handle; }
+            FrameGraphNodeHandle GetNodeHandle() const { return nodeHandle; }
+
             void AddInput(FrameGraphResource* input);
             void AddOutput(FrameGraphResource* output, ResourceUsage usage);
 
+            const std::vector<FrameGraphResource*>& GetInputs() const { return inputs; }
+            const std::vector<std::pair<FrameGraphResource*, ResourceUsage>>& GetOutputs() const { return outputs; }
+
+            // Stages the inputs are read and the storage outputs are accessed in
+            VkPipelineStageFlags2 GetShaderStages() const { return shaderStages; }
+
         protected:
             virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) = 0;
 
@@ -31,9 +64,23 @@ namespace MongooseVK
             virtual void CreateDescriptors();
             virtual void CreateFramebuffer();
 
+            // Whole buffer, or a single allocation for uniforms living in the uniform ring
+            static VkDescriptorBufferInfo GetDescriptorBufferInfo(const FrameGraphResource* resource);
+
+            // Offsets of this frame for the dynamic uniform inputs in binding order, in the frame arena
+            std::span<const uint32_t> GetDynamicOffsets() const;
+
         protected:
             VulkanDevice* device;
             VkExtent2D resolution;
+            std::string name{};
+            const char* profileName = "Unnamed pass";
+            VertexFormat vertexFormat{};
+
+            bool graphSynchronized = false;
+            FrameGraphCommandRecorder* commandRecorder = nullptr;
+            FrameGraphNodeHandle nodeHandle{};
+            VkPipelineStageFlags2 shaderStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
 
             PipelineHandle pipelineHandle = INVALID_PIPELINE_HANDLE;
             RenderPassHandle renderPassHandle = INVALID_RENDER_PASS_HANDLE;
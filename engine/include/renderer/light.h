@@ -40,6 +40,16 @@ namespace MongooseVK
 
     constexpr size_t SHADOW_MAP_CASCADE_COUNT = 4;
 
+    // View space froxel grid the point and spot lights are binned into, the depth slices are exponential
+    constexpr uint32_t LIGHT_CLUSTER_COUNT_X = 16;
+    constexpr uint32_t LIGHT_CLUSTER_COUNT_Y = 9;
+    constexpr uint32_t LIGHT_CLUSTER_COUNT_Z = 24;
+    constexpr uint32_t LIGHT_CLUSTER_COUNT = LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y * LIGHT_CLUSTER_COUNT_Z;
+
+    // Shared index list capacity, an average of 64 lights per cluster
+    constexpr uint32_t LIGHT_CLUSTER_INDEX_CAPACITY = LIGHT_CLUSTER_COUNT * 64;
+    constexpr uint32_t MAX_SCENE_LIGHTS = 8192;
+
     struct DirectionalLight : Light {
         glm::vec3 direction = normalize(glm::vec3(0.0f, -1.0f, 0.0f));
         glm::vec3 center = glm::vec3(0.0f);
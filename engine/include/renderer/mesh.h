@@ -1,6 +1,9 @@
 ﻿#pragma once
 
 #include <array>
+#include <limits>
+#include <span>
+#include <string>
 #include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -34,6 +37,66 @@ namespace MongooseVK
         }
     };
 
+    constexpr uint32_t MAX_VERTEX_STREAMS = 3;
+    constexpr uint32_t VERTEX_FORMAT_COUNT = 8;
+
+    // Layout meshes are uploaded with, chosen when a scene is loaded. Loaders always produce Vertex, it is
+    // encoded into the selected layout on upload.
+    // Standard: one interleaved Vertex stream.
+    // Packed: a position stream, so depth only passes fetch nothing else, a 12 byte attribute stream with
+    // octahedral normal and tangent plus half float UVs, and an optional RGBA8 color stream.
+    struct VertexFormat {
+        bool packed = false;
+        bool quantizedPosition = false; // unorm16 positions relative to the meshlet bounds, packed only
+        bool vertexColor = false;       // Packed only, vertices decode to white without it
+
+        bool operator==(const VertexFormat& other) const = default;
+
+        uint32_t GetIndex() const;
+        uint32_t GetStreamCount() const;
+        uint32_t GetStreamStride(uint32_t stream) const;
+        uint32_t GetVertexSize() const;
+
+        // Matching defines for shader/glsl/includes/vertex_input.glslh
+        std::vector<std::string> GetShaderDefines() const;
+    };
+
+    struct QuantizedPosition {
+        uint16_t x = 0;
+        uint16_t y = 0;
+        uint16_t z = 0;
+        uint16_t padding = 0;
+    };
+
+    struct PackedVertexAttributes {
+        uint32_t normal = 0;   // Octahedral snorm16x2
+        uint32_t tangent = 0;  // Octahedral unorm15x2, bit 31 set when the bitangent is flipped
+        uint32_t texCoord = 0; // half2
+    };
+
+    struct BoundingBox {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+        void Expand(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 GetExtent() const { return (max - min) * 0.5f; }
+
+        static BoundingBox FromVertices(const std::span<const Vertex> vertices)
+        {
+            BoundingBox bounds{};
+            for (const Vertex& vertex: vertices)
+                bounds.Expand(vertex.pos);
+
+            return bounds;
+        }
+    };
+
     struct VulkanVertex : Vertex {
         static VkVertexInputBindingDescription GetBindingDescription()
         {
@@ -88,8 +151,76 @@ namespace MongooseVK
 
             return attributeDescriptions;
         }
+
+        static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(const VertexFormat& format)
+        {
+            if (!format.packed) return {GetBindingDescription()};
+
+            std::vector<VkVertexInputBindingDescription> bindingDescriptions(format.GetStreamCount());
+            for (uint32_t stream = 0; stream < bindingDescriptions.size(); stream++)
+            {
+                bindingDescriptions[stream].binding = stream;
+                bindingDescriptions[stream].stride = format.GetStreamStride(stream);
+                bindingDescriptions[stream].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            }
+
+            return bindingDescriptions;
+        }
+
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(const VertexFormat& format)
+        {
+            if (!format.packed)
+            {
+                const auto attributeDescriptions = GetAttributeDescriptions();
+                return {attributeDescriptions.begin(), attributeDescriptions.end()};
+            }
+
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions(format.vertexColor ? 5 : 4);
+
+            // Vertex position
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = format.quantizedPosition ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[0].offset = 0;
+
+            // Vertex normal
+            attributeDescriptions[1].binding = 1;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(PackedVertexAttributes, normal);
+
+            // Vertex tangent, decoded in the shader
+            attributeDescriptions[2].binding = 1;
+            attributeDescriptions[2].location = 2;
+            attributeDescriptions[2].format = VK_FORMAT_R32_UINT;
+            attributeDescriptions[2].offset = offsetof(PackedVertexAttributes, tangent);
+
+            // Vertex UV coord
+            attributeDescriptions[3].binding = 1;
+            attributeDescriptions[3].location = 3;
+            attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[3].offset = offsetof(PackedVertexAttributes, texCoord);
+
+            // Vertex color
+            if (format.vertexColor)
+            {
+                attributeDescriptions[4].binding = 2;
+                attributeDescriptions[4].location = 4;
+                attributeDescriptions[4].format = VK_FORMAT_R8G8B8A8_UNORM;
+                attributeDescriptions[4].offset = 0;
+            }
+
+            return attributeDescriptions;
+        }
     };
 
+    namespace VertexEncoding
+    {
+        // Writes one stream of the format into output, positions are quantized against bounds
+        void EncodeStream(const VertexFormat& format, uint32_t stream, std::span<const Vertex> vertices, const BoundingBox& bounds,
+                          std::vector<uint8_t>& output);
+    }
+
     namespace Primitives
     {
         const std::vector<uint32_t> RECTANGLE_INDICES = {
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "renderer/mesh.h"
+
+namespace MongooseVK
+{
+    constexpr uint32_t MESH_CLUSTER_MAX_VERTICES = 64;
+    constexpr uint32_t MESH_CLUSTER_MAX_TRIANGLES = 124;
+
+    // Cone cutoffs at or above this never reject a cluster
+    constexpr float MESH_CLUSTER_CONE_DISABLED = 1.0f;
+
+    // A contiguous range of a primitive's index buffer, culled as one unit. Bounds are in object space.
+    struct MeshCluster {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        // Every triangle normal lies within the cone, the cluster is backfacing when the view direction is
+        // inside the cone widened by 90 degrees. The cutoff is the sine of the cone half angle.
+        glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        float coneCutoff = MESH_CLUSTER_CONE_DISABLED;
+
+        uint32_t firstIndex = 0; // Relative to the first index of the primitive
+        uint32_t indexCount = 0;
+    };
+
+    namespace MeshClustering
+    {
+        // Reorders the triangles of indices along a Morton curve and splits them greedily into clusters of at
+        // most MESH_CLUSTER_MAX_VERTICES unique vertices and MESH_CLUSTER_MAX_TRIANGLES triangles
+        std::vector<MeshCluster> BuildClusters(std::span<const Vertex> vertices, std::span<uint32_t> indices);
+
+        // Single cluster covering a whole primitive, used when no clusters were built for it
+        MeshCluster MakeBoundingCluster(const BoundingBox& bounds, uint32_t indexCount);
+    }
+}
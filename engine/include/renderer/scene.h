@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <memory/resource_pool.h>
@@ -8,6 +9,7 @@
 #include "Light.h"
 #include "transform.h"
 
+#include "vulkan/vulkan_gpu_scene.h"
 #include "vulkan/vulkan_mesh.h"
 
 namespace MongooseVK
@@ -34,6 +36,7 @@ namespace MongooseVK
         std::vector<SceneNode> nodes{};
         std::vector<VulkanMesh*> meshes{};
         std::vector<Transform> transforms{};
+        std::vector<glm::mat4> worldMatrices{};
 
         std::vector<std::string> names{};
 
@@ -41,7 +44,14 @@ namespace MongooseVK
 
         TextureHandle skyboxTexture = INVALID_TEXTURE_HANDLE;
 
+        // Every mesh of the scene is uploaded with this layout
+        VertexFormat vertexFormat{};
+
         DirectionalLight directionalLight{};
+        std::vector<PointLight> pointLights{};
+        std::vector<SpotLight> spotLights{};
+
+        VulkanGpuScene* gpuScene = nullptr;
 
         SceneGraph()
         {
@@ -57,25 +67,83 @@ namespace MongooseVK
 
         ~SceneGraph()
         {
-            for (const auto& mesh : meshes) delete mesh;
+            delete gpuScene;
+
+            // Nodes instancing the same mesh share the pointer, every mesh is deleted once
+            std::vector<VulkanMesh*> uniqueMeshes = meshes;
+            std::ranges::sort(uniqueMeshes);
+            const auto [first, last] = std::ranges::unique(uniqueMeshes);
+            uniqueMeshes.erase(first, last);
+
+            for (const auto& mesh : uniqueMeshes) delete mesh;
         }
 
-        Transform GetTransform(SceneNodeHandle handle)
+        SceneNodeHandle AddNode(const SceneNodeHandle parent, const std::string& name, const Transform& transform, VulkanMesh* mesh)
         {
-            SceneNode node = nodes[handle];
-            Transform transform = transforms[handle];
+            const SceneNodeHandle handle = static_cast<SceneNodeHandle>(nodes.size());
 
-            while (node.parent != INVALID_SCENE_NODE_HANDLE)
-            {
-                Transform parentTransform = transforms[node.parent];
-                transform.m_Position += parentTransform.m_Position;
-                transform.m_Rotation += parentTransform.m_Rotation;
-                transform.m_Scale *= parentTransform.m_Scale;
+            SceneNode node{};
+            node.handle = handle;
+            node.parent = parent;
+            node.level = parent != INVALID_SCENE_NODE_HANDLE ? nodes[parent].level + 1 : 0;
+            nodes.push_back(node);
+
+            names.push_back(name);
+            transforms.push_back(transform);
+            meshes.push_back(mesh);
 
-                node = nodes[node.parent];
+            if (parent != INVALID_SCENE_NODE_HANDLE)
+            {
+                const SceneNodeHandle firstChild = nodes[parent].firstChild;
+
+                if (firstChild == INVALID_SCENE_NODE_HANDLE)
+                {
+                    nodes[parent].firstChild = handle;
+                    nodes[handle].lastSibling = handle;
+                } else
+                {
+                    // The first child keeps track of the last sibling so appending stays O(1)
+                    nodes[nodes[firstChild].lastSibling].nextSibling = handle;
+                    nodes[firstChild].lastSibling = handle;
+                }
             }
 
-            return transform;
+            return handle;
+        }
+
+        const glm::mat4& GetWorldMatrix(const SceneNodeHandle handle) const
+        {
+            return worldMatrices[handle];
+        }
+
+        void MarkDirty(const SceneNodeHandle handle)
+        {
+            if (handle < static_cast<SceneNodeHandle>(dirtyNodes.size()))
+                dirtyNodes[handle] = true;
+        }
+
+        // Recomputes world matrices of dirty nodes and their subtrees. Nodes are visited
+        // in level order so a parent is always resolved before any of its children.
+        void UpdateWorldMatrices()
+        {
+            if (levelOrder.size() != nodes.size())
+                RebuildLevelOrder();
+
+            for (const SceneNodeHandle handle: levelOrder)
+            {
+                if (!dirtyNodes[handle]) continue;
+
+                const SceneNode& node = nodes[handle];
+                const glm::mat4 localMatrix = transforms[handle].GetTransform();
+
+                worldMatrices[handle] = node.parent != INVALID_SCENE_NODE_HANDLE
+                                            ? worldMatrices[node.parent] * localMatrix
+                                            : localMatrix;
+                dirtyNodes[handle] = false;
+
+                for (SceneNodeHandle child = node.firstChild; child != INVALID_SCENE_NODE_HANDLE; child = nodes[child].nextSibling)
+                    dirtyNodes[child] = true;
+            }
         }
 
         void Print()
@@ -97,5 +165,23 @@ namespace MongooseVK
             if (node.nextSibling != INVALID_SCENE_NODE_HANDLE)
                 PrintNode(nodes[node.nextSibling]);
         }
+
+    private:
+        void RebuildLevelOrder()
+        {
+            levelOrder.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); i++)
+                levelOrder[i] = static_cast<SceneNodeHandle>(i);
+
+            std::ranges::stable_sort(levelOrder, [&](const SceneNodeHandle a, const SceneNodeHandle b) {
+                return nodes[a].level < nodes[b].level;
+            });
+
+            worldMatrices.resize(nodes.size(), glm::mat4(1.0f));
+            dirtyNodes.assign(nodes.size(), true);
+        }
+
+        std::vector<SceneNodeHandle> levelOrder{};
+        std::vector<bool> dirtyNodes{};
     };
 }
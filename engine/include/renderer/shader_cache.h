@@ -1,11 +1,18 @@
 #pragma once
 
+#include <atomic>
+
 #include "vulkan/vulkan_descriptor_set_layout.h"
 #include "vulkan/vulkan_pipeline.h"
+#include "vulkan/vulkan_shader_compiler.h"
 
 namespace MongooseVK
 {
     constexpr auto SHADER_PATH = "shader/glsl/";
+    constexpr auto SHADER_CACHE_PATH = "cache/shaders/";
+
+    constexpr uint32_t SHADER_CACHE_MAGIC = 0x5356564D; // "MVVS"
+    constexpr uint32_t SHADER_CACHE_VERSION = 1;        // Bumped whenever the layout of the cache files changes
 
     class ShaderCache {
     public:
@@ -15,10 +22,24 @@ namespace MongooseVK
         ShaderCache(const ShaderCache& other) = delete;
         ShaderCache(ShaderCache&& other) = delete;
 
+        // Every shader is preprocessed and compiled as its own job, each worker with its own compiler
         void Load();
 
+        // Variants are compiled on first use with every define set, the plain shader comes from Load
+        static const std::vector<uint32_t>& GetShader(const std::string& shaderName, const std::vector<std::string>& defines = {});
+
+    private:
+        // SPIR-V of the shader from SHADER_CACHE_PATH, compiled and stored there when its key isn't found. The key
+        // covers the compile settings, the defines and the preprocessed source, so editing an include invalidates
+        // every shader using it.
+        static std::vector<uint32_t> Compile(CompilationInfo& info, VulkanShaderCompiler& compiler);
+
     public:
         static std::unordered_map<std::string, std::vector<uint32_t>> shaderCache;
+        static ShaderIncludeCache includeCache; // Read once by Load, shared by the compilers without locking
+
+        static std::atomic<uint32_t> cacheHits;
+        static std::atomic<uint32_t> cacheMisses;
 
     private:
         VulkanDevice* vulkanDevice;
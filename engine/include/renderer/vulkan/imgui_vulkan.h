@@ -20,8 +20,16 @@ namespace MongooseVK
         virtual void Draw() = 0;
         virtual void Resize() {}
 
+        // Called when the header of the window is expanded or collapsed
+        virtual void OnOpen() {}
+        virtual void OnClose() {}
+
     protected:
         VulkanRenderer& renderer;
+
+    private:
+        friend class ImGuiVulkan;
+        bool isOpen = false;
     };
 
     class ImGuiVulkan {
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "renderer/frame_graph/frame_graph_renderpass.h"
+#include "renderer/scene.h"
+#include "renderer/vulkan/vulkan_gpu_scene.h"
+
+namespace MongooseVK
+{
+    // Culls every draw of the GPU scene against the camera and shadow cascade frustums
+    // and writes the compacted indirect draw lists used by the geometry passes.
+    class CullingPass : public FrameGraph::FrameGraphRenderPass {
+    public:
+        explicit CullingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution, CullingPhase _phase = CULLING_PHASE_EARLY);
+        ~CullingPass() override = default;
+
+        virtual void Init() override;
+        virtual void Render(VkCommandBuffer commandBuffer, SceneGraph* scene) override;
+        virtual void Resize(VkExtent2D _resolution) override;
+
+    protected:
+        virtual void CreateDescriptors() override;
+        virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+
+    protected:
+        CullingPhase phase;
+    };
+
+    // Tests the camera visible clusters that were not drawn early against the depth pyramid
+    // and appends the newly visible ones for the second GBuffer phase.
+    class OcclusionCullingPass final : public CullingPass {
+    public:
+        explicit OcclusionCullingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution)
+            : CullingPass(vulkanDevice, _resolution, CULLING_PHASE_LATE) {}
+        ~OcclusionCullingPass() override = default;
+    };
+}
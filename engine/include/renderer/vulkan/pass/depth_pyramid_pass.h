@@ -0,0 +1,27 @@
+#pragma once
+
+#include "renderer/frame_graph/frame_graph_renderpass.h"
+#include "renderer/scene.h"
+
+namespace MongooseVK
+{
+    // Reduces the depth buffer of the first GBuffer phase into a max depth mip chain. The late culling phase
+    // tests cluster bounds against it to find the clusters revealed since the last frame.
+    class DepthPyramidPass final : public FrameGraph::FrameGraphRenderPass {
+    public:
+        explicit DepthPyramidPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution);
+        ~DepthPyramidPass() override;
+
+        virtual void Init() override;
+        virtual void Render(VkCommandBuffer commandBuffer, SceneGraph* scene) override;
+        virtual void Resize(VkExtent2D _resolution) override;
+
+    protected:
+        virtual void CreateDescriptors() override;
+        virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+
+    private:
+        // Set i reads mip i - 1, or the depth buffer for mip 0, and writes mip i
+        std::vector<VkDescriptorSet> mipDescriptorSets{};
+    };
+}
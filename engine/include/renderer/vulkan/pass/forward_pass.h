@@ -0,0 +1,19 @@
+#pragma once
+
+#include "renderer/frame_graph/frame_graph_renderpass.h"
+#include "renderer/scene.h"
+
+namespace MongooseVK
+{
+    // Forward shades the draw lists that can not go through the GBuffer, depth tested against the opaque depth
+    class ForwardPass final : public FrameGraph::FrameGraphRenderPass {
+    public:
+        explicit ForwardPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution);
+        ~ForwardPass() override = default;
+
+        virtual void Render(VkCommandBuffer commandBuffer, SceneGraph* scene) override;
+
+    protected:
+        virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+    };
+}
@@ -3,18 +3,31 @@
 #include "renderer/frame_graph/frame_graph_renderpass.h"
 
 #include "renderer/scene.h"
+#include "renderer/vulkan/vulkan_gpu_scene.h"
 
 namespace MongooseVK
 
 {
-    class GBufferPass final : public FrameGraph::FrameGraphRenderPass {
+    class GBufferPass : public FrameGraph::FrameGraphRenderPass {
     public:
-        explicit GBufferPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution);
+        explicit GBufferPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution, DrawList _drawList = DRAW_LIST_OPAQUE_EARLY);
         ~GBufferPass() override = default;
 
         virtual void Render(VkCommandBuffer commandBuffer, SceneGraph* scene) override;
 
     protected:
         virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+
+    protected:
+        DrawList drawList;
+    };
+
+    // Draws the clusters the occlusion culling pass found visible on top of the first phase, the
+    // attachments are loaded. Disabled in the frame graph along with the other occlusion culling passes.
+    class GBufferLatePass final : public GBufferPass {
+    public:
+        explicit GBufferLatePass(VulkanDevice* vulkanDevice, VkExtent2D _resolution)
+            : GBufferPass(vulkanDevice, _resolution, DRAW_LIST_OPAQUE_LATE) {}
+        ~GBufferLatePass() override = default;
     };
 }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "renderer/frame_graph/frame_graph_renderpass.h"
+#include "renderer/scene.h"
+
+namespace MongooseVK
+{
+    // Bins the point and spot lights of the scene into the view space cluster grid and writes the compacted
+    // per-cluster light index lists the lighting passes iterate.
+    class LightClusteringPass final : public FrameGraph::FrameGraphRenderPass {
+    public:
+        struct LightClusteringPushConstantData {
+            uint32_t indexCapacity = LIGHT_CLUSTER_INDEX_CAPACITY;
+        };
+
+    public:
+        explicit LightClusteringPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution);
+
+        virtual void Init() override;
+        virtual void Render(VkCommandBuffer commandBuffer, SceneGraph* scene) override;
+        virtual void Resize(VkExtent2D _resolution) override;
+
+    protected:
+        virtual void CreateDescriptors() override;
+        virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+    };
+}
@@ -2,9 +2,11 @@
 
 #include "renderer/frame_graph/frame_graph_renderpass.h"
 #include "renderer/scene.h"
+#include "renderer/vulkan/vulkan_mesh.h"
 
 namespace MongooseVK
 {
+    // Deferred resolve, shades the GBuffer with a single fullscreen draw
     class LightingPass final : public FrameGraph::FrameGraphRenderPass {
     public:
         explicit LightingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution);
@@ -14,5 +16,8 @@ namespace MongooseVK
 
     protected:
         virtual void LoadPipeline(PipelineCreateInfo& pipelineCreate) override;
+
+    private:
+        Scope<VulkanMesh> screenRect;
     };
 }
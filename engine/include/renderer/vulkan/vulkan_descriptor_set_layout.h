@@ -18,6 +18,8 @@ namespace MongooseVK
         TextureSampler = 2,
         StorageImage = 3,
         StorageBuffer = 4,
+        UniformBufferDynamic = 5,
+        StorageBufferDynamic = 6,
     };
 
     enum class ShaderStage {
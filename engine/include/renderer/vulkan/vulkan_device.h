@@ -1,4 +1,8 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -11,12 +15,20 @@
 #include "GLFW/glfw3.h"
 
 #include "util/core.h"
+#include "util/deletion_queue.h"
+#include "util/function_ref.h"
+#include "memory/linear_arena.h"
 #include "memory/resource_pool.h"
 #include "vulkan_descriptor_pool.h"
 #include "vulkan_descriptor_set_layout.h"
+#include "vulkan_geometry_arena.h"
+#include "vulkan_gpu_profiler.h"
 #include "vulkan_material.h"
 #include "vulkan_pipeline.h"
+#include "vulkan_pipeline_cache.h"
 #include "vulkan_renderpass.h"
+#include "vulkan_uniform_ring.h"
+#include "vulkan_upload_manager.h"
 #include "resource/resource.h"
 
 namespace MongooseVK
@@ -27,16 +39,17 @@ namespace MongooseVK
     class VulkanMesh;
     class VulkanTexture;
 
-    struct SimplePushConstantData;
     struct AllocatedBuffer;
 
     constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+    constexpr size_t FRAME_ARENA_SIZE = 1024 * 1024;
     constexpr int DESCRIPTOR_SET_LAYOUT_POOL_SIZE = 10000;
     constexpr uint32_t MAX_BINDLESS_RESOURCES = 100;
     constexpr uint32_t MAX_OBJECTS = 10000;
 
-    typedef std::function<void(VkCommandBuffer commandBuffer, uint32_t imageIndex)>&& DrawFrameFunction;
-    typedef std::function<void()>&& OutOfDateErrorCallback;
+    // Called while DrawFrame runs only, so they are passed by reference and a frame doesn't allocate for them
+    typedef FunctionRef<void(VkCommandBuffer commandBuffer, uint32_t imageIndex)> DrawFrameFunction;
+    typedef FunctionRef<void()> OutOfDateErrorCallback;
 
     struct DrawPipelineParams {
         VkPipeline pipeline;
@@ -54,7 +67,24 @@ namespace MongooseVK
         VulkanMeshlet* meshlet;
         PipelineHandle pipelineHandle;
         DrawPushConstantParams pushConstantParams;
-        std::vector<VkDescriptorSet> descriptorSets{};
+        std::span<const VkDescriptorSet> descriptorSets{}; // Usually in the frame arena
+        std::span<const uint32_t> dynamicOffsets{};         // Of every dynamic uniform binding in the sets, in order
+    };
+
+    struct DrawIndirectParams {
+        VkCommandBuffer commandBuffer;
+        PipelineHandle pipelineHandle;
+        DrawPushConstantParams pushConstantParams;
+        std::span<const VkDescriptorSet> descriptorSets{};
+        std::span<const uint32_t> dynamicOffsets{};
+
+        const VulkanGeometryArena* geometryArena = nullptr;
+
+        VkBuffer indirectBuffer = VK_NULL_HANDLE;
+        VkDeviceSize indirectOffset = 0;
+        VkBuffer countBuffer = VK_NULL_HANDLE;
+        VkDeviceSize countOffset = 0;
+        uint32_t maxDrawCount = 0;
     };
 
     struct TextureCreateInfo {
@@ -79,6 +109,10 @@ namespace MongooseVK
 
         VkImageCreateFlags flags = 0;
         bool isCubeMap = false;
+
+        // Places the image in memory owned by the caller, see VulkanDevice::AllocateMemory
+        VmaAllocation aliasAllocation = VK_NULL_HANDLE;
+        VkDeviceSize aliasOffset = 0;
     };
 
     struct  FramebufferCreationAttachment {
@@ -92,23 +126,6 @@ namespace MongooseVK
         VkExtent2D resolution{};
     };
 
-    class DeletionQueue {
-    public:
-        void Push(const std::function<void()>& func)
-        {
-            deletions.push_back(func);
-        }
-
-        void Flush()
-        {
-            for (auto& func: deletions) func();
-            deletions.clear();
-        }
-
-    private:
-        std::vector<std::function<void()>> deletions;
-    };
-
     class VulkanDevice {
     public:
         VulkanDevice(GLFWwindow* glfwWindow);
@@ -118,6 +135,7 @@ namespace MongooseVK
         static VulkanDevice* Get() { return s_Instance; }
 
         void DrawMeshlet(const DrawCommandParams& params);
+        void DrawIndirect(const DrawIndirectParams& params);
 
         void DrawFrame(VkSwapchainKHR swapchain, DrawFrameFunction draw, OutOfDateErrorCallback errorCallback);
 
@@ -137,9 +155,42 @@ namespace MongooseVK
 
         [[nodiscard]] VkQueue GetGraphicsQueue() const { return graphicsQueue; }
         [[nodiscard]] VkQueue GetPresentQueue() const { return presentQueue; }
+        [[nodiscard]] VkQueue GetTransferQueue() const { return transferQueue; }
+
+        // Queues have to be externally synchronized and uploads submit from job system workers, every queue
+        // operation goes through these under one lock, the queues may share a single VkQueue
+        VkResult QueueSubmit(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence = VK_NULL_HANDLE) const;
+        VkResult QueuePresent(const VkPresentInfoKHR& presentInfo) const;
+        void QueueWaitIdle(VkQueue queue) const;
+        void WaitIdle() const;
+        [[nodiscard]] uint32_t GetTransferQueueFamilyIndex() const { return transferQueueFamilyIndex; }
+        [[nodiscard]] VulkanUploadManager* GetUploadManager() const { return uploadManager.get(); }
+        // Arenas are created on first use, the standard format one exists from the start
+        [[nodiscard]] VulkanGeometryArena* GetGeometryArena(const VertexFormat& vertexFormat = {});
+        [[nodiscard]] std::vector<VulkanGeometryArena*> GetGeometryArenas();
 
         [[nodiscard]] VkCommandPool GetCommandPool() const { return commandPool; }
         [[nodiscard]] VkPhysicalDeviceProperties GetDeviceProperties() const { return physicalDeviceProperties; }
+        [[nodiscard]] const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return enabledFeatures; }
+
+        // Secondary command buffer of the frame being recorded, from the command pool of the calling thread so
+        // job system workers can record in parallel. Valid until the frame comes around again.
+        VkCommandBuffer BeginSecondaryCommandBuffer(const VkCommandBufferInheritanceInfo& inheritanceInfo);
+
+        // Scratch memory of the frame being recorded, reset once the GPU is done with the frame
+        [[nodiscard]] LinearArena& GetFrameArena() const { return *frameArenas[currentFrame]; }
+
+        // Deletions pushed here wait until no frame in flight can read what they release
+        DeletionQueue& GetFrameDeletionQueue() { return frameDeletionQueues[deletionFrame]; }
+
+        // Per frame uniforms of the frame being recorded, bound with dynamic offsets
+        [[nodiscard]] VulkanUniformRing& GetUniformRing() const { return *uniformRing; }
+
+        // Times scopes of the frame command buffer, the frame graph adds one per pass
+        [[nodiscard]] VulkanGpuProfiler& GetGpuProfiler() const { return *gpuProfiler; }
+
+        // Every pipeline is created through it, kept on disk between runs
+        [[nodiscard]] VulkanPipelineCache& GetPipelineCache() const { return *pipelineCache; }
 
         void SetViewportAndScissor(VkExtent2D extent, VkCommandBuffer commandBuffer) const;
 
@@ -153,11 +204,17 @@ namespace MongooseVK
         // Buffer management
         AllocatedBuffer CreateBuffer(uint64_t size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO);
         void SetDataInBuffer(const AllocatedBuffer& buffer, const void* data, uint64_t size, uint64_t offset);
+        void UploadBufferData(const AllocatedBuffer& buffer, const void* data, uint64_t size, uint64_t offset = 0);
         void CopyBuffer(const AllocatedBuffer& src, const AllocatedBuffer& dst);
         void DestroyBuffer(const AllocatedBuffer& buffer);
 
+        // Memory for images placed with TextureCreateInfo::aliasAllocation, freed once the frame is done with it
+        VmaAllocation AllocateMemory(const VkMemoryRequirements& memoryRequirements);
+        void FreeMemory(VmaAllocation allocation);
+
         // Texture management
         TextureHandle CreateTexture(const TextureCreateInfo& createInfo);
+        VkMemoryRequirements GetTextureMemoryRequirements(const TextureCreateInfo& createInfo);
         VulkanTexture* GetTexture(TextureHandle textureHandle);
         void UploadTextureData(TextureHandle textureHandle, const void* data, uint64_t size);
         void UploadCubemapTextureData(TextureHandle textureHandle, const Bitmap* cubemap);
@@ -197,12 +254,13 @@ namespace MongooseVK
 
         void CreateCommandPool();
         void CreateCommandBuffers();
+        void CreateSecondaryCommandPools();
         void CreateSyncObjects();
         void CreateDescriptorPool();
         VkResult SetupNextFrame(VkSwapchainKHR swapchain);
         void SetViewportAndScissor(VkExtent2D extent2D) const;
 
-        VkResult SubmitDrawCommands(const VkSemaphore* signalSemaphores) const;
+        VkResult SubmitDrawCommands(const VkSemaphore* signalSemaphores, UploadToken uploadToken) const;
         VkResult PresentFrame(VkSwapchainKHR swapchain, uint32_t imageIndex, const VkSemaphore* signalSemaphores) const;
 
     public:
@@ -222,12 +280,15 @@ namespace MongooseVK
         DescriptorSetLayoutHandle materialsDescriptorSetLayoutHandle;
         AllocatedBuffer materialBuffer;
 
-        DeletionQueue frameDeletionQueue;
+        // Resources released while a frame is recorded or in flight, run once its fence has been waited on. The
+        // frame in flight before it was submitted earlier, so it is done by then as well.
+        std::array<DeletionQueue, MAX_FRAMES_IN_FLIGHT> frameDeletionQueues{};
+        uint32_t deletionFrame = 0;
 
     private:
         static VulkanDevice* s_Instance;
 
-        uint32_t drawCallCounter = 0;
+        std::atomic<uint32_t> drawCallCounter = 0;
         uint32_t prevDrawCallCount = 0;
 
         int viewportWidth{}, viewportHeight{};
@@ -240,14 +301,31 @@ namespace MongooseVK
 
         VkQueue graphicsQueue{};
         VkQueue presentQueue{};
+        VkQueue transferQueue{};
+        uint32_t transferQueueFamilyIndex = 0;
 
         VkSurfaceKHR surface{};
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         VkPhysicalDeviceProperties physicalDeviceProperties;
+        VkPhysicalDeviceFeatures enabledFeatures{};
 
         VkCommandPool commandPool{};
 
         std::vector<VkCommandBuffer> commandBuffers;
+
+        struct SecondaryCommandPool {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers{};
+            uint32_t usedCount = 0; // Buffers handed out this frame, the rest are reused next time
+        };
+
+        // One pool per job system worker plus one for the main thread, for each frame in flight
+        std::array<std::vector<SecondaryCommandPool>, MAX_FRAMES_IN_FLIGHT> secondaryCommandPools{};
+        std::array<Scope<LinearArena>, MAX_FRAMES_IN_FLIGHT> frameArenas{};
+        Scope<VulkanUniformRing> uniformRing{};
+        Scope<VulkanGpuProfiler> gpuProfiler{};
+        Scope<VulkanPipelineCache> pipelineCache{};
+
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
         std::vector<VkFence> inFlightFences;
@@ -259,6 +337,11 @@ namespace MongooseVK
         Scope<VulkanDescriptorPool> imguiDescriptorPool{};
         Scope<VulkanDescriptorPool> bindlessDescriptorPool{};
 
+        Scope<VulkanUploadManager> uploadManager{};
+        std::array<Scope<VulkanGeometryArena>, VERTEX_FORMAT_COUNT> geometryArenas{};
+        std::mutex geometryArenaMutex;
+        mutable std::mutex queueMutex;
+
         VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
     };
 }
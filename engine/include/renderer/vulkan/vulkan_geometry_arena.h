@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <span>
+#include <vulkan/vulkan_core.h>
+
+#include "memory/free_list_allocator.h"
+#include "renderer/mesh.h"
+#include "resource/resource.h"
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+
+    constexpr uint32_t GEOMETRY_ARENA_INITIAL_VERTEX_CAPACITY = 1024 * 1024;
+    constexpr uint32_t GEOMETRY_ARENA_INITIAL_INDEX_CAPACITY = 4 * 1024 * 1024;
+
+    // Location of a mesh inside the arena, offsets are in elements so they can be passed to vkCmdDrawIndexed as is
+    struct GeometryAllocation {
+        int32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+
+        bool IsValid() const { return vertexCount > 0 && indexCount > 0; }
+    };
+
+    struct GeometryArenaStats {
+        VertexFormat vertexFormat{};
+        uint32_t vertexSize = 0;
+
+        uint64_t vertexCapacity = 0;
+        uint64_t vertexUsed = 0;
+        float vertexFragmentation = 0.0f;
+
+        uint64_t indexCapacity = 0;
+        uint64_t indexUsed = 0;
+        float indexFragmentation = 0.0f;
+
+        uint32_t allocations = 0;
+    };
+
+    // Device local vertex streams and one index buffer shared by every mesh of a vertex format. All streams
+    // share the vertex allocator so a single vertexOffset addresses each of them. Buffers grow on demand,
+    // allocations keep their offsets as the old contents are copied over.
+    class VulkanGeometryArena {
+    public:
+        VulkanGeometryArena(VulkanDevice* vulkanDevice, const VertexFormat& vertexFormat);
+        ~VulkanGeometryArena();
+
+        VulkanGeometryArena(const VulkanGeometryArena&) = delete;
+        VulkanGeometryArena& operator=(const VulkanGeometryArena&) = delete;
+
+        // Vertices are encoded into the arena format, bounds are only used for quantized positions
+        GeometryAllocation Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const BoundingBox& bounds);
+
+        // The range is only reused once every frame in flight that may still read it is done
+        void Free(const GeometryAllocation& allocation);
+
+        void Bind(VkCommandBuffer commandBuffer) const;
+
+        const VertexFormat& GetVertexFormat() const { return vertexFormat; }
+        uint32_t GetVertexStreamCount() const { return vertexFormat.GetStreamCount(); }
+
+        VkBuffer GetVertexBuffer(const uint32_t stream = 0) const { return vertexStreams[stream].buffer; }
+        VkBuffer GetIndexBuffer() const { return indexBuffer.buffer; }
+
+        GeometryArenaStats GetStats();
+
+    private:
+        void GrowVertexBuffer(uint64_t requiredCapacity);
+        void GrowIndexBuffer(uint64_t requiredCapacity);
+
+        AllocatedBuffer CreateVertexBuffer(uint32_t stream, uint64_t capacity) const;
+        AllocatedBuffer CreateIndexBuffer(uint64_t capacity) const;
+        void CopyBuffer(const AllocatedBuffer& src, const AllocatedBuffer& dst, uint64_t size) const;
+
+    private:
+        VulkanDevice* device;
+        VertexFormat vertexFormat;
+
+        std::array<AllocatedBuffer, MAX_VERTEX_STREAMS> vertexStreams{};
+        AllocatedBuffer indexBuffer{};
+
+        FreeListAllocator vertexAllocator;
+        FreeListAllocator indexAllocator;
+        uint32_t allocationCount = 0;
+
+        std::vector<uint8_t> encodedVertices{};
+
+        std::mutex arenaMutex;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+
+    constexpr uint32_t GPU_PROFILER_MAX_SCOPES = 64;     // Per frame, scopes after these are not timed
+    constexpr uint32_t GPU_PROFILER_HISTORY_SIZE = 128;  // Frames the rolling stats are taken over
+    constexpr uint32_t INVALID_GPU_PROFILER_SCOPE = ~0u;
+
+    // Counters of the statistics queries, in the order Vulkan writes the enabled flags
+    struct GpuPipelineStatistics {
+        uint64_t inputAssemblyPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t fragmentShaderInvocations = 0;
+        uint64_t computeShaderInvocations = 0;
+    };
+
+    // Timings of a scope in milliseconds, rolling over the last GPU_PROFILER_HISTORY_SIZE frames it was recorded in
+    struct GpuScopeStats {
+        std::string name;
+        float lastTime = 0.0f;
+        float minTime = 0.0f;
+        float avgTime = 0.0f;
+        float p99Time = 0.0f;
+        uint32_t sampleCount = 0;
+
+        GpuPipelineStatistics pipelineStatistics{}; // Of the last frame, only while statistics are collected
+    };
+
+    // Timestamp queries around named scopes of the frame command buffer. Every frame in flight has its own range
+    // of queries, they are read back once the frame fence has been waited on, so results lag a frame or two
+    // behind and reading them never stalls. Scopes are recorded from the thread submitting the frame.
+    class VulkanGpuProfiler {
+    public:
+        VulkanGpuProfiler(VulkanDevice* vulkanDevice, uint32_t frameCount);
+        ~VulkanGpuProfiler();
+
+        VulkanGpuProfiler(const VulkanGpuProfiler&) = delete;
+        VulkanGpuProfiler& operator=(const VulkanGpuProfiler&) = delete;
+
+        // Reads back the queries the frame wrote last time around, its fence has to be waited on
+        void BeginFrame(uint32_t frameIndex);
+
+        // Recorded first into the frame command buffer, outside any render pass
+        void ResetQueries(VkCommandBuffer commandBuffer) const;
+
+        // Outside render pass instances, the commands in between are timed and counted. Scopes can't overlap while
+        // statistics are collected. The name has to outlive the profiler, a literal or an interned name.
+        uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name);
+        void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        // Secondary command buffers executed in a scope have to inherit the statistics being collected
+        VkQueryPipelineStatisticFlags GetInheritedPipelineStatistics() const;
+
+        bool IsPipelineStatisticsSupported() const { return pipelineStatisticsPool != VK_NULL_HANDLE; }
+        bool IsPipelineStatisticsEnabled() const { return pipelineStatisticsEnabled; }
+        void SetPipelineStatisticsEnabled(const bool enabled) { pipelineStatisticsRequested = enabled; } // From the next frame
+
+        const std::vector<GpuScopeStats>& GetScopeStats() const { return scopeStats; }
+        const GpuScopeStats* GetScopeStats(const std::string& name) const;
+
+        // From the start of the first scope to the end of the last one, of the last frame read back
+        float GetFrameTime() const { return frameTime; }
+
+        void ResetStats();
+
+    private:
+        struct FrameQueries {
+            std::array<uint32_t, GPU_PROFILER_MAX_SCOPES> scopes{}; // Stats index of every scope written, in query order
+            uint32_t scopeCount = 0;
+            bool pipelineStatistics = false;
+        };
+
+        uint32_t GetStatsIndex(const char* name);
+        uint64_t GetTicks(uint64_t begin, uint64_t end) const;
+        void AddSample(uint32_t statsIndex, float time);
+
+    private:
+        VulkanDevice* device;
+        float timestampPeriod;
+        uint64_t timestampMask = ~0ull; // The timestampValidBits of the graphics queue
+
+        VkQueryPool timestampPool = VK_NULL_HANDLE;
+        VkQueryPool pipelineStatisticsPool = VK_NULL_HANDLE; // Only with the pipelineStatisticsQuery and inheritedQueries features
+
+        bool pipelineStatisticsRequested = false;
+        bool pipelineStatisticsEnabled = false;
+
+        uint32_t currentFrame = 0;
+        std::vector<FrameQueries> frames{};
+
+        std::vector<GpuScopeStats> scopeStats{};
+        std::vector<std::array<float, GPU_PROFILER_HISTORY_SIZE>> histories{};
+        std::unordered_map<const char*, uint32_t> statsIndices{}; // By name pointer, only a scope seen the first time allocates
+        float frameTime = 0.0f;
+    };
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include <glm/glm.hpp>
+
+#include "renderer/light.h"
+#include "renderer/mesh_cluster.h"
+#include "resource/resource.h"
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+    class VulkanGeometryArena;
+    struct SceneGraph;
+    struct DrawIndirectParams;
+
+    // The culling passes write compacted command lists per view, shadow cascades get a list each. With occlusion
+    // culling the GBuffer is drawn in two phases: clusters visible last frame first, then the ones the depth
+    // pyramid of the first phase revealed. Alpha tested clusters skip the GBuffer and are forward shaded.
+    enum DrawList : uint32_t {
+        DRAW_LIST_OPAQUE_EARLY = 0,
+        DRAW_LIST_OPAQUE_LATE,
+        DRAW_LIST_ALPHA_TESTED,
+        DRAW_LIST_SHADOW_CASCADE_0,
+        DRAW_LIST_COUNT = DRAW_LIST_SHADOW_CASCADE_0 + SHADOW_MAP_CASCADE_COUNT,
+    };
+
+    // View 0 is the camera, view i + 1 is shadow cascade i
+    constexpr uint32_t CULLING_VIEW_COUNT = 1 + SHADOW_MAP_CASCADE_COUNT;
+    constexpr uint32_t CULLING_WORKGROUP_SIZE = 64;
+
+    constexpr uint32_t DRAW_FLAG_ALPHA_TESTED = 1 << 0;
+
+    enum CullingPhase : uint32_t {
+        CULLING_PHASE_EARLY = 0, // Frustum and cone tests, draws the clusters visible last frame
+        CULLING_PHASE_LATE,      // Depth pyramid test, draws the newly visible clusters
+    };
+
+    constexpr uint32_t CULLING_FLAG_OCCLUSION = 1 << 0;
+
+    // One per scene node with a mesh, rewritten every frame. Mirrors InstanceData in draw_data.glslh (std430)
+    struct GpuInstanceData {
+        glm::mat4 modelMatrix{1.0f};
+    };
+
+    // One per mesh cluster, static after Build. Mirrors DrawData in draw_data.glslh (std430)
+    struct GpuDrawData {
+        glm::vec4 boundingSphere{0.0f};                        // Object space center and radius of the cluster
+        glm::vec4 cone{0.0f, 0.0f, 1.0f, MESH_CLUSTER_CONE_DISABLED}; // Object space normal cone axis and cutoff
+        glm::vec4 boundsCenter{0.0f};                          // Meshlet bounds, quantized positions are relative to them
+        glm::vec4 boundsExtent{0.0f};
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+        uint32_t materialIndex = 0;
+        uint32_t instanceIndex = 0;
+        uint32_t flags = 0;
+        uint32_t padding[2]{};
+    };
+
+    static_assert(sizeof(GpuDrawData) == 96, "GpuDrawData has to match the shader layout");
+
+    struct CullingView {
+        glm::mat4 viewProjection{1.0f};
+        std::array<glm::vec4, 6> frustumPlanes{};
+        glm::vec4 origin{0.0f}; // World space view position, w enables normal cone culling
+    };
+
+    // Camera view only, counted by the culling shader and read back a few frames later
+    struct GpuCullingStats {
+        uint32_t frustumCulled = 0;
+        uint32_t backfaceCulled = 0;
+        uint32_t occlusionCulled = 0;
+        uint32_t drawnEarly = 0;
+        uint32_t drawnLate = 0;
+    };
+
+    struct CullingPushConstantData {
+        VkDeviceAddress viewsAddress = 0;
+        VkDeviceAddress drawDataAddress = 0;
+        VkDeviceAddress instanceDataAddress = 0;
+        VkDeviceAddress visibilityAddress = 0;
+        VkDeviceAddress drawCommandsAddress = 0;
+        VkDeviceAddress drawCountsAddress = 0;
+        VkDeviceAddress statsAddress = 0;
+        uint32_t drawCount = 0;
+        uint32_t drawCapacity = 0;
+        uint32_t phase = CULLING_PHASE_EARLY;
+        uint32_t flags = 0;
+        glm::uvec2 depthResolution{0}; // Filled in by the culling pass, the depth pyramid is built from it
+    };
+
+    // GPU side copy of every mesh cluster in a scene graph, each cluster is culled and drawn on its own. All
+    // geometry lives in the geometry arena of the scene vertex format so a whole draw list can be submitted with
+    // a single indirect count call.
+    class VulkanGpuScene {
+    public:
+        explicit VulkanGpuScene(VulkanDevice* vulkanDevice);
+        ~VulkanGpuScene();
+
+        VulkanGpuScene(const VulkanGpuScene&) = delete;
+        VulkanGpuScene& operator=(const VulkanGpuScene&) = delete;
+
+        void Build(SceneGraph& scene);
+
+        // Writes model matrices and view frustums for the frame currently being recorded and reads back the
+        // culling stats of the last frame that used the same resources
+        void Update(const SceneGraph& scene, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPosition);
+
+        uint32_t GetDrawCount() const { return drawCapacity; }
+        uint32_t GetInstanceCount() const { return static_cast<uint32_t>(instanceNodes.size()); }
+
+        // Whether the early culling phase leaves draws to the occlusion test, the renderer keeps it in sync with the
+        // occlusion culling passes of the frame graph
+        void SetOcclusionCulling(const bool enabled) { occlusionCulling = enabled; }
+        const GpuCullingStats& GetCullingStats() const { return cullingStats; }
+
+        CullingPushConstantData GetCullingPushConstantData(CullingPhase phase) const;
+        VkDeviceAddress GetDrawDataAddress() const { return drawDataBuffer.address; }
+        VkDeviceAddress GetInstanceDataAddress() const;
+        const AllocatedBuffer& GetDrawCountBuffer() const;
+        const AllocatedBuffer& GetCullingStatsBuffer() const;
+
+        void FillDrawIndirectParams(DrawIndirectParams& params, DrawList drawList) const;
+
+    private:
+        struct FrameResources {
+            AllocatedBuffer instanceDataBuffer{};
+            AllocatedBuffer drawCommandBuffer{};
+            AllocatedBuffer drawCountBuffer{};
+            AllocatedBuffer cullingStatsBuffer{};
+        };
+
+        void CreateResources(const std::vector<GpuDrawData>& drawData);
+        void DestroyResources();
+
+        static CullingView ExtractFrustum(const glm::mat4& viewProjection);
+        static void AddDraw(std::vector<GpuDrawData>& drawData, const GpuDrawData& meshletDraw, const MeshCluster& cluster);
+
+    private:
+        VulkanDevice* device;
+        VulkanGeometryArena* geometryArena = nullptr;
+
+        std::vector<int64_t> instanceNodes{}; // Scene node handle of every instance
+        std::vector<GpuInstanceData> instanceData{};
+        uint32_t drawCapacity = 0;
+
+        bool occlusionCulling = true;
+        GpuCullingStats cullingStats{};
+
+        AllocatedBuffer drawDataBuffer{};
+        AllocatedBuffer visibilityBuffer{}; // Per cluster, written by the late culling phase and read by the next frame
+        VkDeviceAddress viewsAddress = 0;   // Culling views of the frame being recorded, in the uniform ring
+        std::vector<FrameResources> frameResources{};
+    };
+}
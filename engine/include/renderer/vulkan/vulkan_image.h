@@ -39,6 +39,15 @@ namespace MongooseVK
 
             return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         }
+
+        inline VkImageLayout GetShaderReadLayoutFromFormat(ImageFormat format) {
+            if (format == ImageFormat::DEPTH24_STENCIL8)
+                return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            if (format == ImageFormat::DEPTH32)
+                return VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL;
+
+            return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
     }
 
     class ImageBuilder {
@@ -114,8 +123,22 @@ namespace MongooseVK
             return *this;
         }
 
+        // Places the image at an offset of memory owned by the caller instead of a dedicated allocation
+        ImageBuilder& SetAliasing(VmaAllocation _allocation, VkDeviceSize _offset)
+        {
+            aliasAllocation = _allocation;
+            aliasOffset = _offset;
+            return *this;
+        }
+
+        // Requirements of the image Build would create, without creating it
+        VkMemoryRequirements GetMemoryRequirements() const;
+
         AllocatedImage Build();
 
+    private:
+        VkImageCreateInfo GetImageCreateInfo() const;
+
     private:
         VulkanDevice* device;
 
@@ -130,6 +153,9 @@ namespace MongooseVK
         uint32_t mipLevels = 1;
         VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
         VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocation aliasAllocation = VK_NULL_HANDLE;
+        VkDeviceSize aliasOffset = 0;
     };
 
     class ImageViewBuilder {
@@ -1,52 +1,80 @@
 #pragma once
 
+#include <span>
+
 #include "renderer/mesh.h"
+#include "renderer/mesh_cluster.h"
+#include "util/core.h"
 #include "vulkan_buffer.h"
+#include "vulkan_geometry_arena.h"
 #include "vulkan_material.h"
 
 namespace MongooseVK
 {
     class VulkanDevice;
 
-    struct VulkanMeshlet {
-        std::vector<Vertex> vertices;
+    // Vertex data is copied to staging memory during upload, so by default nothing is kept on the CPU
+    enum class MeshResidency {
+        GpuOnly,
+        KeepCpuCopy, // Keeps positions and indices for CPU side consumers such as picking or BVH building
+    };
+
+    // Compact CPU copy, positions only as the other attributes are not needed for spatial queries
+    struct MeshletCpuData {
+        std::vector<glm::vec3> positions;
         std::vector<uint32_t> indices;
+    };
 
-        AllocatedBuffer vertexBuffer;
-        AllocatedBuffer indexBuffer;
+    struct VulkanMeshlet {
+        VulkanGeometryArena* geometryArena = nullptr;
+        GeometryAllocation geometry{};
 
         MaterialHandle material = INVALID_MATERIAL_HANDLE;
+        BoundingBox bounds{};
+
+        // Culling units, empty when the meshlet is culled as a whole
+        std::vector<MeshCluster> clusters{};
 
-        void Bind(const VkCommandBuffer commandBuffer) const
-        {
-            const VkBuffer buffers[] = {vertexBuffer.buffer};
-            const VkDeviceSize offsets[] = {0};
+        Ref<MeshletCpuData> cpuData{};
 
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        }
+        uint32_t GetIndexCount() const { return geometry.indexCount; }
+        bool HasCpuData() const { return cpuData != nullptr; }
     };
 
     class VulkanMesh {
     public:
-        VulkanMesh(VulkanDevice* vulkanDevice);
+        VulkanMesh(VulkanDevice* vulkanDevice, const VertexFormat& vertexFormat = {}, MeshResidency residency = MeshResidency::GpuOnly);
         ~VulkanMesh();
 
-        void AddMeshlet(const std::vector<Vertex>& vertices,
-                        const std::vector<uint32_t>& indices,
+        void AddMeshlet(std::span<const Vertex> vertices,
+                        std::span<const uint32_t> indices,
                         MaterialHandle materialHandle = INVALID_MATERIAL_HANDLE);
 
+        void AddMeshlet(std::span<const Vertex> vertices,
+                        std::span<const uint32_t> indices,
+                        MaterialHandle materialHandle,
+                        const BoundingBox& bounds,
+                        std::span<const MeshCluster> clusters = {});
+
         std::vector<VulkanMeshlet>& GetMeshlets() { return meshlets; }
+        const VertexFormat& GetVertexFormat() const { return vertexFormat; }
+        MeshResidency GetResidency() const { return residency; }
 
         static VulkanMeshlet MakeMeshlet(VulkanDevice* device,
-                                         const std::vector<Vertex>& vertices,
-                                         const std::vector<uint32_t>& indices, MaterialHandle materialHandle = INVALID_MATERIAL_HANDLE);
+                                         std::span<const Vertex> vertices,
+                                         std::span<const uint32_t> indices,
+                                         MaterialHandle materialHandle = INVALID_MATERIAL_HANDLE,
+                                         const VertexFormat& vertexFormat = {},
+                                         MeshResidency residency = MeshResidency::GpuOnly);
 
-        static AllocatedBuffer CreateVertexBuffer(VulkanDevice* device, const std::vector<Vertex>& vertices);
-        static AllocatedBuffer CreateIndexBuffer(VulkanDevice* device, const std::vector<uint32_t>& indices);
+    private:
+        static Ref<MeshletCpuData> MakeCpuData(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
 
     private:
         VulkanDevice* vulkanDevice;
+        VulkanGeometryArena* geometryArena;
+        VertexFormat vertexFormat;
+        MeshResidency residency;
         std::vector<VulkanMeshlet> meshlets;
     };
 }
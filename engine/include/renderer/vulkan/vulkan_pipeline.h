@@ -6,15 +6,17 @@
 #include <glm/glm.hpp>
 
 #include "vulkan_renderpass.h"
+#include "renderer/mesh.h"
 #include "resource/resource.h"
 
 namespace MongooseVK
 {
     class VulkanDevice;
 
-    struct SimplePushConstantData {
-        glm::mat4 modelMatrix{1.f};
-        uint32_t materialIndex = 0;
+    // Per-draw data is fetched with gl_InstanceIndex, which the culling pass sets to the draw index
+    struct DrawDataPushConstantData {
+        VkDeviceAddress drawDataAddress = 0;
+        VkDeviceAddress instanceDataAddress = 0;
     };
 
     struct SkyboxPushConstantData {
@@ -34,7 +36,13 @@ namespace MongooseVK
 
     struct ShadowMapPushConstantData {
         glm::mat4 projection{1.f};
-        glm::mat4 modelMatrix{1.f};
+        VkDeviceAddress drawDataAddress = 0;
+        VkDeviceAddress instanceDataAddress = 0;
+    };
+
+    struct DepthPyramidPushConstantData {
+        glm::ivec2 sourceSize{0};
+        glm::ivec2 destinationSize{0};
     };
 
     struct PrefilterData {
@@ -94,6 +102,11 @@ namespace MongooseVK
         std::string name;
         std::string vertexShaderPath;
         std::string fragmentShaderPath;
+        // When set a compute pipeline is built and every graphics state below is ignored
+        std::string computeShaderPath;
+
+        // Selects the vertex input state and the matching shader variant
+        VertexFormat vertexFormat{};
 
         std::vector<DescriptorSetLayoutHandle> descriptorSetLayouts{};
         std::vector<ImageFormat> colorAttachments;
@@ -115,6 +128,9 @@ namespace MongooseVK
     struct VulkanPipeline : PoolObject {
         VkShaderModule vertexShaderModule = VK_NULL_HANDLE;
         VkShaderModule fragmentShaderModule = VK_NULL_HANDLE;
+        VkShaderModule computeShaderModule = VK_NULL_HANDLE;
+
+        VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
         VkPipeline pipeline;
         VkPipelineLayout pipelineLayout;
@@ -132,6 +148,8 @@ namespace MongooseVK
 
     private:
         PipelineHandle Build(VulkanDevice* vulkanDevice);
+        PipelineHandle BuildCompute(VulkanDevice* vulkanDevice);
+        void CreatePipelineLayout(VulkanDevice* vulkanDevice, VulkanPipeline* vulkanPipeline);
         void clear();
 
     public:
@@ -141,6 +159,8 @@ namespace MongooseVK
     private:
         std::string vertexShaderPath;
         std::string fragmentShaderPath;
+        std::string computeShaderPath;
+        VertexFormat vertexFormat{};
         VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
         VkPipelineRasterizationStateCreateInfo rasterizer{};
 
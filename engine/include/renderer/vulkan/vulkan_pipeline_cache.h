@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+
+    constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x434B564D; // "MVKC"
+    constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+    // Pipelines created since startup and the time spent in the driver for them, to compare warm and cold caches
+    struct PipelineCacheStats {
+        uint32_t pipelineCount = 0;
+        float creationTime = 0.0f; // Milliseconds
+        uint64_t loadedSize = 0;   // Bytes of cache data loaded at startup, 0 for a cold cache
+    };
+
+    // Device wide VkPipelineCache every pipeline is created through. The driver data is stored on disk, the file is
+    // only loaded back when it was written by the same driver on the same device, anything else starts cold.
+    class VulkanPipelineCache {
+    public:
+        VulkanPipelineCache(VulkanDevice* vulkanDevice, std::filesystem::path cachePath);
+        ~VulkanPipelineCache();
+
+        VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+        VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+        // Writes the cache with every pipeline created so far, replacing the file only once it is complete
+        bool Save() const;
+
+        VkPipelineCache Get() const { return pipelineCache; }
+
+        // Thread safe, called by the pipeline builders around pipeline creation
+        void AddCreation(uint64_t nanoseconds);
+        PipelineCacheStats GetStats() const;
+
+    private:
+        bool Load(std::vector<uint8_t>& data) const;
+
+    private:
+        VulkanDevice* device;
+        std::filesystem::path path;
+
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+        uint64_t loadedSize = 0;
+
+        std::atomic<uint32_t> pipelineCount = 0;
+        std::atomic<uint64_t> creationTime = 0;
+    };
+}
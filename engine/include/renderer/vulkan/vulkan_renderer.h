@@ -35,6 +35,15 @@ namespace MongooseVK
         glm::vec4 cascadeSplits[4];
         alignas(4) float intensity = 1.0f;
         alignas(4) float bias = 0.005f;
+        alignas(16) glm::uvec4 clusterGrid{0}; // Light cluster counts, w is the number of scene lights
+        glm::vec4 clusterScale{0.0f};          // Pixels to clusters in xy, log view depth to slice scale and bias in zw
+    };
+
+    // Point and spot lights of the scene, mirrors SceneLight in lighting.glslh (std430)
+    struct GpuLight {
+        glm::vec4 positionRadius{0.0f};                   // World space position and attenuation radius
+        glm::vec4 colorIntensity{0.0f};
+        glm::vec4 spotDirection{0.0f, 0.0f, 0.0f, -1.0f}; // Cone axis and cosine of the cone angle, -1 for point lights
     };
 
     struct SceneDefinition {
@@ -50,7 +59,7 @@ namespace MongooseVK
         void Init(uint32_t width, uint32_t height);
         void CalculateIBL();
 
-        void LoadScene(const std::string& gltfPath, const std::string& hdrPath);
+        void LoadScene(const std::string& gltfPath, const std::string& hdrPath, const VertexFormat& vertexFormat = {});
 
         void IdleWait();
         void Resize(int width, int height);
@@ -62,6 +71,10 @@ namespace MongooseVK
 
         SceneGraph* GetSceneGraph() { return sceneGraph; }
 
+        // Enables or disables the depth pyramid, the late culling phase and the late GBuffer pass in the frame graph
+        void SetOcclusionCulling(bool enabled);
+        bool IsOcclusionCullingEnabled() const;
+
     private:
         void CreateSwapchain();
 
@@ -71,7 +84,7 @@ namespace MongooseVK
         void UpdateCameraBuffer(Camera& camera);
         void RotateLight(float deltaTime);
 
-        void UpdateLightsBuffer();
+        void UpdateLightsBuffer(const Camera& camera);
         void PresentFrame(const VkCommandBuffer& commandBuffer, uint32_t imageIndex, TextureHandle textureToPresent);
 
         void CreateExternalResources();
@@ -79,6 +92,7 @@ namespace MongooseVK
         FrameGraph::FrameGraphResource* CreateFrameGraphTextureResource(const char* resourceName, TextureCreateInfo& createInfo);
         FrameGraph::FrameGraphResource*
         CreateFrameGraphBufferResource(const char* resourceName, FrameGraph::FrameGraphBufferCreateInfo& createInfo);
+        FrameGraph::FrameGraphResource* CreateFrameGraphUniformResource(const char* resourceName, uint64_t size);
 
         void PrecomputeIBL();
 
@@ -96,8 +110,12 @@ namespace MongooseVK
         FrameGraph::FrameGraphResource* brdfLUT;
         FrameGraph::FrameGraphResource* cameraBuffer;
         FrameGraph::FrameGraphResource* lightBuffer;
+        FrameGraph::FrameGraphResource* sceneLightsBuffer;
+        VkDeviceSize sceneLightsFrameSize = 0; // Region of one frame in flight in the scene lights buffer
 
     private:
+        FrameGraph::FrameGraphResourceHandle frameColorHandle{}; // Resolved after every Compile
+
         VulkanDevice* device;
         uint32_t activeImage = 0;
 
@@ -68,6 +68,7 @@ namespace MongooseVK
         struct DepthAttachment {
             ImageFormat depthFormat = ImageFormat::DEPTH24_STENCIL8;
             RenderPassOperation::LoadOp loadOp = RenderPassOperation::LoadOp::Clear;
+            VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // Loaded attachments always start as attachments
         };
 
         struct RenderPassConfig {
@@ -90,7 +91,8 @@ namespace MongooseVK
         VulkanRenderPass() {}
         ~VulkanRenderPass() = default;
 
-        void Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent);
+        void Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent,
+                   VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void End(VkCommandBuffer commandBuffer);
 
         [[nodiscard]] VkRenderPass Get() const { return renderPass; }
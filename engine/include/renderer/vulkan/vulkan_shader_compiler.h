@@ -1,19 +1,34 @@
 #pragma once
 
 #include <shaderc/shaderc.hpp>
+#include <unordered_map>
 
 #include "util/core.h"
 
 namespace MongooseVK
 {
+    constexpr auto SHADER_INCLUDE_PATH = "shader/glsl/includes/";
+
+    // Include files by the name shaders include them with
+    using ShaderIncludeCache = std::unordered_map<std::string, std::vector<char>>;
 
     struct CompilationInfo {
         std::string fileName;
         shaderc_shader_kind kind;
         std::vector<char> source{};
+        std::vector<std::string> defines{}; // Added as macros when the shader is preprocessed
         shaderc::CompileOptions options{};
     };
 
+    // Options every shader is compiled to SPIR-V with. shaderc can't report its options back, so they are kept
+    // here for the shader cache to key on. The defaults are the ones shaderc uses when nothing is set.
+    struct ShaderCompileSettings {
+        shaderc_target_env targetEnv = shaderc_target_env_vulkan;
+        shaderc_env_version targetEnvVersion = shaderc_env_version_vulkan_1_0;
+        shaderc_spirv_version spirvVersion = shaderc_spirv_version_1_0;
+        shaderc_optimization_level optimizationLevel = shaderc_optimization_level_zero;
+    };
+
     struct CompilationResult {
         bool success = false;
         std::vector<uint32_t> spirv;
@@ -22,23 +37,40 @@ namespace MongooseVK
 
     class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
     public:
+        explicit ShaderIncluder(const ShaderIncludeCache* _includeCache = nullptr): includeCache(_includeCache) {}
+
+        // Reads every file of SHADER_INCLUDE_PATH
+        static ShaderIncludeCache LoadIncludes();
+
         virtual shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source,
                                                    size_t include_depth) override;
 
         virtual void ReleaseInclude(shaderc_include_result* data) override;
+
+    private:
+        const ShaderIncludeCache* includeCache;
     };
 
     class VulkanShaderCompiler {
     public:
-        VulkanShaderCompiler();
+        // Includes are taken from the cache when given, it has to outlive the compiler
+        explicit VulkanShaderCompiler(const ShaderIncludeCache* _includeCache = nullptr, const ShaderCompileSettings& _settings = {});
         ~VulkanShaderCompiler();
 
+        // Replaces the source of the info with the file after includes and macros are resolved
         void PreprocessShader(CompilationInfo& info);
         void CompileFileToAssembly(CompilationInfo& info);
         std::vector<uint32_t> CompileFile(CompilationInfo& info);
 
+        // Compiles the source of an info PreprocessShader has been run on
+        std::vector<uint32_t> CompilePreprocessed(const CompilationInfo& info);
+
+        const ShaderCompileSettings& GetSettings() const { return settings; }
+
     private:
         shaderc::Compiler compiler;
+        ShaderCompileSettings settings;
         shaderc::CompileOptions options;
+        const ShaderIncludeCache* includeCache;
     };
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <vulkan/vulkan_core.h>
+
+#include "resource/resource.h"
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+
+    constexpr VkDeviceSize UNIFORM_RING_FRAME_SIZE = 256 * 1024;
+
+    // Suballocation of the uniform ring, only valid for the frame it was made in
+    struct UniformAllocation {
+        void* data = nullptr;
+        uint32_t offset = 0;         // Dynamic offset in the ring buffer
+        VkDeviceAddress address = 0; // For shaders reading it through a buffer reference
+    };
+
+    // Persistently mapped uniform buffer with a region per frame in flight. Per frame constants are suballocated
+    // from the region of the frame being recorded and bound with dynamic offsets. A region is only reused after
+    // the fence of its frame has been waited on, so the CPU never overwrites data the GPU is still reading.
+    class VulkanUniformRing {
+    public:
+        VulkanUniformRing(VulkanDevice* vulkanDevice, VkDeviceSize frameSize, uint32_t frameCount);
+        ~VulkanUniformRing();
+
+        VulkanUniformRing(const VulkanUniformRing&) = delete;
+        VulkanUniformRing& operator=(const VulkanUniformRing&) = delete;
+
+        // Starts suballocating from the region of the frame, the GPU has to be done with it
+        void BeginFrame(uint32_t frameIndex);
+
+        // Thread safe, offsets are aligned to minUniformBufferOffsetAlignment
+        UniformAllocation Allocate(VkDeviceSize size);
+
+        template<typename T>
+        UniformAllocation Push(const T& data)
+        {
+            const UniformAllocation allocation = Allocate(sizeof(T));
+            memcpy(allocation.data, &data, sizeof(T));
+            return allocation;
+        }
+
+        VkBuffer GetBuffer() const { return buffer.buffer; }
+        VkDeviceSize GetFrameSize() const { return frameSize; }
+        VkDeviceSize GetUsed() const { return frameUsed.load(std::memory_order_relaxed); }
+        VkDeviceSize GetPeakUsed() const { return peakUsed; }
+
+    private:
+        VulkanDevice* device;
+        AllocatedBuffer buffer{};
+
+        VkDeviceSize frameSize;
+        VkDeviceSize alignment;
+
+        VkDeviceSize frameBegin = 0;
+        std::atomic<VkDeviceSize> frameUsed = 0;
+        VkDeviceSize peakUsed = 0;
+    };
+}
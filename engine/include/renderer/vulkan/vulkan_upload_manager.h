@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "resource/resource.h"
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+    class VulkanTexture;
+    class Bitmap;
+
+    constexpr uint64_t UPLOAD_STAGING_RING_SIZE = 64 * 1024 * 1024;
+    constexpr uint64_t UPLOAD_BATCH_FLUSH_THRESHOLD = UPLOAD_STAGING_RING_SIZE / 4;
+    constexpr uint32_t UPLOAD_BATCH_COUNT = 8;
+
+    // Timeline semaphore value that is reached once the batch holding an upload has completed
+    typedef uint64_t UploadToken;
+    static UploadToken INVALID_UPLOAD_TOKEN = 0;
+
+    struct UploadStats {
+        uint64_t bytes = 0;
+        uint32_t copies = 0;
+        uint32_t batches = 0;
+        uint32_t dedicatedStagingBuffers = 0;
+    };
+
+    class VulkanUploadManager {
+    public:
+        explicit VulkanUploadManager(VulkanDevice* vulkanDevice);
+        ~VulkanUploadManager();
+
+        VulkanUploadManager(const VulkanUploadManager&) = delete;
+        VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+        UploadToken UploadBuffer(const AllocatedBuffer& dstBuffer, const void* data, uint64_t size, uint64_t dstOffset = 0);
+        UploadToken UploadTexture(VulkanTexture* texture, const void* data, uint64_t size);
+        UploadToken UploadCubemap(VulkanTexture* texture, const Bitmap* cubemap);
+
+        UploadToken Flush();
+        void Wait(UploadToken token);
+        void WaitIdle();
+        bool IsComplete(UploadToken token) const;
+
+        VkSemaphore GetTimelineSemaphore() const { return timelineSemaphore; }
+        bool HasDedicatedTransferQueue() const { return dedicatedTransferQueue; }
+
+        UploadStats GetStats();
+        void ResetStats();
+
+    private:
+        struct StagingAllocation {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            uint64_t offset = 0;
+            void* data = nullptr;
+        };
+
+        struct UploadBatch {
+            VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+            VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+
+            UploadToken token = INVALID_UPLOAD_TOKEN;
+            uint64_t stagingEnd = 0;
+            uint64_t bytes = 0;
+            bool recording = false;
+
+            std::vector<AllocatedBuffer> dedicatedStagingBuffers;
+        };
+
+        StagingAllocation AllocateStaging(uint64_t size, uint64_t alignment);
+        UploadBatch& GetRecordingBatch();
+        VkCommandBuffer GetOwnerCommandBuffer(const UploadBatch& batch) const;
+        UploadToken FinishUpload(UploadBatch& batch, uint64_t size);
+
+        void SubmitBatch(UploadBatch& batch);
+        void RetireCompletedBatches();
+        void WaitForValue(uint64_t value) const;
+
+        void TransferBufferOwnership(const UploadBatch& batch, VkBuffer buffer, uint64_t offset, uint64_t size) const;
+        void TransferImageOwnership(const UploadBatch& batch, VkImage image, const VkImageSubresourceRange& range) const;
+
+    private:
+        VulkanDevice* device;
+        std::mutex uploadMutex;
+
+        bool dedicatedTransferQueue = false;
+        uint32_t transferQueueFamily = 0;
+        uint32_t graphicsQueueFamily = 0;
+
+        VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+        VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
+        VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+        AllocatedBuffer stagingBuffer{};
+        uint64_t stagingHead = 0;
+        uint64_t stagingTail = 0;
+
+        std::array<UploadBatch, UPLOAD_BATCH_COUNT> batches{};
+        std::deque<uint32_t> inFlightBatches;
+        uint32_t currentBatch = 0;
+        uint64_t batchCounter = 0;
+        UploadToken lastSubmittedToken = INVALID_UPLOAD_TOKEN;
+
+        UploadStats stats{};
+    };
+}
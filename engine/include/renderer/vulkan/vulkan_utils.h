@@ -45,8 +45,10 @@ namespace MongooseVK::VulkanUtils
     struct QueueFamilyIndices {
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
+        std::optional<uint32_t> transferFamily;
 
         bool IsComplete() const { return graphicsFamily.has_value(); }
+        bool HasDedicatedTransfer() const { return transferFamily.has_value() && transferFamily != graphicsFamily; }
     };
 
     struct SwapChainSupportDetails {
@@ -368,7 +370,7 @@ namespace MongooseVK::VulkanUtils
         int i = 0;
         for (const auto& queueFamily: queue_families)
         {
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamily.has_value())
             {
                 indices.graphicsFamily = i;
             }
@@ -376,15 +378,21 @@ namespace MongooseVK::VulkanUtils
             VkBool32 presentSupport = 0;
             vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
 
-            if (presentSupport)
+            if (presentSupport && !indices.presentFamily.has_value())
                 indices.presentFamily = i;
 
-            if (indices.IsComplete())
-                break;
+            // Prefer a transfer-only family, it maps to the copy engine on most discrete GPUs
+            const bool transferOnly = queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+                                      !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+            if (transferOnly && !indices.transferFamily.has_value())
+                indices.transferFamily = i;
 
             i++;
         }
 
+        if (!indices.transferFamily.has_value())
+            indices.transferFamily = indices.graphicsFamily;
+
         return indices;
     }
 
@@ -711,6 +719,16 @@ namespace MongooseVK::VulkanUtils
         vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
     }
 
+    inline void InsertImageMemoryBarrier2(const VkCommandBuffer cmd, const VkImageMemoryBarrier2& imageMemoryBarrier)
+    {
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.imageMemoryBarrierCount = 1;
+        dependencyInfo.pImageMemoryBarriers = &imageMemoryBarrier;
+
+        vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+    }
+
     inline void InsertPipelineBarrier(const VkCommandBuffer cmd, const VkPipelineStageFlags srcStageMask,
                                       const VkPipelineStageFlags dstStageMask)
     {
@@ -743,14 +761,9 @@ namespace MongooseVK::VulkanUtils
         );
     }
 
-    inline void CopyImage(const VkCommandBuffer commandBuffer, AllocatedImage& srcImage, const VkImage dstImage, CopyParams params)
+    // The caller owns the layouts, the source has to be in TRANSFER_SRC and the destination in TRANSFER_DST
+    inline void CopyImage(const VkCommandBuffer commandBuffer, const AllocatedImage& srcImage, const VkImage dstImage, CopyParams params)
     {
-        TransitionImageLayout(commandBuffer, srcImage,
-                              VK_IMAGE_ASPECT_COLOR_BIT,
-                              VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                              VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                              1);
-
         VkImageCopy copyRegion{};
 
         copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -773,12 +786,6 @@ namespace MongooseVK::VulkanUtils
                        srcImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                        dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                        1, &copyRegion);
-
-        TransitionImageLayout(commandBuffer, srcImage,
-                              VK_IMAGE_ASPECT_COLOR_BIT,
-                              VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                              VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                              1);
     }
 
     inline VkDeviceMemory AllocateImageMemory(const VkDevice device, const VkPhysicalDevice physicalDevice, const VkImage image,
@@ -7,6 +7,7 @@
 #include <tiny_gltf/tiny_gltf.h>
 
 #include "renderer/scene.h"
+#include "resource/scene_cache.h"
 #include "util/core.h"
 
 namespace MongooseVK
@@ -21,7 +22,7 @@ namespace MongooseVK
 
         Ref<VulkanMesh> LoadMesh(VulkanDevice* device, const std::string& meshPath);
 
-        SceneGraph* LoadSceneGraph(VulkanDevice* device, const std::string& scenePath);
+        SceneGraph* LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const VertexFormat& vertexFormat = {});
 
     private:
         std::vector<TextureHandle> LoadTextures(VulkanDevice* device,
@@ -31,5 +32,7 @@ namespace MongooseVK
         std::vector<MaterialHandle> LoadMaterials(VulkanDevice* device,
                                                   const tinygltf::Model& model, const std::filesystem::path& parentPath);
 
+        BakedSceneData BakeScene(const tinygltf::Model& model, const std::filesystem::path& parentPath);
+
     };
 }
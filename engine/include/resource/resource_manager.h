@@ -24,10 +24,12 @@ namespace MongooseVK
         static Ref<VulkanMesh> LoadMesh(VulkanDevice* device, const std::string& meshPath);
 
         static void LoadTexture(VulkanDevice* device, const std::string& textureImagePath, std::vector<TextureHandle>* textureHandles);
+        static TextureHandle CreateTextureFromImage(VulkanDevice* device, const ImageResource& imageResource);
 
         static Bitmap LoadHDRCubeMapBitmap(VulkanDevice* device, const std::string& hdrPath);
         static void LoadAndSaveHDR(const std::string& hdrPath);
 
-        static SceneGraph* LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const std::string& skyboxPath);
+        static SceneGraph* LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const std::string& skyboxPath,
+                                          const VertexFormat& vertexFormat = {});
     };
 }
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "renderer/mesh.h"
+#include "renderer/mesh_cluster.h"
+#include "util/mapped_file.h"
+
+namespace MongooseVK
+{
+    class VulkanDevice;
+    struct SceneGraph;
+
+    constexpr uint32_t BAKED_SCENE_MAGIC = 0x534B564D; // "MVKS"
+    constexpr uint32_t BAKED_SCENE_VERSION = 3;
+    constexpr uint64_t BAKED_SCENE_SECTION_ALIGNMENT = 64;
+
+    struct BakedString {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct BakedMaterial {
+        glm::vec4 baseColor = glm::vec4(1.0f);
+        float metallic = 0.0f;
+        float roughness = 1.0f;
+        int32_t baseColorImage = -1;
+        int32_t metallicRoughnessImage = -1;
+        int32_t normalMapImage = -1;
+        uint32_t alphaTested = 0;
+    };
+
+    // Extra source files the scene was baked from, checked along with the scene file itself
+    struct BakedDependency {
+        BakedString path{};
+        int64_t modifiedTime = 0;
+        uint64_t size = 0;
+    };
+
+    // Nodes are stored in creation order, node i becomes scene node i + 1 as the root is implicit
+    struct BakedNode {
+        int64_t parent = 0;
+        int32_t mesh = -1;
+        BakedString name{};
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 rotation = glm::vec3(0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+    };
+
+    struct BakedMesh {
+        uint32_t firstPrimitive = 0;
+        uint32_t primitiveCount = 0;
+    };
+
+    struct BakedPrimitive {
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        uint32_t firstCluster = 0;
+        uint32_t clusterCount = 0;
+        int32_t materialIndex = -1;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+    };
+
+    // Flattened scene, either pointing into a mapped cache file or into BakedSceneData
+    struct BakedScene {
+        std::span<const char> strings;
+        std::span<const BakedString> images;
+        std::span<const BakedMaterial> materials;
+        std::span<const BakedNode> nodes;
+        std::span<const BakedMesh> meshes;
+        std::span<const BakedPrimitive> primitives;
+        std::span<const Vertex> vertices;
+        std::span<const uint32_t> indices;
+        std::span<const MeshCluster> clusters;
+        std::span<const BakedDependency> dependencies;
+
+        std::string_view GetString(const BakedString& string) const
+        {
+            return {strings.data() + string.offset, string.length};
+        }
+    };
+
+    struct BakedSceneData {
+        std::vector<char> strings;
+        std::vector<BakedString> images;
+        std::vector<BakedMaterial> materials;
+        std::vector<BakedNode> nodes;
+        std::vector<BakedMesh> meshes;
+        std::vector<BakedPrimitive> primitives;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MeshCluster> clusters;
+        std::vector<BakedDependency> dependencies;
+
+        BakedString AddString(const std::string& string)
+        {
+            const BakedString bakedString = {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(string.size())};
+            strings.insert(strings.end(), string.begin(), string.end());
+            return bakedString;
+        }
+
+        void AddDependency(const std::filesystem::path& path);
+
+        BakedScene GetView() const
+        {
+            return {strings, images, materials, nodes, meshes, primitives, vertices, indices, clusters, dependencies};
+        }
+    };
+
+    class SceneCache {
+    public:
+        SceneCache() = delete;
+
+        static std::filesystem::path GetCachePath(const std::string& scenePath);
+
+        // Maps the cache file of the scene if it is still valid for the source file
+        static bool Map(const std::string& scenePath, MappedFile& cacheFile, BakedScene& scene);
+        static bool Write(const std::string& scenePath, const BakedScene& scene);
+
+        // Creates the GPU resources, mesh data is encoded straight from the baked arrays into staging memory
+        static SceneGraph* CreateSceneGraph(VulkanDevice* device, const BakedScene& scene, const VertexFormat& vertexFormat = {});
+    };
+}
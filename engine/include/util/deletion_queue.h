@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MongooseVK
+{
+    // Deletions are stored in place like jobs, pushing one only allocates when the queue grows past its high-water mark
+    class DeletionQueue {
+    public:
+        static constexpr size_t STORAGE_SIZE = 48;
+
+        template<typename F>
+        void Push(F&& function)
+        {
+            using Function = std::decay_t<F>;
+            static_assert(sizeof(Function) <= STORAGE_SIZE, "Deletion captures have to fit the inline storage");
+            static_assert(alignof(Function) <= alignof(std::max_align_t), "Deletion captures are over aligned");
+            static_assert(std::is_trivially_copyable_v<Function>, "Deletions can only capture handles and pointers");
+
+            Deletion& deletion = deletions.emplace_back();
+            new(deletion.storage) Function(std::forward<F>(function));
+            deletion.invoke = [](void* storage) { (*std::launder(reinterpret_cast<Function*>(storage)))(); };
+        }
+
+        // Deletions pushed while flushing, e.g. the buffer of a material, wait for the next flush
+        void Flush()
+        {
+            std::swap(deletions, flushing);
+            for (Deletion& deletion: flushing) deletion.invoke(deletion.storage);
+            flushing.clear();
+        }
+
+    private:
+        struct Deletion {
+            alignas(std::max_align_t) std::byte storage[STORAGE_SIZE];
+            void (*invoke)(void* storage) = nullptr;
+        };
+
+        std::vector<Deletion> deletions{};
+        std::vector<Deletion> flushing{};
+    };
+}
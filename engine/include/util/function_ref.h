@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace MongooseVK
+{
+    template<typename Signature>
+    class FunctionRef;
+
+    // Non-owning view of a callable, never allocates. The callable has to outlive the call it is passed to, which
+    // holds for lambdas written in the argument list.
+    template<typename R, typename... Args>
+    class FunctionRef<R(Args...)> {
+    public:
+        template<typename F>
+            requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+        FunctionRef(F&& function)
+            : callable(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+              invoke([](void* storage, Args... args) -> R {
+                  return std::invoke(*static_cast<std::remove_reference_t<F>*>(storage), std::forward<Args>(args)...);
+              }) {}
+
+        R operator()(Args... args) const { return invoke(callable, std::forward<Args>(args)...); }
+
+    private:
+        void* callable;
+        R (*invoke)(void* storage, Args... args);
+    };
+}
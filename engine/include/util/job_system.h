@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "util/core.h"
+
+namespace MongooseVK
+{
+    // Captures have to fit in here, bigger state is captured by reference or pointer
+    constexpr size_t JOB_STORAGE_SIZE = 48;
+
+    // Jobs a single thread can have in flight, running more waits for the oldest one to finish
+    constexpr size_t JOB_RING_SIZE = 1024;
+
+    // Join handle for the jobs run with it, done once every one of them has finished. Has to outlive its jobs and
+    // the jobs depending on it.
+    class JobCounter {
+        friend class JobSystem;
+
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        std::atomic<uint32_t> pending = 0;
+    };
+
+    // Fixed size task, the callable is constructed in place so running a job never allocates
+    struct Job {
+        using InvokeFunction = void (*)(void* storage);
+
+        alignas(std::max_align_t) std::byte storage[JOB_STORAGE_SIZE];
+        std::atomic<InvokeFunction> invoke = nullptr; // Cleared once the job is done, the slot is free again
+        JobCounter* counter = nullptr;
+        const JobCounter* dependency = nullptr;
+    };
+
+    // Chase-Lev work stealing deque, the owning thread pushes and pops at the bottom, any thread steals from the top
+    class JobDeque {
+    public:
+        static constexpr int64_t CAPACITY = 2 * JOB_RING_SIZE;
+
+        bool Push(Job* job);
+        Job* Pop();
+        Job* Steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> top = 0;
+        alignas(64) std::atomic<int64_t> bottom = 0;
+        std::array<std::atomic<Job*>, CAPACITY> buffer{};
+    };
+
+    template<typename T>
+    class JobFuture;
+
+    // Work stealing scheduler, every worker and the thread that created it own a deque of jobs and idle workers
+    // steal from the others. Threads waiting on a counter execute jobs until it is done instead of blocking.
+    // Only the workers and the creating thread may run jobs.
+    class JobSystem {
+    public:
+        static JobSystem* Create(size_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        static JobSystem* Get() { return instance; }
+        static void Destroy();
+
+        // Runs the job on any thread once the dependency is done. The counter is incremented right away and
+        // decremented when the job has finished. Jobs must not throw.
+        template<typename F>
+        void Run(F&& function, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr)
+        {
+            using Function = std::decay_t<F>;
+            static_assert(sizeof(Function) <= JOB_STORAGE_SIZE, "Job captures have to fit the inline storage");
+            static_assert(alignof(Function) <= alignof(std::max_align_t), "Job captures are over aligned");
+
+            Job* job = AllocateJob();
+            new(job->storage) Function(std::forward<F>(function));
+
+            job->counter = counter;
+            job->dependency = dependency;
+            if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+            job->invoke.store([](void* storage) {
+                Function* callable = std::launder(reinterpret_cast<Function*>(storage));
+                (*callable)();
+                callable->~Function();
+            }, std::memory_order_release);
+
+            Schedule(job);
+        }
+
+        // Executes jobs on the calling thread until the counter is done
+        void Wait(const JobCounter& counter);
+
+        // Calls body(i) for every i in [0, count), split into jobs of grainSize indices. Returns once all are done.
+        template<typename F>
+        void ParallelFor(const uint32_t count, const uint32_t grainSize, F&& body)
+        {
+            const uint32_t grain = std::max(grainSize, 1u);
+
+            JobCounter counter;
+            for (uint32_t begin = 0; begin < count; begin += grain)
+            {
+                const uint32_t end = std::min(begin + grain, count);
+                Run([&body, begin, end] {
+                    for (uint32_t i = begin; i < end; i++)
+                        body(i);
+                }, &counter);
+            }
+
+            Wait(counter);
+        }
+
+        // Runs the task as a job and keeps its result, or right away when there is no job system
+        template<typename F>
+        static auto Async(F&& task) -> JobFuture<std::invoke_result_t<F>>;
+
+        size_t GetWorkerCount() const { return workers.size(); }
+
+        // Index of the calling worker in [0, GetWorkerCount()), the creating thread gets GetWorkerCount(). Lets
+        // threads pick per thread resources without locking.
+        size_t GetThreadIndex() const { return threadIndex == INVALID_THREAD_INDEX ? workers.size() : threadIndex; }
+
+    private:
+        explicit JobSystem(size_t workerCount);
+        ~JobSystem();
+
+        struct ThreadContext {
+            JobDeque deque{};
+            std::array<Job, JOB_RING_SIZE> jobs{};
+            size_t nextJob = 0;
+        };
+
+        Job* AllocateJob();
+        void Schedule(Job* job);
+        void Push(Job* job);
+        Job* FindJob();
+        void Execute(Job* job);
+        void ReleaseReadyJobs();
+        void WorkerLoop(size_t index);
+
+    private:
+        static JobSystem* instance;
+
+        static constexpr size_t INVALID_THREAD_INDEX = SIZE_MAX;
+        static thread_local size_t threadIndex;
+
+        std::thread::id creatorThread;
+        std::vector<std::thread> workers{};
+        std::vector<Scope<ThreadContext>> contexts{}; // One per worker, the creating thread's is last
+
+        // Jobs whose dependency is not done yet, checked whenever a job finishes
+        std::mutex blockedMutex;
+        std::vector<Job*> blockedJobs{};
+        std::atomic<size_t> blockedCount = 0;
+
+        // Idle workers sleep until a job is pushed
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        std::atomic<size_t> queuedJobs = 0;
+        std::atomic<size_t> sleepingWorkers = 0;
+        std::atomic<bool> stop = false;
+    };
+
+    // Result of a job run through JobSystem::Async, Get executes other jobs while waiting and rethrows whatever
+    // the task threw
+    template<typename T>
+    class JobFuture {
+        friend class JobSystem;
+
+    public:
+        JobFuture() = default;
+
+        T Get()
+        {
+            if (JobSystem* jobSystem = JobSystem::Get())
+                jobSystem->Wait(state->counter);
+
+            if (state->exception) std::rethrow_exception(state->exception);
+
+            if constexpr (!std::is_void_v<T>)
+                return std::move(*state->value);
+        }
+
+    private:
+        struct EmptyValue {};
+
+        struct State {
+            JobCounter counter{};
+            std::conditional_t<std::is_void_v<T>, EmptyValue, std::optional<T>> value{};
+            std::exception_ptr exception{};
+        };
+
+        template<typename F>
+        static void Resolve(State* state, F& function)
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                    function();
+                else
+                    state->value.emplace(function());
+            }
+            catch (...)
+            {
+                state->exception = std::current_exception();
+            }
+        }
+
+    private:
+        Scope<State> state = CreateScope<State>();
+    };
+
+    template<typename F>
+    auto JobSystem::Async(F&& task) -> JobFuture<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        using State = typename JobFuture<Result>::State;
+
+        JobFuture<Result> future;
+
+        if (!instance)
+        {
+            std::decay_t<F> function(std::forward<F>(task));
+            JobFuture<Result>::Resolve(future.state.get(), function);
+            return future;
+        }
+
+        State* state = future.state.get();
+        instance->Run([state, function = std::decay_t<F>(std::forward<F>(task))]() mutable {
+            JobFuture<Result>::Resolve(state, function);
+        }, &state->counter);
+
+        return future;
+    }
+}
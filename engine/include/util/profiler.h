@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Zones record where the CPU time of a thread goes, a capture writes them out as a Chrome trace_event JSON file
+// that chrome://tracing or Perfetto can open. Without ENABLE_PROFILER the macros compile to nothing.
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Names are kept as pointers until a capture is written, they have to be literals or interned
+#define PROFILE_SCOPE(name) const ::MongooseVK::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_FRAME() ::MongooseVK::Profiler::MarkFrame()
+#define PROFILE_THREAD(name) ::MongooseVK::Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(name)
+#endif
+
+namespace MongooseVK
+{
+    // Zones a thread keeps, older ones are overwritten. Captures longer than this per thread lose their start.
+    constexpr size_t PROFILER_RING_SIZE = 32 * 1024;
+
+    // Written by the owning thread only, captures read it from any thread without locking
+    struct ProfileEvent {
+        std::atomic<const char*> name = nullptr;
+        std::atomic<uint64_t> start = 0; // Nanoseconds since the profiler started
+        std::atomic<uint64_t> end = 0;
+    };
+
+    class Profiler {
+    public:
+        static uint64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        static void AddZone(const char* name, uint64_t start, uint64_t end);
+
+        // Shown as the thread name in the trace, the name is copied
+        static void SetThreadName(const std::string& name);
+
+        // Starts the next frame, finishes a frame capture once its frames are done
+        static void MarkFrame();
+
+        // Returns a copy that lives as long as the program, for names that are not literals
+        static const char* InternName(const std::string& name);
+
+        // Zones that end after BeginCapture are written by EndCapture
+        static void BeginCapture();
+        static bool EndCapture(const std::string& path);
+        static bool IsCapturing() { return capturing.load(std::memory_order_relaxed); }
+
+        // Captures the next frameCount frames and writes them once the last one is marked
+        static void CaptureFrames(uint32_t frameCount, const std::string& path);
+
+    private:
+        static bool WriteTrace(const std::string& path, uint64_t from, uint64_t to);
+
+    private:
+        static const std::chrono::steady_clock::time_point epoch;
+
+        static std::atomic<bool> capturing;
+        static uint64_t captureStart;
+
+        static uint32_t captureFramesLeft;
+        static std::string captureFramesPath;
+    };
+
+    class ProfileZone {
+    public:
+        explicit ProfileZone(const char* _name): name(_name), start(Profiler::Now()) {}
+        ~ProfileZone() { Profiler::AddZone(name, start, Profiler::Now()); }
+
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name;
+        uint64_t start;
+    };
+}
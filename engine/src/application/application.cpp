@@ -1,6 +1,8 @@
 #include "application/application.h"
+#include "renderer/vulkan/vulkan_device.h"
 #include "util/log.h"
-#include "util/thread_pool.h"
+#include "util/job_system.h"
+#include "util/profiler.h"
 
 namespace MongooseVK
 {
@@ -22,10 +24,16 @@ namespace MongooseVK
     Application::~Application()
     {
         delete window;
+        JobSystem::Destroy();
     }
 
     void Application::Init()
     {
+        PROFILE_THREAD("Main");
+
+        // Created before the window, the device sizes its per thread command pools by it
+        JobSystem::Create();
+
         WindowParams params;
         params.title = applicationInfo.windowTitle.c_str();
         params.width = applicationInfo.windowWidth;
@@ -34,8 +42,6 @@ namespace MongooseVK
         window = CreateWindow(params);
         window->SetOnWindowCloseCallback([&] { isRunning = false; });
 
-        ThreadPool::Create();
-
         isRunning = true;
     }
 
@@ -45,12 +51,17 @@ namespace MongooseVK
 
         while (isRunning)
         {
+            PROFILE_FRAME();
+
             const float time = glfwGetTime();
             const float deltaTime = time - lastFrameTime;
 
             lastFrameTime = time;
             window->OnUpdate(deltaTime);
         }
+
+        // The application is not torn down on exit, the pipelines of this run are kept from here
+        VulkanDevice::Get()->GetPipelineCache().Save();
     }
 
     Window* Application::CreateWindow(WindowParams params)
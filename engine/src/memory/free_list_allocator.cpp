@@ -0,0 +1,134 @@
+#include "memory/free_list_allocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "util/core.h"
+
+namespace MongooseVK
+{
+    void FreeListAllocator::Init(const uint64_t _capacity)
+    {
+        capacity = _capacity;
+        Reset();
+    }
+
+    void FreeListAllocator::Grow(const uint64_t newCapacity)
+    {
+        ASSERT(newCapacity >= capacity, "Free list allocator can not shrink");
+
+        const uint64_t oldCapacity = capacity;
+        capacity = newCapacity;
+
+        if (newCapacity > oldCapacity)
+            InsertFreeBlock(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    void FreeListAllocator::Reset()
+    {
+        used = 0;
+        freeBlocks.clear();
+
+        if (capacity > 0)
+            freeBlocks[0] = capacity;
+    }
+
+    uint64_t FreeListAllocator::Allocate(const uint64_t size, const uint64_t alignment)
+    {
+        if (size == 0) return INVALID_ALLOCATION_OFFSET;
+
+        // Best fit keeps the large blocks intact for big meshes
+        auto bestBlock = freeBlocks.end();
+        uint64_t bestWaste = UINT64_MAX;
+
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+        {
+            const auto [blockOffset, blockSize] = *it;
+            const uint64_t alignedOffset = (blockOffset + alignment - 1) / alignment * alignment;
+            const uint64_t padding = alignedOffset - blockOffset;
+
+            if (blockSize < size + padding) continue;
+
+            const uint64_t waste = blockSize - size;
+            if (waste < bestWaste)
+            {
+                bestBlock = it;
+                bestWaste = waste;
+                if (waste == padding) break;
+            }
+        }
+
+        if (bestBlock == freeBlocks.end()) return INVALID_ALLOCATION_OFFSET;
+
+        const auto [blockOffset, blockSize] = *bestBlock;
+        const uint64_t alignedOffset = (blockOffset + alignment - 1) / alignment * alignment;
+        const uint64_t padding = alignedOffset - blockOffset;
+
+        freeBlocks.erase(bestBlock);
+
+        // Alignment padding stays free in front of the allocation
+        if (padding > 0)
+            freeBlocks[blockOffset] = padding;
+
+        const uint64_t remaining = blockSize - padding - size;
+        if (remaining > 0)
+            freeBlocks[alignedOffset + size] = remaining;
+
+        used += size;
+        return alignedOffset;
+    }
+
+    void FreeListAllocator::Free(const uint64_t offset, const uint64_t size)
+    {
+        if (offset == INVALID_ALLOCATION_OFFSET || size == 0) return;
+
+        ASSERT(offset + size <= capacity, "Freed range is outside of the allocator");
+        ASSERT(used >= size, "Freeing more than allocated");
+
+        used -= size;
+        InsertFreeBlock(offset, size);
+    }
+
+    uint64_t FreeListAllocator::GetLargestFreeBlock() const
+    {
+        uint64_t largest = 0;
+        for (const auto& [offset, size]: freeBlocks)
+            largest = std::max(largest, size);
+
+        return largest;
+    }
+
+    float FreeListAllocator::GetFragmentation() const
+    {
+        const uint64_t freeSpace = capacity - used;
+        if (freeSpace == 0) return 0.0f;
+
+        return 1.0f - static_cast<float>(GetLargestFreeBlock()) / static_cast<float>(freeSpace);
+    }
+
+    void FreeListAllocator::InsertFreeBlock(uint64_t offset, uint64_t size)
+    {
+        auto next = freeBlocks.lower_bound(offset);
+
+        // Merge with the previous block if it ends right where this one starts
+        if (next != freeBlocks.begin())
+        {
+            const auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                freeBlocks.erase(previous);
+            }
+        }
+
+        // Merge with the next block if this one ends where it starts
+        if (next != freeBlocks.end() && offset + size == next->first)
+        {
+            size += next->second;
+            freeBlocks.erase(next);
+        }
+
+        freeBlocks[offset] = size;
+    }
+}
@@ -0,0 +1,53 @@
+#include "memory/linear_arena.h"
+
+#include <algorithm>
+
+namespace MongooseVK
+{
+    LinearArena::LinearArena(const size_t _capacity): capacity(_capacity)
+    {
+        memory = static_cast<std::byte*>(::operator new(capacity, std::align_val_t(alignof(std::max_align_t))));
+    }
+
+    LinearArena::~LinearArena()
+    {
+        Reset();
+        ::operator delete(memory, std::align_val_t(alignof(std::max_align_t)));
+    }
+
+    void* LinearArena::Allocate(const size_t size, const size_t alignment)
+    {
+        size_t current = offset.load(std::memory_order_relaxed);
+        size_t alignedOffset;
+
+        do
+        {
+            alignedOffset = (current + alignment - 1) & ~(alignment - 1);
+            if (alignedOffset + size > capacity) break;
+        }
+        while (!offset.compare_exchange_weak(current, alignedOffset + size, std::memory_order_relaxed));
+
+        if (alignedOffset + size <= capacity)
+            return memory + alignedOffset;
+
+        const auto overflowAlignment = std::align_val_t(std::max(alignment, alignof(std::max_align_t)));
+        void* allocation = ::operator new(size, overflowAlignment);
+
+        std::lock_guard lock(overflowMutex);
+        overflowAllocations.push_back({allocation, overflowAlignment});
+
+        return allocation;
+    }
+
+    void LinearArena::Reset()
+    {
+        peakUsed = std::max(peakUsed, GetUsed());
+        lastOverflowCount = static_cast<uint32_t>(overflowAllocations.size());
+        offset.store(0, std::memory_order_relaxed);
+
+        for (const OverflowAllocation& allocation: overflowAllocations)
+            ::operator delete(allocation.memory, allocation.alignment);
+
+        overflowAllocations.clear();
+    }
+}
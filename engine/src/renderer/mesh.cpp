@@ -0,0 +1,157 @@
+#include "renderer/mesh.h"
+
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+#include "util/core.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static glm::vec2 SignNotZero(const glm::vec2 v)
+        {
+            return {v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+        }
+
+        // Maps a unit vector onto the [-1, 1] square, decoded by OctahedralDecode in vertex_input.glslh
+        static glm::vec2 OctahedralEncode(const glm::vec3& n)
+        {
+            const float l1Norm = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+            if (l1Norm <= 0.0f) return glm::vec2(0.0f);
+
+            const glm::vec3 p = n / l1Norm;
+            if (p.z >= 0.0f) return {p.x, p.y};
+
+            return (1.0f - glm::abs(glm::vec2(p.y, p.x))) * SignNotZero({p.x, p.y});
+        }
+
+        static uint32_t PackTangent(const Vertex& vertex)
+        {
+            const glm::vec2 encoded = OctahedralEncode(vertex.tangent) * 0.5f + 0.5f;
+            const uint32_t x = static_cast<uint32_t>(glm::round(glm::clamp(encoded.x, 0.0f, 1.0f) * 32767.0f));
+            const uint32_t y = static_cast<uint32_t>(glm::round(glm::clamp(encoded.y, 0.0f, 1.0f) * 32767.0f));
+
+            const bool flipped = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+
+            return x | y << 15 | static_cast<uint32_t>(flipped) << 31;
+        }
+
+        static uint16_t QuantizeUnorm16(const float value)
+        {
+            return static_cast<uint16_t>(glm::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        }
+
+        template<typename T>
+        static void AppendElement(std::vector<uint8_t>& output, const T& element)
+        {
+            const size_t offset = output.size();
+            output.resize(offset + sizeof(T));
+            memcpy(output.data() + offset, &element, sizeof(T));
+        }
+    }
+
+    uint32_t VertexFormat::GetIndex() const
+    {
+        if (!packed) return 0;
+
+        return 1 | static_cast<uint32_t>(quantizedPosition) << 1 | static_cast<uint32_t>(vertexColor) << 2;
+    }
+
+    uint32_t VertexFormat::GetStreamCount() const
+    {
+        if (!packed) return 1;
+
+        return vertexColor ? 3 : 2;
+    }
+
+    uint32_t VertexFormat::GetStreamStride(const uint32_t stream) const
+    {
+        ASSERT(stream < GetStreamCount(), "Vertex stream out of range");
+
+        if (!packed) return sizeof(Vertex);
+
+        switch (stream)
+        {
+            case 0: return quantizedPosition ? sizeof(QuantizedPosition) : sizeof(glm::vec3);
+            case 1: return sizeof(PackedVertexAttributes);
+            default: return sizeof(uint32_t);
+        }
+    }
+
+    uint32_t VertexFormat::GetVertexSize() const
+    {
+        uint32_t size = 0;
+        for (uint32_t stream = 0; stream < GetStreamCount(); stream++)
+            size += GetStreamStride(stream);
+
+        return size;
+    }
+
+    std::vector<std::string> VertexFormat::GetShaderDefines() const
+    {
+        if (!packed) return {};
+
+        std::vector<std::string> defines = {"VERTEX_PACKED"};
+        if (quantizedPosition) defines.emplace_back("VERTEX_QUANTIZED_POSITION");
+        if (vertexColor) defines.emplace_back("VERTEX_COLOR");
+
+        return defines;
+    }
+
+    namespace VertexEncoding
+    {
+        void EncodeStream(const VertexFormat& format, const uint32_t stream, const std::span<const Vertex> vertices,
+                          const BoundingBox& bounds, std::vector<uint8_t>& output)
+        {
+            output.clear();
+            output.reserve(vertices.size() * format.GetStreamStride(stream));
+
+            if (!format.packed)
+            {
+                output.resize(vertices.size_bytes());
+                memcpy(output.data(), vertices.data(), vertices.size_bytes());
+                return;
+            }
+
+            if (stream == 0 && format.quantizedPosition)
+            {
+                const glm::vec3 size = bounds.max - bounds.min;
+                const glm::vec3 invSize = glm::vec3(size.x > 0.0f ? 1.0f / size.x : 0.0f,
+                                                    size.y > 0.0f ? 1.0f / size.y : 0.0f,
+                                                    size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+                for (const Vertex& vertex: vertices)
+                {
+                    const glm::vec3 normalized = (vertex.pos - bounds.min) * invSize;
+                    Utils::AppendElement(output, QuantizedPosition{
+                                             .x = Utils::QuantizeUnorm16(normalized.x),
+                                             .y = Utils::QuantizeUnorm16(normalized.y),
+                                             .z = Utils::QuantizeUnorm16(normalized.z),
+                                         });
+                }
+                return;
+            }
+
+            for (const Vertex& vertex: vertices)
+            {
+                switch (stream)
+                {
+                    case 0:
+                        Utils::AppendElement(output, vertex.pos);
+                        break;
+                    case 1:
+                        Utils::AppendElement(output, PackedVertexAttributes{
+                                                 .normal = glm::packSnorm2x16(Utils::OctahedralEncode(vertex.normal)),
+                                                 .tangent = Utils::PackTangent(vertex),
+                                                 .texCoord = glm::packHalf2x16(vertex.texCoord),
+                                             });
+                        break;
+                    default:
+                        Utils::AppendElement(output, glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f)));
+                        break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#include "renderer/mesh_cluster.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        // Spreads the low 10 bits of value so there are two zero bits between each of them
+        static uint32_t SpreadBits(uint32_t value)
+        {
+            value &= 0x3FF;
+            value = (value | value << 16) & 0x030000FF;
+            value = (value | value << 8) & 0x0300F00F;
+            value = (value | value << 4) & 0x030C30C3;
+            value = (value | value << 2) & 0x09249249;
+            return value;
+        }
+
+        static uint32_t GetMortonCode(const glm::vec3& normalizedPosition)
+        {
+            const glm::uvec3 cell = glm::uvec3(glm::clamp(normalizedPosition, 0.0f, 1.0f) * 1023.0f);
+            return SpreadBits(cell.x) | SpreadBits(cell.y) << 1 | SpreadBits(cell.z) << 2;
+        }
+
+        static MeshCluster FinishCluster(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices,
+                                         const uint32_t firstIndex, const uint32_t indexCount)
+        {
+            const std::span<const uint32_t> clusterIndices = indices.subspan(firstIndex, indexCount);
+
+            BoundingBox bounds{};
+            for (const uint32_t index: clusterIndices)
+                bounds.Expand(vertices[index].pos);
+
+            MeshCluster cluster{};
+            cluster.center = bounds.GetCenter();
+            cluster.firstIndex = firstIndex;
+            cluster.indexCount = indexCount;
+
+            for (const uint32_t index: clusterIndices)
+                cluster.radius = glm::max(cluster.radius, glm::length(vertices[index].pos - cluster.center));
+
+            // Normal cone from the geometric triangle normals, degenerate triangles do not constrain it
+            std::vector<glm::vec3> normals;
+            normals.reserve(indexCount / 3);
+
+            glm::vec3 normalSum = glm::vec3(0.0f);
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+            {
+                const glm::vec3& p0 = vertices[clusterIndices[i + 0]].pos;
+                const glm::vec3& p1 = vertices[clusterIndices[i + 1]].pos;
+                const glm::vec3& p2 = vertices[clusterIndices[i + 2]].pos;
+
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float length = glm::length(normal);
+                if (length <= std::numeric_limits<float>::epsilon()) continue;
+
+                normals.push_back(normal / length);
+                normalSum += normals.back();
+            }
+
+            const float axisLength = glm::length(normalSum);
+            if (normals.empty() || axisLength <= std::numeric_limits<float>::epsilon()) return cluster;
+
+            const glm::vec3 axis = normalSum / axisLength;
+
+            float minDot = 1.0f;
+            for (const glm::vec3& normal: normals)
+                minDot = glm::min(minDot, glm::dot(axis, normal));
+
+            // Cones of 90 degrees or wider can face the viewer from every direction
+            if (minDot <= 0.0f) return cluster;
+
+            cluster.coneAxis = axis;
+            cluster.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+
+            return cluster;
+        }
+    }
+
+    namespace MeshClustering
+    {
+        std::vector<MeshCluster> BuildClusters(const std::span<const Vertex> vertices, const std::span<uint32_t> indices)
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+            if (triangleCount == 0) return {};
+
+            // Sort triangles by the Morton code of their centroid so consecutive triangles are spatially close
+            const BoundingBox bounds = BoundingBox::FromVertices(vertices);
+            const glm::vec3 size = bounds.max - bounds.min;
+            const glm::vec3 invSize = glm::vec3(size.x > 0.0f ? 1.0f / size.x : 0.0f,
+                                                size.y > 0.0f ? 1.0f / size.y : 0.0f,
+                                                size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+            std::vector<std::pair<uint32_t, uint32_t>> triangleOrder(triangleCount);
+            for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                const glm::vec3 centroid = (vertices[indices[triangle * 3 + 0]].pos +
+                                            vertices[indices[triangle * 3 + 1]].pos +
+                                            vertices[indices[triangle * 3 + 2]].pos) / 3.0f;
+
+                triangleOrder[triangle] = {Utils::GetMortonCode((centroid - bounds.min) * invSize), triangle};
+            }
+
+            std::ranges::sort(triangleOrder);
+
+            const std::vector<uint32_t> sourceIndices(indices.begin(), indices.begin() + triangleCount * 3);
+            for (uint32_t i = 0; i < triangleCount; i++)
+            {
+                const uint32_t triangle = triangleOrder[i].second;
+                indices[i * 3 + 0] = sourceIndices[triangle * 3 + 0];
+                indices[i * 3 + 1] = sourceIndices[triangle * 3 + 1];
+                indices[i * 3 + 2] = sourceIndices[triangle * 3 + 2];
+            }
+
+            // Greedy split, a vertex belongs to the current cluster when it is tagged with its id
+            std::vector<MeshCluster> clusters;
+            std::vector<uint32_t> vertexTags(vertices.size(), std::numeric_limits<uint32_t>::max());
+
+            uint32_t clusterId = 0;
+            uint32_t clusterFirstIndex = 0;
+            uint32_t clusterVertexCount = 0;
+            uint32_t clusterTriangleCount = 0;
+
+            const auto CountNewVertices = [&](const uint32_t firstIndex) {
+                uint32_t count = 0;
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    const uint32_t index = indices[firstIndex + i];
+                    const bool duplicate = (i > 0 && index == indices[firstIndex]) || (i > 1 && index == indices[firstIndex + 1]);
+                    if (vertexTags[index] != clusterId && !duplicate) count++;
+                }
+                return count;
+            };
+
+            for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                const uint32_t firstIndex = triangle * 3;
+
+                if (clusterTriangleCount == MESH_CLUSTER_MAX_TRIANGLES ||
+                    clusterVertexCount + CountNewVertices(firstIndex) > MESH_CLUSTER_MAX_VERTICES)
+                {
+                    clusters.push_back(Utils::FinishCluster(vertices, indices, clusterFirstIndex, firstIndex - clusterFirstIndex));
+
+                    clusterId++;
+                    clusterFirstIndex = firstIndex;
+                    clusterVertexCount = 0;
+                    clusterTriangleCount = 0;
+                }
+
+                clusterVertexCount += CountNewVertices(firstIndex);
+                clusterTriangleCount++;
+
+                for (uint32_t i = 0; i < 3; i++)
+                    vertexTags[indices[firstIndex + i]] = clusterId;
+            }
+
+            clusters.push_back(Utils::FinishCluster(vertices, indices, clusterFirstIndex, triangleCount * 3 - clusterFirstIndex));
+
+            return clusters;
+        }
+
+        MeshCluster MakeBoundingCluster(const BoundingBox& bounds, const uint32_t indexCount)
+        {
+            return {
+                .center = bounds.GetCenter(),
+                .radius = glm::length(bounds.GetExtent()),
+                .indexCount = indexCount,
+            };
+        }
+    }
+}
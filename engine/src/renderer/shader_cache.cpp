@@ -1,15 +1,30 @@
 #include "renderer/shader_cache.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <renderer/vulkan/vulkan_device.h>
 
 #include "util/filesystem.h"
+#include "util/job_system.h"
 #include "util/log.h"
-#include "renderer/vulkan/vulkan_shader_compiler.h"
+#include "util/mapped_file.h"
 
 namespace MongooseVK
 {
     namespace Utils
     {
+        static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+        struct ShaderCacheHeader {
+            uint32_t magic = SHADER_CACHE_MAGIC;
+            uint32_t version = SHADER_CACHE_VERSION;
+            uint64_t key = 0;
+            uint64_t wordCount = 0;
+            uint64_t spirvHash = 0;
+        };
+
         shaderc_shader_kind GetShaderKindFromExtension(const std::filesystem::path& extension)
         {
             if (extension == ".vert") return shaderc_glsl_vertex_shader;
@@ -20,23 +35,205 @@ namespace MongooseVK
             ASSERT(false, "Unknown shader extension");
             return shaderc_glsl_vertex_shader;
         }
+
+        // FNV-1a, chained through the seed to hash several fields into one key
+        static uint64_t HashBytes(const void* data, const uint64_t size, uint64_t hash = 14695981039346656037ull)
+        {
+            const auto bytes = static_cast<const uint8_t*>(data);
+            for (uint64_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        // Everything the SPIR-V depends on: the options it is compiled with, the defines and the preprocessed source.
+        // shaderc ships with the SDK, so the header version stands in for its version next to the SPIR-V version it
+        // supports.
+        static uint64_t GetShaderCacheKey(const CompilationInfo& info, const ShaderCompileSettings& settings)
+        {
+            unsigned int spirvVersion = 0, spirvRevision = 0;
+            shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+            const uint32_t compilerKey[] = {
+                SHADER_CACHE_VERSION,
+                static_cast<uint32_t>(info.kind),
+                spirvVersion,
+                spirvRevision,
+                VK_HEADER_VERSION_COMPLETE,
+                static_cast<uint32_t>(settings.targetEnv),
+                static_cast<uint32_t>(settings.targetEnvVersion),
+                static_cast<uint32_t>(settings.spirvVersion),
+                static_cast<uint32_t>(settings.optimizationLevel),
+            };
+
+            uint64_t hash = HashBytes(compilerKey, sizeof(compilerKey));
+
+            // Hashed with their terminators so "A" "B" and "AB" differ
+            for (const std::string& define: info.defines)
+                hash = HashBytes(define.c_str(), define.size() + 1, hash);
+
+            return HashBytes(info.source.data(), info.source.size(), hash);
+        }
+
+        static std::filesystem::path GetShaderCachePath(const std::string& fileName, const uint64_t key)
+        {
+            char keyString[17];
+            snprintf(keyString, sizeof(keyString), "%016llx", static_cast<unsigned long long>(key));
+
+            return std::filesystem::path(SHADER_CACHE_PATH) / (std::filesystem::path(fileName).filename().string() + "_" + keyString + ".spv");
+        }
+
+        static bool ReadShaderCache(const std::filesystem::path& cachePath, const uint64_t key, std::vector<uint32_t>& spirv)
+        {
+            if (!std::filesystem::exists(cachePath)) return false;
+
+            const MappedFile cacheFile(cachePath);
+            if (!cacheFile.IsOpen() || cacheFile.GetSize() < sizeof(ShaderCacheHeader)) return false;
+
+            ShaderCacheHeader header{};
+            memcpy(&header, cacheFile.GetData(), sizeof(header));
+
+            const uint8_t* words = cacheFile.GetData() + sizeof(header);
+            if (header.magic != SHADER_CACHE_MAGIC ||
+                header.version != SHADER_CACHE_VERSION ||
+                header.key != key ||
+                header.wordCount == 0 ||
+                header.wordCount * sizeof(uint32_t) != cacheFile.GetSize() - sizeof(header) ||
+                header.spirvHash != HashBytes(words, header.wordCount * sizeof(uint32_t)))
+            {
+                LOG_WARN("Shader cache is corrupted: " + cachePath.string());
+                return false;
+            }
+
+            spirv.resize(header.wordCount);
+            memcpy(spirv.data(), words, header.wordCount * sizeof(uint32_t));
+
+            return spirv[0] == SPIRV_MAGIC;
+        }
+
+        static void WriteShaderCache(const std::filesystem::path& cachePath, const uint64_t key, const std::vector<uint32_t>& spirv)
+        {
+            const ShaderCacheHeader header{
+                .key = key,
+                .wordCount = spirv.size(),
+                .spirvHash = HashBytes(spirv.data(), spirv.size() * sizeof(uint32_t)),
+            };
+
+            const std::filesystem::path tempPath = cachePath.string() + ".tmp";
+
+            std::error_code error;
+            std::filesystem::create_directories(cachePath.parent_path(), error);
+
+            // Written next to the final file and renamed, a crash never leaves a half written cache behind
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+
+                if (!file.good())
+                {
+                    LOG_WARN("Failed to write shader cache: " + tempPath.string());
+                    file.close();
+                    std::filesystem::remove(tempPath, error);
+                    return;
+                }
+            }
+
+            std::filesystem::rename(tempPath, cachePath, error);
+            if (error)
+            {
+                LOG_WARN("Failed to store shader cache: " + cachePath.string());
+                std::filesystem::remove(tempPath, error);
+            }
+        }
     }
 
     std::unordered_map<std::string, std::vector<uint32_t>> ShaderCache::shaderCache;
+    ShaderIncludeCache ShaderCache::includeCache;
+
+    std::atomic<uint32_t> ShaderCache::cacheHits = 0;
+    std::atomic<uint32_t> ShaderCache::cacheMisses = 0;
 
     void ShaderCache::Load()
     {
-        VulkanShaderCompiler compiler;
-        const auto glslFiles = FileSystem::GetFilesFromDirectory(SHADER_PATH, true);
+        // Sorted so the shaders are always stored in the same order, whichever job finishes first
+        std::vector<std::filesystem::path> glslFiles = FileSystem::GetFilesFromDirectory(SHADER_PATH, true);
+        std::ranges::sort(glslFiles);
+
+        includeCache = ShaderIncluder::LoadIncludes();
+
+        const uint32_t hitsBefore = cacheHits.load();
+        const uint32_t missesBefore = cacheMisses.load();
+
+        // shaderc compilers aren't thread safe, every thread the jobs run on gets its own
+        JobSystem* jobSystem = JobSystem::Get();
+        std::vector<Scope<VulkanShaderCompiler>> compilers(jobSystem->GetWorkerCount() + 1);
+        std::vector<std::vector<uint32_t>> results(glslFiles.size());
+
+        jobSystem->ParallelFor(static_cast<uint32_t>(glslFiles.size()), 1, [&](const uint32_t i) {
+            Scope<VulkanShaderCompiler>& compiler = compilers[jobSystem->GetThreadIndex()];
+            if (!compiler) compiler = CreateScope<VulkanShaderCompiler>(&includeCache);
 
-        for (const auto& file: glslFiles)
-        {
             CompilationInfo compilationInfo;
-            compilationInfo.fileName = SHADER_PATH + file.filename().string();
-            compilationInfo.kind = Utils::GetShaderKindFromExtension(file.extension());
+            compilationInfo.fileName = SHADER_PATH + glslFiles[i].filename().string();
+            compilationInfo.kind = Utils::GetShaderKindFromExtension(glslFiles[i].extension());
+
+            results[i] = Compile(compilationInfo, *compiler);
+        });
+
+        for (size_t i = 0; i < glslFiles.size(); i++)
+            shaderCache[glslFiles[i].filename().string()] = std::move(results[i]);
+
+        LOG_INFO("Shader cache: {} hits, {} misses", cacheHits.load() - hitsBefore, cacheMisses.load() - missesBefore);
+    }
+
+    const std::vector<uint32_t>& ShaderCache::GetShader(const std::string& shaderName, const std::vector<std::string>& defines)
+    {
+        if (defines.empty()) return shaderCache.at(shaderName);
 
-            const std::vector<uint32_t> sprv_source = compiler.CompileFile(compilationInfo);
-            shaderCache[file.filename().string()] = sprv_source;
+        std::string variantName = shaderName;
+        for (const auto& define: defines)
+            variantName.append("#").append(define);
+
+        const auto it = shaderCache.find(variantName);
+        if (it != shaderCache.end()) return it->second;
+
+        CompilationInfo compilationInfo;
+        compilationInfo.fileName = SHADER_PATH + shaderName;
+        compilationInfo.kind = Utils::GetShaderKindFromExtension(std::filesystem::path(shaderName).extension());
+
+        compilationInfo.defines = defines;
+
+        VulkanShaderCompiler compiler(&includeCache);
+        shaderCache[variantName] = Compile(compilationInfo, compiler);
+
+        return shaderCache[variantName];
+    }
+
+    std::vector<uint32_t> ShaderCache::Compile(CompilationInfo& info, VulkanShaderCompiler& compiler)
+    {
+        compiler.PreprocessShader(info);
+
+        const uint64_t key = Utils::GetShaderCacheKey(info, compiler.GetSettings());
+        const std::filesystem::path cachePath = Utils::GetShaderCachePath(info.fileName, key);
+
+        std::vector<uint32_t> spirv{};
+        if (Utils::ReadShaderCache(cachePath, key, spirv))
+        {
+            LOG_TRACE("Shader cache hit: " + cachePath.string());
+            cacheHits++;
+            return spirv;
         }
+
+        LOG_TRACE("Shader cache miss: " + cachePath.string());
+        cacheMisses++;
+
+        spirv = compiler.CompilePreprocessed(info);
+        Utils::WriteShaderCache(cachePath, key, spirv);
+
+        return spirv;
     }
 }
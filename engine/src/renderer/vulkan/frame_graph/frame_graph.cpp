@@ -1,10 +1,21 @@
 #include "renderer/frame_graph/frame_graph.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
 #include <ranges>
+#include <stdexcept>
+#include <renderer/vulkan/vulkan_framebuffer.h>
 #include <renderer/vulkan/vulkan_renderer.h>
 #include <renderer/vulkan/vulkan_texture.h>
+#include <renderer/vulkan/vulkan_utils.h>
+#include <renderer/vulkan/pass/culling_pass.h>
+#include <renderer/vulkan/pass/depth_pyramid_pass.h>
+#include <renderer/vulkan/pass/forward_pass.h>
 #include <renderer/vulkan/pass/gbufferPass.h>
 #include <renderer/vulkan/pass/infinite_grid_pass.h>
+#include <renderer/vulkan/pass/light_clustering_pass.h>
 #include <renderer/vulkan/pass/lighting_pass.h>
 #include <renderer/vulkan/pass/shadow_map_pass.h>
 #include <renderer/vulkan/pass/skybox_pass.h>
@@ -12,14 +23,373 @@
 #include <renderer/vulkan/pass/post_processing/ssao_pass.h>
 #include <renderer/vulkan/pass/post_processing/tone_mapping_pass.h>
 #include <tiny_gltf/tiny_gltf.h>
+#include <util/job_system.h>
+#include <util/profiler.h>
 
 namespace MongooseVK
 {
     namespace FrameGraph
     {
+        namespace Utils
+        {
+            // Layout and synchronization scope of one use of a resource by a pass
+            struct ResourceAccess {
+                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+                VkAccessFlags2 access = VK_ACCESS_2_NONE;
+                bool write = false;
+                bool discard = false; // The previous contents are overwritten entirely
+            };
+
+            // Tracked from pass to pass, a barrier is only needed where the next access conflicts with it
+            struct ResourceState {
+                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                VkPipelineStageFlags2 writeStages = VK_PIPELINE_STAGE_2_NONE; // Last write or layout transition
+                VkAccessFlags2 writeAccess = VK_ACCESS_2_NONE;
+                VkPipelineStageFlags2 readStages = VK_PIPELINE_STAGE_2_NONE; // Every read since then
+                VkPipelineStageFlags2 visibleStages = VK_PIPELINE_STAGE_2_NONE; // Where the last write is already visible
+                VkAccessFlags2 visibleAccess = VK_ACCESS_2_NONE;
+            };
+
+            struct BarrierScope {
+                VkPipelineStageFlags2 srcStages = VK_PIPELINE_STAGE_2_NONE;
+                VkAccessFlags2 srcAccess = VK_ACCESS_2_NONE;
+                VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_NONE;
+                VkAccessFlags2 dstAccess = VK_ACCESS_2_NONE;
+                VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                VkImageLayout newLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            };
+
+            static VkImageAspectFlags GetBarrierAspectMask(const ImageFormat format)
+            {
+                if (format == ImageFormat::DEPTH24_STENCIL8)
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                if (format == ImageFormat::DEPTH32)
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+
+            static ResourceAccess GetInputAccess(const FrameGraphResource* resource, const VkPipelineStageFlags2 shaderStages)
+            {
+                if (resource->type == ResourceUsage::Type::Buffer)
+                {
+                    const bool storageBuffer = resource->bufferInfo.usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+                    return {
+                        .stages = shaderStages,
+                        .access = storageBuffer ? VK_ACCESS_2_SHADER_STORAGE_READ_BIT : VK_ACCESS_2_UNIFORM_READ_BIT,
+                    };
+                }
+
+                return {
+                    .layout = ImageUtils::GetShaderReadLayoutFromFormat(resource->textureInfo.format),
+                    .stages = shaderStages,
+                    .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                };
+            }
+
+            static ResourceAccess GetOutputAccess(const FrameGraphResource* resource, const ResourceUsage usage,
+                                                  const VkPipelineStageFlags2 shaderStages)
+            {
+                const bool read = usage.access != ResourceUsage::Access::Write;
+                const bool write = usage.access != ResourceUsage::Access::Read;
+
+                ResourceAccess resourceAccess{
+                    .write = write,
+                    .discard = !read,
+                };
+
+                switch (usage.usage)
+                {
+                    case ResourceUsage::Usage::ColorAttachment:
+                    case ResourceUsage::Usage::DepthStencil:
+                        // Attachments are told apart by their format, like the render passes do
+                        if (IsDepthFormat(resource->textureInfo.format))
+                        {
+                            // Depth testing reads the attachment even when it was cleared
+                            resourceAccess.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                            resourceAccess.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                                                    VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+                            resourceAccess.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                    (write ? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_NONE);
+                        } else
+                        {
+                            resourceAccess.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                            resourceAccess.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+                            resourceAccess.access = (read ? VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT : VK_ACCESS_2_NONE) |
+                                                    (write ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_NONE);
+                        }
+                        break;
+                    case ResourceUsage::Usage::Storage:
+                        resourceAccess.layout = resource->type == ResourceUsage::Type::Texture
+                                                    ? VK_IMAGE_LAYOUT_GENERAL
+                                                    : VK_IMAGE_LAYOUT_UNDEFINED;
+                        resourceAccess.stages = shaderStages;
+                        resourceAccess.access = (read ? VK_ACCESS_2_SHADER_STORAGE_READ_BIT : VK_ACCESS_2_NONE) |
+                                                (write ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT : VK_ACCESS_2_NONE);
+
+                        // Passes clearing their storage outputs before the dispatch list the clear stage
+                        if (write && (shaderStages & VK_PIPELINE_STAGE_2_CLEAR_BIT))
+                            resourceAccess.access |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+                        break;
+                    case ResourceUsage::Usage::TransferSource:
+                        resourceAccess.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                        resourceAccess.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+                        resourceAccess.access = VK_ACCESS_2_TRANSFER_READ_BIT;
+                        break;
+                    case ResourceUsage::Usage::Sampled:
+                    case ResourceUsage::Usage::UniformBuffer:
+                        return GetInputAccess(resource, shaderStages);
+                }
+
+                return resourceAccess;
+            }
+
+            // Moves the state past the access, returns the barrier that has to come before it if there is a hazard
+            static std::optional<BarrierScope> ApplyAccess(ResourceState& state, const ResourceAccess& access, const bool isTexture)
+            {
+                const bool layoutTransition = isTexture && state.layout != access.layout;
+
+                // Write after read or write, a layout transition is a write as well
+                if (access.write || layoutTransition)
+                {
+                    const BarrierScope scope{
+                        .srcStages = state.writeStages | state.readStages,
+                        .srcAccess = state.writeAccess,
+                        .dstStages = access.stages,
+                        .dstAccess = access.access,
+                        .oldLayout = layoutTransition && access.discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout,
+                        .newLayout = access.layout,
+                    };
+
+                    const bool hazard = layoutTransition || scope.srcStages != VK_PIPELINE_STAGE_2_NONE;
+
+                    state = {
+                        .layout = access.layout,
+                        .writeStages = access.stages,
+                        .writeAccess = access.write ? access.access : VK_ACCESS_2_NONE,
+                        .readStages = access.write ? VK_PIPELINE_STAGE_2_NONE : access.stages,
+                        .visibleStages = access.write ? VK_PIPELINE_STAGE_2_NONE : access.stages,
+                        .visibleAccess = access.write ? VK_ACCESS_2_NONE : access.access,
+                    };
+
+                    if (!hazard) return std::nullopt;
+                    return scope;
+                }
+
+                // Read after write, only once per stage and access
+                state.readStages |= access.stages;
+
+                if (state.writeStages == VK_PIPELINE_STAGE_2_NONE) return std::nullopt;
+                if (!(access.stages & ~state.visibleStages) && !(access.access & ~state.visibleAccess)) return std::nullopt;
+
+                state.visibleStages |= access.stages;
+                state.visibleAccess |= access.access;
+
+                return BarrierScope{
+                    .srcStages = state.writeStages,
+                    .srcAccess = state.writeAccess,
+                    .dstStages = access.stages,
+                    .dstAccess = access.access,
+                    .oldLayout = state.layout,
+                    .newLayout = state.layout,
+                };
+            }
+
+            static void AddBarrier(VulkanDevice* device, BarrierBatch& batch, const FrameGraphResource* resource,
+                                   const BarrierScope& scope)
+            {
+                if (resource->type == ResourceUsage::Type::Buffer)
+                {
+                    batch.bufferBarriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                        .srcStageMask = scope.srcStages,
+                        .srcAccessMask = scope.srcAccess,
+                        .dstStageMask = scope.dstStages,
+                        .dstAccessMask = scope.dstAccess,
+                        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .buffer = resource->allocatedBuffer.buffer,
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE,
+                    });
+                    return;
+                }
+
+                const VulkanTexture* texture = device->GetTexture(resource->textureHandle);
+                batch.imageBarriers.push_back({
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    .srcStageMask = scope.srcStages,
+                    .srcAccessMask = scope.srcAccess,
+                    .dstStageMask = scope.dstStages,
+                    .dstAccessMask = scope.dstAccess,
+                    .oldLayout = scope.oldLayout,
+                    .newLayout = scope.newLayout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = texture->GetImage(),
+                    .subresourceRange = {
+                        .aspectMask = GetBarrierAspectMask(resource->textureInfo.format),
+                        .baseMipLevel = 0,
+                        .levelCount = VK_REMAINING_MIP_LEVELS,
+                        .baseArrayLayer = 0,
+                        .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                    },
+                });
+            }
+
+            // Graph texture that holds nothing outside of [firstPass, lastPass] of the pass order
+            struct TransientTexture {
+                FrameGraphResource* resource = nullptr;
+                VkMemoryRequirements memoryRequirements{};
+                uint32_t firstPass = 0;
+                uint32_t lastPass = 0;
+
+                uint32_t heap = 0;
+                VkDeviceSize offset = 0;
+            };
+
+            struct TransientHeap {
+                VkDeviceSize size = 0;
+                VkDeviceSize alignment = 1;
+                uint32_t memoryTypeBits = 0;
+                std::vector<uint32_t> textures{};
+            };
+
+            static VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+            {
+                return (value + alignment - 1) / alignment * alignment;
+            }
+
+            static bool IsOverlapping(const TransientTexture& a, const TransientTexture& b)
+            {
+                return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+            }
+
+            // Lowest offset of the heap where the texture does not overlap any texture placed there that is alive at
+            // the same time
+            static std::optional<VkDeviceSize> FindHeapOffset(const std::vector<TransientTexture>& textures,
+                                                              const TransientHeap& heap, const TransientTexture& texture)
+            {
+                std::vector<const TransientTexture*> occupied;
+                for (const uint32_t placed: heap.textures)
+                {
+                    if (IsOverlapping(textures[placed], texture))
+                        occupied.push_back(&textures[placed]);
+                }
+
+                std::ranges::sort(occupied, {}, &TransientTexture::offset);
+
+                const VkMemoryRequirements& requirements = texture.memoryRequirements;
+                VkDeviceSize offset = 0;
+                for (const TransientTexture* placed: occupied)
+                {
+                    if (AlignUp(offset, requirements.alignment) + requirements.size <= placed->offset) break;
+                    offset = std::max(offset, placed->offset + placed->memoryRequirements.size);
+                }
+
+                offset = AlignUp(offset, requirements.alignment);
+                if (offset + requirements.size > heap.size) return std::nullopt;
+
+                return offset;
+            }
+        }
+
+        void BarrierBatch::Record(const VkCommandBuffer cmd) const
+        {
+            if (imageBarriers.empty() && bufferBarriers.empty()) return;
+
+            const VkDependencyInfo dependencyInfo{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size()),
+                .pBufferMemoryBarriers = bufferBarriers.data(),
+                .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+                .pImageMemoryBarriers = imageBarriers.data(),
+            };
+
+            vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+        }
+
+        void FrameGraphCommandRecorder::Record(VulkanDevice* vulkanDevice, FrameGraphRenderPass* renderPass, SceneGraph* scene)
+        {
+            PROFILE_SCOPE(renderPass->GetProfileName());
+
+            device = vulkanDevice;
+            segments.clear();
+
+            renderPass->SetCommandRecorder(this);
+            renderPass->Render(BeginSegment(nullptr, nullptr), scene);
+            renderPass->SetCommandRecorder(nullptr);
+
+            EndSegment();
+        }
+
+        void FrameGraphCommandRecorder::Execute(const VkCommandBuffer cmd) const
+        {
+            for (const Segment& segment: segments)
+            {
+                if (!segment.renderPass)
+                {
+                    vkCmdExecuteCommands(cmd, 1, &segment.commandBuffer);
+                    continue;
+                }
+
+                segment.renderPass->Begin(cmd, segment.framebuffer->framebuffer, segment.framebuffer->extent,
+                                          VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(cmd, 1, &segment.commandBuffer);
+                segment.renderPass->End(cmd);
+            }
+        }
+
+        VkCommandBuffer FrameGraphCommandRecorder::BeginRenderPass(VulkanRenderPass* renderPass, const VulkanFramebuffer* framebuffer)
+        {
+            EndSegment();
+            return BeginSegment(renderPass, framebuffer);
+        }
+
+        VkCommandBuffer FrameGraphCommandRecorder::EndRenderPass()
+        {
+            if (segments.empty() || !segments.back().renderPass)
+                throw std::runtime_error("Render pass ended without being begun!");
+
+            EndSegment();
+            return BeginSegment(nullptr, nullptr);
+        }
+
+        VkCommandBuffer FrameGraphCommandRecorder::BeginSegment(VulkanRenderPass* renderPass, const VulkanFramebuffer* framebuffer)
+        {
+            // Dynamic state is not inherited, the contents of a render pass set their own viewport and scissor
+            const VkCommandBufferInheritanceInfo inheritanceInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .renderPass = renderPass ? renderPass->Get() : VK_NULL_HANDLE,
+                .subpass = 0,
+                .framebuffer = framebuffer ? framebuffer->framebuffer : VK_NULL_HANDLE,
+                .pipelineStatistics = device->GetGpuProfiler().GetInheritedPipelineStatistics(),
+            };
+
+            segments.push_back({
+                .commandBuffer = device->BeginSecondaryCommandBuffer(inheritanceInfo),
+                .renderPass = renderPass,
+                .framebuffer = framebuffer,
+            });
+
+            return segments.back().commandBuffer;
+        }
+
+        void FrameGraphCommandRecorder::EndSegment() const
+        {
+            VK_CHECK_MSG(vkEndCommandBuffer(segments.back().commandBuffer), "Failed to record secondary command buffer.");
+        }
+
         void PassBuilder::CreateTexture(const char* name, TextureCreateInfo& info)
         {
+            // The compiled passes, framebuffers and barriers already reference the texture the graph declared
+            if (frameGraph.renderPassResourceMap.contains(name)) return;
+
             frameGraph.CreateFrameGraphTextureResource(name, info);
+
+            FrameGraphResource* resource = frameGraph.renderPassResourceMap[name];
+            resource->textureHandle = frameGraph.device->CreateTexture(resource->textureInfo);
         }
 
         void PassBuilder::CreateBuffer(const char* name, FrameGraphBufferCreateInfo& info)
@@ -49,16 +419,73 @@ namespace MongooseVK
 
         void FrameGraph::Compile(const VkExtent2D _resolution)
         {
+            PROFILE_FUNCTION();
+
             resolution = _resolution;
+            compilePending = false;
+
+            // Names are resolved into handles once, the passes keep the resources themselves
+            for (const auto& [name, resource]: externalResources)
+                RegisterResource(name, resource);
 
             CreateFrameGraphOutputs();
             InitializeRenderPasses();
+            BuildSchedule();
+
+            // Texture memory is laid out along the pass order, the passes can only create their framebuffers and
+            // descriptors once the textures exist
+            CreateTextures();
+
+            for (const auto& renderPass: renderPasses | std::views::values)
+                renderPass->Init();
+
+            BuildBarriers();
         }
 
         void FrameGraph::Execute(const VkCommandBuffer cmd, SceneGraph* scene)
         {
-            for (const auto& renderPass: renderPassList)
-                renderPass->Render(cmd, scene);
+            PROFILE_FUNCTION();
+
+            if (scheduleDirty)
+            {
+                BuildSchedule();
+                BuildBarriers();
+            }
+
+            // Only the first frame of a schedule has any
+            initialBarriers.Record(cmd);
+            initialBarriers = {};
+
+            // Every pass is recorded as a job into its own secondary command buffers, the primary only gets the
+            // barriers, the render pass instances and the executes, as soon as each pass is done
+            JobSystem* jobSystem = JobSystem::Get();
+            ArenaVector<JobCounter> recordings(executionPlan.size(), device->GetFrameArena());
+
+            for (size_t i = 0; i < executionPlan.size(); i++)
+            {
+                FrameGraphExecutionStep* step = &executionPlan[i];
+                jobSystem->Run([this, step, scene] {
+                    step->commands.Record(device, step->renderPass, scene);
+                }, &recordings[i]);
+            }
+
+            // Every pass is timed with the barriers in front of it, they are where it waits on the passes before
+            VulkanGpuProfiler& profiler = device->GetGpuProfiler();
+
+            for (size_t i = 0; i < executionPlan.size(); i++)
+            {
+                {
+                    PROFILE_SCOPE("Wait for pass recording");
+                    jobSystem->Wait(recordings[i]);
+                }
+
+                const uint32_t scope = profiler.BeginScope(cmd, executionPlan[i].renderPass->GetProfileName());
+                executionPlan[i].barriers.Record(cmd);
+                executionPlan[i].commands.Execute(cmd);
+                profiler.EndScope(cmd, scope);
+            }
+
+            exportBarriers.Record(cmd);
 
             for (const auto& pass: passes)
                 pass->Execute(cmd, {});
@@ -74,13 +501,23 @@ namespace MongooseVK
         {
             DestroyResources();
 
-            for (const auto& renderPass: renderPassList)
+            for (const auto& renderPass: registeredPasses)
                 delete renderPass;
 
-            renderPassList.clear();
+            registeredPasses.clear();
+            passOrder.clear();
+            executionPlan.clear();
             renderPasses.clear();
             renderPassResourceMap.clear();
             resourceHandles.clear();
+            resources.clear();
+
+            exportedResources.clear();
+            exportBarriers = {};
+            initialBarriers = {};
+            resourceLayouts.clear();
+            aliasedResources.clear();
+            scheduleDirty = false;
         }
 
         void FrameGraph::AddExternalResource(const char* name, FrameGraphResource* resource)
@@ -88,34 +525,86 @@ namespace MongooseVK
             externalResources[name] = resource;
         }
 
-        FrameGraphResource* FrameGraph::GetResource(const char* name)
+        FrameGraphResourceHandle FrameGraph::GetResourceHandle(const char* name) const
         {
-            return renderPassResourceMap[name];
+            const auto handle = resourceHandles.find(name);
+            if (handle == resourceHandles.end())
+                throw std::runtime_error("Frame graph resource " + std::string(name) + " does not exist!");
+
+            return handle->second;
         }
 
-        FrameGraphResourceHandle FrameGraph::CreateTextureResource(const char* resourceName, TextureCreateInfo& createInfo)
+        FrameGraphResource* FrameGraph::GetResource(const char* name) const
         {
-            FrameGraphResource* graphResource = resourcePool.Obtain();
-            graphResource->name = resourceName;
-            graphResource->type = ResourceUsage::Type::Texture;
-            graphResource->textureInfo = createInfo;
-            graphResource->textureHandle = device->CreateTexture(createInfo);
+            return GetResource(GetResourceHandle(name));
+        }
+
+        FrameGraphNodeHandle FrameGraph::GetPassHandle(const char* name) const
+        {
+            const auto renderPass = renderPasses.find(name);
+            if (renderPass == renderPasses.end())
+                throw std::runtime_error("Frame graph pass " + std::string(name) + " does not exist!");
 
-            return {graphResource->index};
+            return renderPass->second->GetNodeHandle();
         }
 
-        FrameGraphResourceHandle FrameGraph::CreateBufferResource(const char* resourceName, FrameGraphBufferCreateInfo& createInfo)
+        FrameGraphRenderPass* FrameGraph::GetPass(const char* name) const
         {
-            FrameGraphResource* graphResource = resourcePool.Obtain();
-            graphResource->name = resourceName;
-            graphResource->type = ResourceUsage::Type::Buffer;
-            graphResource->allocatedBuffer = device->CreateBuffer(
-                createInfo.size,
-                createInfo.usageFlags,
-                createInfo.memoryUsage
-            );
+            return GetPass(GetPassHandle(name));
+        }
+
+        void FrameGraph::ExportResource(FrameGraphResource* resource, const ResourceUsage usage)
+        {
+            exportedResources.push_back({resource, usage});
+        }
+
+        void FrameGraph::SetPassEnabled(const char* name, const bool enabled)
+        {
+            if (enabled == IsPassEnabled(name)) return;
+
+            if (enabled)
+                disabledPasses.erase(name);
+            else
+                disabledPasses.insert(name);
+
+            scheduleDirty = true;
+        }
+
+        bool FrameGraph::IsPassEnabled(const char* name) const
+        {
+            return !disabledPasses.contains(name);
+        }
+
+        void FrameGraph::SetDebugViewEnabled(const char* name, const bool enabled)
+        {
+            if (enabled == IsDebugViewEnabled(name)) return;
+
+            if (enabled)
+                debugViews.insert(name);
+            else
+                debugViews.erase(name);
+
+            compilePending = true;
+        }
+
+        bool FrameGraph::IsDebugViewEnabled(const char* name) const
+        {
+            return debugViews.contains(name);
+        }
 
-            return {graphResource->index};
+        void FrameGraph::RegisterResource(const std::string& name, FrameGraphResource* resource)
+        {
+            // A resource declared again keeps the handle of the one it replaces
+            if (const auto handle = resourceHandles.find(name); handle != resourceHandles.end())
+            {
+                resource->handle = handle->second;
+                resources[handle->second.index] = resource;
+                return;
+            }
+
+            resource->handle = {static_cast<FrameGraphHandle>(resources.size())};
+            resourceHandles[name] = resource->handle;
+            resources.push_back(resource);
         }
 
         void FrameGraph::DestroyResources()
@@ -129,15 +618,27 @@ namespace MongooseVK
             });
 
             resourcePool.FreeAllResources();
+
+            // The images placed in them are destroyed first, both are deferred until the frame is done
+            for (const VmaAllocation allocation: transientAllocations)
+                device->FreeMemory(allocation);
+
+            transientAllocations.clear();
         }
 
         void FrameGraph::InitializeRenderPasses()
         {
+            AddRenderPass<CullingPass>("CullingPass");
+            AddRenderPass<LightClusteringPass>("LightClusteringPass");
             AddRenderPass<ShadowMapPass>("ShadowMapPass");
             AddRenderPass<GBufferPass>("GBufferPass");
+            AddRenderPass<DepthPyramidPass>("DepthPyramidPass");
+            AddRenderPass<OcclusionCullingPass>("OcclusionCullingPass");
+            AddRenderPass<GBufferLatePass>("GBufferLatePass");
             AddRenderPass<SSAOPass>("SSAOPass");
             AddRenderPass<SkyboxPass>("SkyboxPass");
             AddRenderPass<LightingPass>("LightingPass");
+            AddRenderPass<ForwardPass>("ForwardPass");
             AddRenderPass<InfiniteGridPass>("InfiniteGridPass");
             AddRenderPass<ToneMappingPass>("ToneMappingPass");
             AddRenderPass<UiPass>("UiPass");
@@ -145,133 +646,694 @@ namespace MongooseVK
             for (const auto& renderPass: renderPasses | std::views::values)
                 renderPass->Reset();
 
-            // Skybox pass
+            for (FrameGraphResource* resource: resources)
+                resource->accesses.clear();
+
+            // A pass reads the version of a resource written by the last pass declared before it, so the blocks
+            // below are in frame order. The execution order is derived from them, not from the registration above.
+
+            // Culling pass
             {
-                renderPasses["SkyboxPass"]->AddInput(externalResources["camera_buffer"]);
-                renderPasses["SkyboxPass"]->AddOutput(renderPassResourceMap["hdr_image"],
-                                                      {
-                                                          ResourceUsage::Access::Write,
+                // Reads the pyramid of the previous frame, so it runs before the pyramid is rebuilt
+                GetPass("CullingPass")->AddInput(GetResource("depth_pyramid"));
+                GetPass("CullingPass")->AddOutput(GetResource("draw_lists"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Virtual,
+                                                      ResourceUsage::Usage::Storage
+                                                  });
+            }
+
+            // Light clustering pass
+            {
+                GetPass("LightClusteringPass")->AddInput(GetResource("camera_buffer"));
+                GetPass("LightClusteringPass")->AddInput(GetResource("lights_buffer"));
+                GetPass("LightClusteringPass")->AddInput(GetResource("scene_lights_buffer"));
+
+                GetPass("LightClusteringPass")->AddOutput(GetResource("light_clusters"), {
+                                                              ResourceUsage::Access::Write,
+                                                              ResourceUsage::Type::Buffer,
+                                                              ResourceUsage::Usage::Storage
+                                                          });
+
+                GetPass("LightClusteringPass")->AddOutput(GetResource("light_cluster_indices"), {
+                                                              ResourceUsage::Access::Write,
+                                                              ResourceUsage::Type::Buffer,
+                                                              ResourceUsage::Usage::Storage
+                                                          });
+            }
+
+            // Shadow map pass
+            {
+                GetPass("ShadowMapPass")->AddInput(GetResource("draw_lists"));
+                GetPass("ShadowMapPass")->AddOutput(GetResource("directional_shadow_map"), {
+                                                        ResourceUsage::Access::Write,
+                                                        ResourceUsage::Type::Texture,
+                                                        ResourceUsage::Usage::ColorAttachment
+                                                    });
+            }
+
+            // GBuffer pass
+            {
+                GetPass("GBufferPass")->AddInput(GetResource("camera_buffer"));
+                GetPass("GBufferPass")->AddInput(GetResource("draw_lists"));
+
+                GetPass("GBufferPass")->AddOutput(GetResource("viewspace_normal"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
+
+                GetPass("GBufferPass")->AddOutput(GetResource("viewspace_position"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
+
+                GetPass("GBufferPass")->AddOutput(GetResource("gbuffer_albedo"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
+
+                GetPass("GBufferPass")->AddOutput(GetResource("gbuffer_material"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
+
+                GetPass("GBufferPass")->AddOutput(GetResource("gbuffer_material_id"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
+
+                GetPass("GBufferPass")->AddOutput(GetResource("depth_map"), {
+                                                      ResourceUsage::Access::Write,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::DepthStencil
+                                                  });
+            }
+
+            // Depth pyramid pass
+            {
+                GetPass("DepthPyramidPass")->AddInput(GetResource("depth_map"));
+                GetPass("DepthPyramidPass")->AddOutput(GetResource("depth_pyramid"), {
+                                                           ResourceUsage::Access::Write,
+                                                           ResourceUsage::Type::Texture,
+                                                           ResourceUsage::Usage::Storage
+                                                       });
+            }
+
+            // Occlusion culling pass
+            {
+                GetPass("OcclusionCullingPass")->AddInput(GetResource("depth_pyramid"));
+                GetPass("OcclusionCullingPass")->AddOutput(GetResource("late_draw_lists"), {
+                                                               ResourceUsage::Access::Write,
+                                                               ResourceUsage::Type::Virtual,
+                                                               ResourceUsage::Usage::Storage
+                                                           });
+            }
+
+            // GBuffer late pass
+            {
+                GetPass("GBufferLatePass")->AddInput(GetResource("camera_buffer"));
+                GetPass("GBufferLatePass")->AddInput(GetResource("late_draw_lists"));
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("viewspace_normal"), {
+                                                          ResourceUsage::Access::ReadWrite,
                                                           ResourceUsage::Type::Texture,
                                                           ResourceUsage::Usage::ColorAttachment
                                                       });
-                renderPasses["SkyboxPass"]->AddOutput(renderPassResourceMap["depth_map"],
-                                                      {
-                                                          ResourceUsage::Access::Write,
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("viewspace_position"), {
+                                                          ResourceUsage::Access::ReadWrite,
+                                                          ResourceUsage::Type::Texture,
+                                                          ResourceUsage::Usage::ColorAttachment
+                                                      });
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("gbuffer_albedo"), {
+                                                          ResourceUsage::Access::ReadWrite,
+                                                          ResourceUsage::Type::Texture,
+                                                          ResourceUsage::Usage::ColorAttachment
+                                                      });
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("gbuffer_material"), {
+                                                          ResourceUsage::Access::ReadWrite,
+                                                          ResourceUsage::Type::Texture,
+                                                          ResourceUsage::Usage::ColorAttachment
+                                                      });
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("gbuffer_material_id"), {
+                                                          ResourceUsage::Access::ReadWrite,
+                                                          ResourceUsage::Type::Texture,
+                                                          ResourceUsage::Usage::ColorAttachment
+                                                      });
+
+                GetPass("GBufferLatePass")->AddOutput(GetResource("depth_map"), {
+                                                          ResourceUsage::Access::ReadWrite,
                                                           ResourceUsage::Type::Texture,
                                                           ResourceUsage::Usage::DepthStencil
                                                       });
             }
 
-            // Grid pass
+            // SSAO pass
             {
-                renderPasses["InfiniteGridPass"]->AddInput(externalResources["camera_buffer"]);
+                GetPass("SSAOPass")->AddInput(GetResource("viewspace_normal"));
+                GetPass("SSAOPass")->AddInput(GetResource("viewspace_position"));
+                GetPass("SSAOPass")->AddInput(GetResource("depth_map"));
+                GetPass("SSAOPass")->AddInput(GetResource("camera_buffer"));
+
+                GetPass("SSAOPass")->AddOutput(GetResource("ssao_texture"), {
+                                                   ResourceUsage::Access::Write,
+                                                   ResourceUsage::Type::Texture,
+                                                   ResourceUsage::Usage::ColorAttachment
+                                               });
+            }
 
-                renderPasses["InfiniteGridPass"]->AddOutput(renderPassResourceMap["hdr_image"],
-                                                            {
-                                                                ResourceUsage::Access::ReadWrite,
-                                                                ResourceUsage::Type::Texture,
-                                                                ResourceUsage::Usage::ColorAttachment
-                                                            });
+            // Skybox pass
+            {
+                GetPass("SkyboxPass")->AddInput(GetResource("camera_buffer"));
+                GetPass("SkyboxPass")->AddOutput(GetResource("hdr_image"),
+                                                 {
+                                                     ResourceUsage::Access::Write,
+                                                     ResourceUsage::Type::Texture,
+                                                     ResourceUsage::Usage::ColorAttachment
+                                                 });
+            }
 
-                renderPasses["InfiniteGridPass"]->AddOutput(renderPassResourceMap["depth_map"],
-                                                            {
-                                                                ResourceUsage::Access::ReadWrite,
-                                                                ResourceUsage::Type::Texture,
-                                                                ResourceUsage::Usage::DepthStencil
-                                                            });
+            // Lighting pass
+            {
+                GetPass("LightingPass")->AddInput(GetResource("camera_buffer"));
+                GetPass("LightingPass")->AddInput(GetResource("lights_buffer"));
+                GetPass("LightingPass")->AddInput(GetResource("directional_shadow_map"));
+                GetPass("LightingPass")->AddInput(GetResource("irradiance_map_texture"));
+                GetPass("LightingPass")->AddInput(GetResource("ssao_texture"));
+                GetPass("LightingPass")->AddInput(GetResource("prefilter_map_texture"));
+                GetPass("LightingPass")->AddInput(GetResource("brdflut_texture"));
+                GetPass("LightingPass")->AddInput(GetResource("scene_lights_buffer"));
+                GetPass("LightingPass")->AddInput(GetResource("light_clusters"));
+                GetPass("LightingPass")->AddInput(GetResource("light_cluster_indices"));
+                GetPass("LightingPass")->AddInput(GetResource("viewspace_normal"));
+                GetPass("LightingPass")->AddInput(GetResource("viewspace_position"));
+                GetPass("LightingPass")->AddInput(GetResource("gbuffer_albedo"));
+                GetPass("LightingPass")->AddInput(GetResource("gbuffer_material"));
+                GetPass("LightingPass")->AddInput(GetResource("gbuffer_material_id"));
+
+                GetPass("LightingPass")->AddOutput(GetResource("hdr_image"), {
+                                                       ResourceUsage::Access::ReadWrite,
+                                                       ResourceUsage::Type::Texture,
+                                                       ResourceUsage::Usage::ColorAttachment
+                                                   });
             }
 
-            // GBuffer pass
+            // Forward pass
             {
-                renderPasses["GBufferPass"]->AddInput(externalResources["camera_buffer"]);
+                GetPass("ForwardPass")->AddInput(GetResource("camera_buffer"));
+                GetPass("ForwardPass")->AddInput(GetResource("lights_buffer"));
+                GetPass("ForwardPass")->AddInput(GetResource("directional_shadow_map"));
+                GetPass("ForwardPass")->AddInput(GetResource("irradiance_map_texture"));
+                GetPass("ForwardPass")->AddInput(GetResource("ssao_texture"));
+                GetPass("ForwardPass")->AddInput(GetResource("prefilter_map_texture"));
+                GetPass("ForwardPass")->AddInput(GetResource("brdflut_texture"));
+                GetPass("ForwardPass")->AddInput(GetResource("scene_lights_buffer"));
+                GetPass("ForwardPass")->AddInput(GetResource("light_clusters"));
+                GetPass("ForwardPass")->AddInput(GetResource("light_cluster_indices"));
+                GetPass("ForwardPass")->AddInput(GetResource("draw_lists"));
+                GetPass("ForwardPass")->AddInput(GetResource("late_draw_lists"));
+
+                GetPass("ForwardPass")->AddOutput(GetResource("hdr_image"), {
+                                                      ResourceUsage::Access::ReadWrite,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::ColorAttachment
+                                                  });
 
-                renderPasses["GBufferPass"]->AddOutput(renderPassResourceMap["viewspace_normal"], {
-                                                           ResourceUsage::Access::Write,
-                                                           ResourceUsage::Type::Texture,
-                                                           ResourceUsage::Usage::ColorAttachment
-                                                       });
+                GetPass("ForwardPass")->AddOutput(GetResource("depth_map"), {
+                                                      ResourceUsage::Access::ReadWrite,
+                                                      ResourceUsage::Type::Texture,
+                                                      ResourceUsage::Usage::DepthStencil
+                                                  });
+            }
 
-                renderPasses["GBufferPass"]->AddOutput(renderPassResourceMap["viewspace_position"], {
-                                                           ResourceUsage::Access::Write,
+            // Grid pass
+            {
+                GetPass("InfiniteGridPass")->AddInput(GetResource("camera_buffer"));
+
+                GetPass("InfiniteGridPass")->AddOutput(GetResource("hdr_image"),
+                                                       {
+                                                           ResourceUsage::Access::ReadWrite,
                                                            ResourceUsage::Type::Texture,
                                                            ResourceUsage::Usage::ColorAttachment
                                                        });
 
-                renderPasses["GBufferPass"]->AddOutput(renderPassResourceMap["depth_map"], {
-                                                           ResourceUsage::Access::Write,
+                GetPass("InfiniteGridPass")->AddOutput(GetResource("depth_map"),
+                                                       {
+                                                           ResourceUsage::Access::ReadWrite,
                                                            ResourceUsage::Type::Texture,
                                                            ResourceUsage::Usage::DepthStencil
                                                        });
             }
 
-            // Lighting pass
+            // Tone Mapping pass
             {
-                renderPasses["LightingPass"]->AddInput(externalResources["camera_buffer"]);
-                renderPasses["LightingPass"]->AddInput(externalResources["lights_buffer"]);
-                renderPasses["LightingPass"]->AddInput(renderPassResourceMap["directional_shadow_map"]);
-                renderPasses["LightingPass"]->AddInput(externalResources["irradiance_map_texture"]);
-                renderPasses["LightingPass"]->AddInput(renderPassResourceMap["ssao_texture"]);
-                renderPasses["LightingPass"]->AddInput(externalResources["prefilter_map_texture"]);
-                renderPasses["LightingPass"]->AddInput(externalResources["brdflut_texture"]);
+                GetPass("ToneMappingPass")->AddInput(GetResource("hdr_image"));
+                GetPass("ToneMappingPass")->AddOutput(GetResource("main_frame_color"), {
+                                                          ResourceUsage::Access::Write,
+                                                          ResourceUsage::Type::Texture,
+                                                          ResourceUsage::Usage::ColorAttachment
+                                                      });
+            }
 
+            // UI pass
+            {
+                // Sampled by the open debug windows only, the reads keep their memory from being reused before the
+                // UI is drawn. Declared always they would keep these textures alive to the end of every frame.
+                if (IsDebugViewEnabled("GBufferViewer"))
+                {
+                    GetPass("UiPass")->AddInput(GetResource("viewspace_normal"));
+                    GetPass("UiPass")->AddInput(GetResource("viewspace_position"));
+                    GetPass("UiPass")->AddInput(GetResource("depth_map"));
+                    GetPass("UiPass")->AddInput(GetResource("ssao_texture"));
+                }
 
-                renderPasses["LightingPass"]->AddOutput(renderPassResourceMap["hdr_image"], {
-                                                            ResourceUsage::Access::ReadWrite,
-                                                            ResourceUsage::Type::Texture,
-                                                            ResourceUsage::Usage::ColorAttachment
-                                                        });
+                if (IsDebugViewEnabled("ShadowMapViewer"))
+                    GetPass("UiPass")->AddInput(GetResource("directional_shadow_map"));
 
-                renderPasses["LightingPass"]->AddOutput(renderPassResourceMap["depth_map"], {
-                                                            ResourceUsage::Access::Read,
-                                                            ResourceUsage::Type::Texture,
-                                                            ResourceUsage::Usage::DepthStencil
-                                                        });
+                GetPass("UiPass")->AddOutput(GetResource("main_frame_color"), {
+                                                 ResourceUsage::Access::ReadWrite,
+                                                 ResourceUsage::Type::Texture,
+                                                 ResourceUsage::Usage::ColorAttachment
+                                             });
             }
 
-            // SSAO pass
+            // Presentation
             {
-                renderPasses["SSAOPass"]->AddInput(renderPassResourceMap["viewspace_normal"]);
-                renderPasses["SSAOPass"]->AddInput(renderPassResourceMap["viewspace_position"]);
-                renderPasses["SSAOPass"]->AddInput(renderPassResourceMap["depth_map"]);
-                renderPasses["SSAOPass"]->AddInput(externalResources["camera_buffer"]);
+                // The renderer copies the final image into the swapchain image after the last pass
+                ExportResource(GetResource("main_frame_color"), {
+                                   ResourceUsage::Access::Read,
+                                   ResourceUsage::Type::Texture,
+                                   ResourceUsage::Usage::TransferSource
+                               });
+            }
+        }
 
-                renderPasses["SSAOPass"]->AddOutput(renderPassResourceMap["ssao_texture"], {
-                                                        ResourceUsage::Access::Write,
-                                                        ResourceUsage::Type::Texture,
-                                                        ResourceUsage::Usage::ColorAttachment
-                                                    });
+        void FrameGraph::BuildSchedule()
+        {
+            scheduleDirty = false;
+
+            const uint32_t passCount = static_cast<uint32_t>(registeredPasses.size());
+
+            std::vector<bool> enabled(passCount, true);
+            for (const std::string& name: disabledPasses)
+            {
+                if (const auto renderPass = renderPasses.find(name); renderPass != renderPasses.end())
+                    enabled[renderPass->second->GetNodeHandle().index] = false;
             }
 
-            // Shadow map pass
+            // Passes in runAfter[i] have to execute before pass i, the ones in consumes[i] produce what it reads
+            std::vector<std::vector<uint32_t>> runAfter;
+            std::vector<std::vector<uint32_t>> consumes;
+
+            const auto collectDependencies = [&](const std::vector<bool>& included) {
+                runAfter.assign(passCount, {});
+                consumes.assign(passCount, {});
+
+                // External resources are written outside of the graph and never order passes
+                for (FrameGraphResource* resource: renderPassResourceMap | std::views::values)
+                {
+                    resource->producer = nullptr;
+                    resource->lastWriter = nullptr;
+                    resource->refCount = 0;
+
+                    std::optional<uint32_t> lastWriter;
+                    std::vector<uint32_t> readers;        // Of the current version
+                    std::vector<uint32_t> historyReaders; // Of the previous frame's version
+
+                    for (const auto& [renderPass, access]: resource->accesses)
+                    {
+                        const uint32_t pass = renderPass->GetNodeHandle().index;
+                        if (!included[pass]) continue;
+
+                        if (access != ResourceUsage::Access::Write)
+                        {
+                            if (lastWriter)
+                            {
+                                runAfter[pass].push_back(*lastWriter);
+                                consumes[pass].push_back(*lastWriter);
+                            } else
+                                historyReaders.push_back(pass);
+                        }
+
+                        if (access == ResourceUsage::Access::Read)
+                        {
+                            readers.push_back(pass);
+                            continue;
+                        }
+
+                        // Write after write and write after read
+                        if (lastWriter)
+                            runAfter[pass].push_back(*lastWriter);
+
+                        for (const uint32_t reader: readers)
+                            runAfter[pass].push_back(reader);
+
+                        readers.clear();
+                        lastWriter = pass;
+
+                        if (!resource->producer)
+                            resource->producer = registeredPasses[pass];
+                    }
+
+                    if (!lastWriter) continue;
+                    resource->lastWriter = registeredPasses[*lastWriter];
+
+                    // The previous frame's version has to be read before the first write overwrites it
+                    const uint32_t producer = resource->producer->GetNodeHandle().index;
+                    for (const uint32_t reader: historyReaders)
+                    {
+                        if (reader != producer)
+                            runAfter[producer].push_back(reader);
+
+                        consumes[reader].push_back(*lastWriter);
+                    }
+                }
+            };
+
+            // The order covers every registered pass, so the schedule of any set of enabled passes is a subsequence
+            // of it and the texture lifetimes Compile derives from it hold for all of them
+            collectDependencies(std::vector<bool>(passCount, true));
+
+            // Topological sort, ties go to the pass registered first
+            std::vector<uint32_t> pendingCount(passCount, 0);
+            std::vector<std::vector<uint32_t>> dependents(passCount);
+            for (uint32_t pass = 0; pass < passCount; pass++)
             {
-                renderPasses["ShadowMapPass"]->AddOutput(renderPassResourceMap["directional_shadow_map"], {
-                                                             ResourceUsage::Access::Write,
-                                                             ResourceUsage::Type::Texture,
-                                                             ResourceUsage::Usage::ColorAttachment
-                                                         });
+                std::ranges::sort(runAfter[pass]);
+                const auto duplicates = std::ranges::unique(runAfter[pass]);
+                runAfter[pass].erase(duplicates.begin(), duplicates.end());
+
+                for (const uint32_t dependency: runAfter[pass])
+                {
+                    if (dependency == pass) continue;
+
+                    pendingCount[pass]++;
+                    dependents[dependency].push_back(pass);
+                }
             }
 
-            // Tone Mapping pass
+            passOrder.clear();
+            std::vector<bool> scheduled(passCount, false);
+
+            while (true)
             {
-                renderPasses["ToneMappingPass"]->AddInput(renderPassResourceMap["hdr_image"]);
-                renderPasses["ToneMappingPass"]->AddOutput(renderPassResourceMap["main_frame_color"], {
-                                                               ResourceUsage::Access::Write,
-                                                               ResourceUsage::Type::Texture,
-                                                               ResourceUsage::Usage::ColorAttachment
-                                                           });
+                uint32_t next = passCount;
+                for (uint32_t pass = 0; pass < passCount && next == passCount; pass++)
+                {
+                    if (!scheduled[pass] && pendingCount[pass] == 0)
+                        next = pass;
+                }
+
+                if (next == passCount) break;
+
+                scheduled[next] = true;
+                passOrder.push_back(registeredPasses[next]);
+
+                for (const uint32_t dependent: dependents[next])
+                    pendingCount[dependent]--;
             }
 
-            // UI pass
+            if (passOrder.size() != passCount)
+                throw std::runtime_error("Frame graph passes have a cyclic dependency!");
+
+            // Producers, liveness and reference counts only see the enabled passes
+            collectDependencies(enabled);
+
+            // Everything the exported resources are built from is live, the rest is culled
+            std::vector<bool> live(passCount, false);
+            std::vector<uint32_t> liveStack;
+            for (const FrameGraphResource* resource: exportedResources | std::views::keys)
             {
-                renderPasses["UiPass"]->AddOutput(renderPassResourceMap["main_frame_color"], {
-                                                      ResourceUsage::Access::ReadWrite,
-                                                      ResourceUsage::Type::Texture,
-                                                      ResourceUsage::Usage::ColorAttachment
-                                                  });
+                if (resource->lastWriter)
+                    liveStack.push_back(resource->lastWriter->GetNodeHandle().index);
             }
 
-            for (const auto& renderPass: renderPasses | std::views::values)
-                renderPass->Init();
+            while (!liveStack.empty())
+            {
+                const uint32_t pass = liveStack.back();
+                liveStack.pop_back();
+
+                if (live[pass]) continue;
+                live[pass] = true;
+
+                liveStack.insert(liveStack.end(), consumes[pass].begin(), consumes[pass].end());
+            }
+
+            for (FrameGraphResource* resource: renderPassResourceMap | std::views::values)
+            {
+                for (const auto& [renderPass, access]: resource->accesses)
+                {
+                    if (access != ResourceUsage::Access::Write && live[renderPass->GetNodeHandle().index])
+                        resource->refCount++;
+                }
+            }
+
+            executionPlan.clear();
+            for (FrameGraphRenderPass* renderPass: passOrder)
+            {
+                if (live[renderPass->GetNodeHandle().index])
+                    executionPlan.push_back({.renderPass = renderPass});
+            }
+        }
+
+        void FrameGraph::CreateTextures()
+        {
+            std::vector<uint32_t> passPositions(passOrder.size());
+            for (uint32_t i = 0; i < passOrder.size(); i++)
+                passPositions[passOrder[i]->GetNodeHandle().index] = i;
+
+            // A texture first used by a pass that overwrites it entirely holds nothing outside of the passes using
+            // it, so textures whose passes do not overlap in the order can share memory. Exported textures are used
+            // up to the end of the frame, ones read before they are written carry data into the next frame.
+            std::vector<Utils::TransientTexture> transientTextures;
+            for (FrameGraphResource* resource: renderPassResourceMap | std::views::values)
+            {
+                if (resource->type != ResourceUsage::Type::Texture || resource->textureHandle != INVALID_TEXTURE_HANDLE) continue;
+
+                Utils::TransientTexture texture{
+                    .resource = resource,
+                    .firstPass = static_cast<uint32_t>(passOrder.size()),
+                    .lastPass = 0,
+                };
+
+                for (const FrameGraphResourceAccess& access: resource->accesses)
+                {
+                    const uint32_t position = passPositions[access.renderPass->GetNodeHandle().index];
+                    texture.firstPass = std::min(texture.firstPass, position);
+                    texture.lastPass = std::max(texture.lastPass, position);
+                }
+
+                bool transient = !resource->accesses.empty();
+                for (const auto& [renderPass, access]: resource->accesses)
+                {
+                    if (passPositions[renderPass->GetNodeHandle().index] == texture.firstPass && access != ResourceUsage::Access::Write)
+                        transient = false;
+                }
+
+                if (!transient)
+                {
+                    resource->textureHandle = device->CreateTexture(resource->textureInfo);
+                    continue;
+                }
+
+                for (const FrameGraphResource* exported: exportedResources | std::views::keys)
+                {
+                    if (exported == resource)
+                        texture.lastPass = static_cast<uint32_t>(passOrder.size());
+                }
+
+                texture.memoryRequirements = device->GetTextureMemoryRequirements(resource->textureInfo);
+                transientTextures.push_back(texture);
+            }
+
+            // Largest first, each one goes to the first heap with room for it while it is alive
+            std::ranges::sort(transientTextures, [](const Utils::TransientTexture& a, const Utils::TransientTexture& b) {
+                if (a.memoryRequirements.size != b.memoryRequirements.size)
+                    return a.memoryRequirements.size > b.memoryRequirements.size;
+
+                return std::strcmp(a.resource->name, b.resource->name) < 0;
+            });
+
+            std::vector<Utils::TransientHeap> heaps;
+            for (uint32_t i = 0; i < transientTextures.size(); i++)
+            {
+                Utils::TransientTexture& texture = transientTextures[i];
+                texture.heap = static_cast<uint32_t>(heaps.size());
+
+                for (uint32_t heap = 0; heap < heaps.size(); heap++)
+                {
+                    if (!(heaps[heap].memoryTypeBits & texture.memoryRequirements.memoryTypeBits)) continue;
+
+                    if (const std::optional<VkDeviceSize> offset = Utils::FindHeapOffset(transientTextures, heaps[heap], texture))
+                    {
+                        texture.heap = heap;
+                        texture.offset = *offset;
+                        break;
+                    }
+                }
+
+                if (texture.heap == heaps.size())
+                {
+                    heaps.push_back({
+                        .size = texture.memoryRequirements.size,
+                        .alignment = texture.memoryRequirements.alignment,
+                        .memoryTypeBits = texture.memoryRequirements.memoryTypeBits,
+                    });
+                }
+
+                Utils::TransientHeap& heap = heaps[texture.heap];
+                heap.alignment = std::max(heap.alignment, texture.memoryRequirements.alignment);
+                heap.memoryTypeBits &= texture.memoryRequirements.memoryTypeBits;
+                heap.textures.push_back(i);
+            }
+
+            VkDeviceSize dedicatedSize = 0;
+            VkDeviceSize aliasedSize = 0;
+            uint32_t aliasedCount = 0;
+
+            for (const Utils::TransientHeap& heap: heaps)
+            {
+                aliasedSize += heap.size;
+
+                // A texture alone in its heap gets a dedicated allocation like any other
+                if (heap.textures.size() == 1)
+                {
+                    Utils::TransientTexture& texture = transientTextures[heap.textures[0]];
+                    texture.resource->textureHandle = device->CreateTexture(texture.resource->textureInfo);
+                    dedicatedSize += texture.memoryRequirements.size;
+                    continue;
+                }
+
+                const VmaAllocation allocation = device->AllocateMemory({
+                    .size = heap.size,
+                    .alignment = heap.alignment,
+                    .memoryTypeBits = heap.memoryTypeBits,
+                });
+                transientAllocations.push_back(allocation);
+
+                for (const uint32_t i: heap.textures)
+                {
+                    const Utils::TransientTexture& texture = transientTextures[i];
+
+                    TextureCreateInfo createInfo = texture.resource->textureInfo;
+                    createInfo.aliasAllocation = allocation;
+                    createInfo.aliasOffset = texture.offset;
+                    texture.resource->textureHandle = device->CreateTexture(createInfo);
+
+                    dedicatedSize += texture.memoryRequirements.size;
+                    aliasedCount++;
+
+                    // Every texture in the same memory range takes it over from the others in BuildBarriers
+                    for (const uint32_t j: heap.textures)
+                    {
+                        const Utils::TransientTexture& other = transientTextures[j];
+                        if (i == j) continue;
+
+                        if (texture.offset < other.offset + other.memoryRequirements.size &&
+                            other.offset < texture.offset + texture.memoryRequirements.size)
+                            aliasedResources[texture.resource].push_back(other.resource);
+                    }
+                }
+            }
+
+            constexpr VkDeviceSize MEGABYTE = 1024 * 1024;
+            LOG_TRACE("Frame graph: " + std::to_string(transientTextures.size()) + " transient textures in " +
+                std::to_string(aliasedSize / MEGABYTE) + " MB instead of " + std::to_string(dedicatedSize / MEGABYTE) +
+                " MB, " + std::to_string(aliasedCount) + " of them share memory");
+        }
+
+        void FrameGraph::BuildBarriers()
+        {
+            // External resources are written by the host or outside of the graph and are not tracked
+            std::unordered_map<const FrameGraphResource*, Utils::ResourceState> resourceStates;
+            for (const FrameGraphResource* resource: renderPassResourceMap | std::views::values)
+            {
+                if (resource->type != ResourceUsage::Type::Virtual)
+                    resourceStates[resource] = {};
+            }
+
+            // Textures sharing memory are acquired from all of their aliases by their first use of every frame
+            std::unordered_set<const FrameGraphResource*> acquiredResources;
+
+            const auto addBarrier = [&](BarrierBatch& batch, const FrameGraphResource* resource, const Utils::ResourceAccess& access) {
+                const auto state = resourceStates.find(resource);
+                if (state == resourceStates.end()) return;
+
+                const auto aliases = aliasedResources.find(resource);
+                if (aliases != aliasedResources.end() && acquiredResources.insert(resource).second)
+                {
+                    // The previous contents belong to another texture, the layout transition waits for its last use
+                    Utils::ResourceState acquiredState{};
+                    for (const FrameGraphResource* alias: aliases->second)
+                    {
+                        const Utils::ResourceState& aliasState = resourceStates[alias];
+                        acquiredState.writeStages |= aliasState.writeStages | aliasState.readStages;
+                        acquiredState.writeAccess |= aliasState.writeAccess;
+                    }
+
+                    state->second = acquiredState;
+                }
+
+                const bool isTexture = resource->type == ResourceUsage::Type::Texture;
+                if (const std::optional<Utils::BarrierScope> scope = Utils::ApplyAccess(state->second, access, isTexture))
+                    Utils::AddBarrier(device, batch, resource, *scope);
+            };
+
+            // A frame starts in the state the previous one ended in, so the first walk over the passes only finds
+            // those end states and the second one records the barriers
+            for (uint32_t walk = 0; walk < 2; walk++)
+            {
+                for (FrameGraphExecutionStep& step: executionPlan)
+                    step.barriers = {};
+
+                exportBarriers = {};
+                acquiredResources.clear();
+
+                for (FrameGraphExecutionStep& step: executionPlan)
+                {
+                    const VkPipelineStageFlags2 shaderStages = step.renderPass->GetShaderStages();
+
+                    for (const FrameGraphResource* input: step.renderPass->GetInputs())
+                        addBarrier(step.barriers, input, Utils::GetInputAccess(input, shaderStages));
+
+                    for (const auto& [output, usage]: step.renderPass->GetOutputs())
+                        addBarrier(step.barriers, output, Utils::GetOutputAccess(output, usage, shaderStages));
+                }
+
+                for (const auto& [resource, usage]: exportedResources)
+                    addBarrier(exportBarriers, resource, Utils::GetOutputAccess(resource, usage, VK_PIPELINE_STAGE_2_NONE));
+            }
+
+            // The barriers above assume the previous frame ran the same schedule. The first frame of a schedule
+            // starts from new textures or from whatever the previous schedule left behind instead.
+            initialBarriers = {};
+            for (const auto& [resource, state]: resourceStates)
+            {
+                const bool isTexture = resource->type == ResourceUsage::Type::Texture;
+                if (isTexture && state.layout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+                if (aliasedResources.contains(resource)) continue;
+
+                VkImageLayout& layout = resourceLayouts.try_emplace(resource, VK_IMAGE_LAYOUT_UNDEFINED).first->second;
+
+                Utils::AddBarrier(device, initialBarriers, resource, {
+                                      .srcStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                      .srcAccess = VK_ACCESS_2_MEMORY_WRITE_BIT,
+                                      .dstStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                      .dstAccess = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                                      .oldLayout = layout,
+                                      .newLayout = state.layout,
+                                  });
+
+                layout = state.layout;
+            }
         }
 
         void FrameGraph::CreateFrameGraphOutputs()
@@ -294,6 +1356,35 @@ namespace MongooseVK
                 CreateFrameGraphTextureResource("viewspace_position", textureCreateInfo);
             }
 
+            // GBuffer Albedo
+            {
+                TextureCreateInfo textureCreateInfo{};
+                textureCreateInfo.resolution = resolution;
+                textureCreateInfo.format = ImageFormat::RGBA8_UNORM;
+
+                CreateFrameGraphTextureResource("gbuffer_albedo", textureCreateInfo);
+            }
+
+            // GBuffer Metallic Roughness
+            {
+                TextureCreateInfo textureCreateInfo{};
+                textureCreateInfo.resolution = resolution;
+                textureCreateInfo.format = ImageFormat::RGBA8_UNORM;
+
+                CreateFrameGraphTextureResource("gbuffer_material", textureCreateInfo);
+            }
+
+            // GBuffer Material ID
+            {
+                // Integer targets can not be linearly filtered, the resolve fetches texels directly
+                TextureCreateInfo textureCreateInfo{};
+                textureCreateInfo.resolution = resolution;
+                textureCreateInfo.format = ImageFormat::R32_UINT;
+                textureCreateInfo.filter = VK_FILTER_NEAREST;
+
+                CreateFrameGraphTextureResource("gbuffer_material_id", textureCreateInfo);
+            }
+
             // Depth Map
             {
                 TextureCreateInfo textureCreateInfo{};
@@ -303,6 +1394,54 @@ namespace MongooseVK
                 CreateFrameGraphTextureResource("depth_map", textureCreateInfo);
             }
 
+            // Depth Pyramid
+            {
+                // Half resolution max depth chain down to 1x1, mip 0 already reduces 2x2 depth texels
+                const VkExtent2D pyramidResolution = {std::max(resolution.width / 2, 1u), std::max(resolution.height / 2, 1u)};
+
+                TextureCreateInfo textureCreateInfo{};
+                textureCreateInfo.resolution = pyramidResolution;
+                textureCreateInfo.format = ImageFormat::R32_SFLOAT;
+                textureCreateInfo.filter = VK_FILTER_NEAREST;
+                textureCreateInfo.addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                textureCreateInfo.mipLevels = static_cast<uint32_t>(std::floor(
+                    std::log2(std::max(pyramidResolution.width, pyramidResolution.height)))) + 1;
+
+                CreateFrameGraphTextureResource("depth_pyramid", textureCreateInfo);
+            }
+
+            // Draw Lists
+            {
+                // The culling passes write the indirect draw lists into the GPU scene, these only order the passes
+                // drawing from them after the culling
+                CreateFrameGraphVirtualResource("draw_lists");
+                CreateFrameGraphVirtualResource("late_draw_lists");
+            }
+
+            // Light Clusters
+            {
+                // Offset and count into the index list per cluster, rebuilt every frame by the clustering pass
+                FrameGraphBufferCreateInfo bufferCreateInfo{
+                    .size = LIGHT_CLUSTER_COUNT * 2 * sizeof(uint32_t),
+                    .usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+                };
+
+                CreateFrameGraphBufferResource("light_clusters", bufferCreateInfo);
+            }
+
+            // Light Cluster Indices
+            {
+                // Allocation counter followed by the compacted light indices of every cluster
+                FrameGraphBufferCreateInfo bufferCreateInfo{
+                    .size = (1 + LIGHT_CLUSTER_INDEX_CAPACITY) * sizeof(uint32_t),
+                    .usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+                };
+
+                CreateFrameGraphBufferResource("light_cluster_indices", bufferCreateInfo);
+            }
+
             // Directional Shadow Map
             {
                 constexpr uint16_t SHADOW_MAP_RESOLUTION = 4096;
@@ -364,7 +1503,7 @@ namespace MongooseVK
                                       : RenderPassOperation::LoadOp::Load,
                         .storeOp = RenderPassOperation::StoreOp::Store,
                         .initialLayout = ImageUtils::GetLayoutFromFormat(format),
-                        .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        .finalLayout = ImageUtils::GetLayoutFromFormat(format),
                     });
                 } else
                 {
@@ -373,6 +1512,7 @@ namespace MongooseVK
                         .loadOp = usage.access == ResourceUsage::Access::Write
                                       ? RenderPassOperation::LoadOp::Clear
                                       : RenderPassOperation::LoadOp::Load,
+                        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
                     });
                 }
             }
@@ -420,48 +1560,55 @@ namespace MongooseVK
 
         void FrameGraph::CreateFrameGraphTextureResource(const char* resourceName, const TextureCreateInfo& createInfo)
         {
-            if (resourceHandles.contains(resourceName))
+            if (const auto declared = renderPassResourceMap.find(resourceName); declared != renderPassResourceMap.end())
             {
-                FrameGraphResource* resource = resourcePool.Get(resourceHandles[resourceName].index);
-
-                device->DestroyTexture(resource->textureHandle);
-
-                resourceHandles.erase(resourceName);
-                resourcePool.Release(resource);
+                device->DestroyTexture(declared->second->textureHandle);
+                resourcePool.Release(declared->second);
             }
 
+            // Only declared here, CreateTextures places it in memory once the pass order is known
             FrameGraphResource* graphResource = resourcePool.Obtain();
             graphResource->name = resourceName;
             graphResource->type = ResourceUsage::Type::Texture;
             graphResource->textureInfo = createInfo;
-            graphResource->textureHandle = device->CreateTexture(createInfo);
+            graphResource->textureHandle = INVALID_TEXTURE_HANDLE;
 
-            resourceHandles[graphResource->name] = {graphResource->index};
+            RegisterResource(graphResource->name, graphResource);
             renderPassResourceMap[graphResource->name] = graphResource;
         }
 
         void FrameGraph::CreateFrameGraphBufferResource(const char* resourceName, FrameGraphBufferCreateInfo& createInfo)
         {
-            if (resourceHandles.contains(resourceName))
+            if (const auto declared = renderPassResourceMap.find(resourceName); declared != renderPassResourceMap.end())
             {
-                FrameGraphResource* resource = resourcePool.Get(resourceHandles[resourceName].index);
-
-                device->DestroyBuffer(resource->allocatedBuffer);
-
-                resourceHandles.erase(resourceName);
-                resourcePool.Release(resource);
+                device->DestroyBuffer(declared->second->allocatedBuffer);
+                resourcePool.Release(declared->second);
             }
 
             FrameGraphResource* graphResource = resourcePool.Obtain();
             graphResource->name = resourceName;
             graphResource->type = ResourceUsage::Type::Buffer;
+            graphResource->bufferInfo = createInfo;
             graphResource->allocatedBuffer = device->CreateBuffer(
                 createInfo.size,
                 createInfo.usageFlags,
                 createInfo.memoryUsage
             );
 
-            resourceHandles[graphResource->name] = {graphResource->index};
+            RegisterResource(graphResource->name, graphResource);
+            renderPassResourceMap[graphResource->name] = graphResource;
+        }
+
+        void FrameGraph::CreateFrameGraphVirtualResource(const char* resourceName)
+        {
+            if (const auto declared = renderPassResourceMap.find(resourceName); declared != renderPassResourceMap.end())
+                resourcePool.Release(declared->second);
+
+            FrameGraphResource* graphResource = resourcePool.Obtain();
+            graphResource->name = resourceName;
+            graphResource->type = ResourceUsage::Type::Virtual;
+
+            RegisterResource(graphResource->name, graphResource);
             renderPassResourceMap[graphResource->name] = graphResource;
         }
     }
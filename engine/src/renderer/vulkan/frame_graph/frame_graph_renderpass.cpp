@@ -2,6 +2,7 @@
 
 #include <ranges>
 #include <renderer/vulkan/vulkan_descriptor_writer.h>
+#include <renderer/vulkan/vulkan_framebuffer.h>
 #include <renderer/vulkan/vulkan_image.h>
 #include <renderer/vulkan/vulkan_texture.h>
 #include <resource/resource.h>
@@ -77,15 +78,32 @@ namespace MongooseVK
             return device->renderPassPool.Get(renderPassHandle.handle);
         }
 
+        VkCommandBuffer FrameGraphRenderPass::BeginRenderPass(const VkCommandBuffer commandBuffer, const VulkanFramebuffer* framebuffer)
+        {
+            if (commandRecorder) return commandRecorder->BeginRenderPass(GetRenderPass(), framebuffer);
+
+            GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
+            return commandBuffer;
+        }
+
+        VkCommandBuffer FrameGraphRenderPass::EndRenderPass(const VkCommandBuffer commandBuffer)
+        {
+            if (commandRecorder) return commandRecorder->EndRenderPass();
+
+            GetRenderPass()->End(commandBuffer);
+            return commandBuffer;
+        }
+
         void FrameGraphRenderPass::AddOutput(FrameGraphResource* output, ResourceUsage usage)
         {
             outputs.push_back({output, usage});
+            output->accesses.push_back({this, usage.access});
         }
 
-
         void FrameGraphRenderPass::AddInput(FrameGraphResource* input)
         {
             inputs.push_back(input);
+            input->accesses.push_back({this, ResourceUsage::Access::Read});
         }
 
         void FrameGraphRenderPass::CreateRenderPass()
@@ -94,8 +112,10 @@ namespace MongooseVK
 
             for (const auto& [resource, usage]: outputs)
             {
-                if (resource->type == ResourceUsage::Type::Buffer) continue;
+                if (resource->type != ResourceUsage::Type::Texture) continue;
 
+                // Inside a frame graph the attachments stay in their attachment layouts, the graph transitions them
+                // in between passes. Standalone passes leave their outputs ready to be sampled.
                 const ImageFormat format = resource->textureInfo.format;
                 if (!IsDepthFormat(format))
                 {
@@ -106,7 +126,9 @@ namespace MongooseVK
                                       : RenderPassOperation::LoadOp::Load,
                         .storeOp = RenderPassOperation::StoreOp::Store,
                         .initialLayout = ImageUtils::GetLayoutFromFormat(format),
-                        .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        .finalLayout = graphSynchronized
+                                           ? ImageUtils::GetLayoutFromFormat(format)
+                                           : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                     });
                 } else
                 {
@@ -115,6 +137,9 @@ namespace MongooseVK
                         .loadOp = usage.access == ResourceUsage::Access::Write
                                       ? RenderPassOperation::LoadOp::Clear
                                       : RenderPassOperation::LoadOp::Load,
+                        .initialLayout = graphSynchronized
+                                             ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                                             : VK_IMAGE_LAYOUT_UNDEFINED,
                     });
                 }
             }
@@ -127,6 +152,15 @@ namespace MongooseVK
             PipelineCreateInfo pipelineCreate{};
             LoadPipeline(pipelineCreate);
 
+            if (pipelineCreate.name != "" && pipelineCreate.computeShaderPath != "")
+            {
+                shaderStages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+                LOG_TRACE(pipelineCreate.name);
+                pipelineHandle = VulkanPipelineBuilder().Build(device, pipelineCreate);
+                return;
+            }
+
             if (pipelineCreate.name == "" || pipelineCreate.vertexShaderPath == "" || pipelineCreate.fragmentShaderPath == "") return;
 
             LOG_TRACE(pipelineCreate.name);
@@ -149,9 +183,17 @@ namespace MongooseVK
 
             for (uint32_t i = 0; i < inputs.size(); i++)
             {
-                const DescriptorSetBindingType type = inputs[i]->type == ResourceUsage::Type::Buffer
-                                                          ? DescriptorSetBindingType::UniformBuffer
-                                                          : DescriptorSetBindingType::TextureSampler;
+                if (inputs[i]->type == ResourceUsage::Type::Virtual) continue;
+
+                DescriptorSetBindingType type = DescriptorSetBindingType::TextureSampler;
+                if (inputs[i]->type == ResourceUsage::Type::Buffer)
+                {
+                    if (inputs[i]->bufferInfo.usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                        type = inputs[i]->dynamicBinding ? DescriptorSetBindingType::StorageBufferDynamic : DescriptorSetBindingType::StorageBuffer;
+                    else
+                        type = inputs[i]->dynamicBinding ? DescriptorSetBindingType::UniformBufferDynamic : DescriptorSetBindingType::UniformBuffer;
+                }
+
                 descriptorSetLayoutBuilder.AddBinding({i, type, {ShaderStage::VertexShader, ShaderStage::FragmentShader}});
             }
             passDescriptorSetLayoutHandle = descriptorSetLayoutBuilder.Build();
@@ -161,14 +203,7 @@ namespace MongooseVK
             for (uint32_t i = 0; i < inputs.size(); i++)
             {
                 if (inputs[i]->type == ResourceUsage::Type::Buffer)
-                {
-                    VkDescriptorBufferInfo bufferInfo{};
-                    bufferInfo.buffer = inputs[i]->allocatedBuffer.buffer;
-                    bufferInfo.offset = 0;
-                    bufferInfo.range = inputs[i]->allocatedBuffer.info.size;
-
-                    descriptorSetWriter.WriteBuffer(i, bufferInfo);
-                }
+                    descriptorSetWriter.WriteBuffer(i, GetDescriptorBufferInfo(inputs[i]));
 
                 if (inputs[i]->type == ResourceUsage::Type::Texture)
                 {
@@ -178,11 +213,7 @@ namespace MongooseVK
                     VkDescriptorImageInfo imageInfo{};
                     imageInfo.sampler = texture->GetSampler();
                     imageInfo.imageView = texture->GetImageView();
-                    imageInfo.imageLayout = IsDepthFormat(format)
-                                                ? format == ImageFormat::DEPTH32
-                                                      ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL
-                                                      : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-                                                : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                    imageInfo.imageLayout = ImageUtils::GetShaderReadLayoutFromFormat(format);
 
                     descriptorSetWriter.WriteImage(i, imageInfo);
                 }
@@ -191,6 +222,31 @@ namespace MongooseVK
             descriptorSetWriter.Build(passDescriptorSet);
         }
 
+        VkDescriptorBufferInfo FrameGraphRenderPass::GetDescriptorBufferInfo(const FrameGraphResource* resource)
+        {
+            return {
+                .buffer = resource->allocatedBuffer.buffer,
+                .offset = 0,
+                .range = resource->dynamicBinding ? resource->bufferInfo.size : resource->allocatedBuffer.info.size,
+            };
+        }
+
+        std::span<const uint32_t> FrameGraphRenderPass::GetDynamicOffsets() const
+        {
+            const auto dynamicInputs = inputs | std::views::filter([](const FrameGraphResource* input) {
+                return input->dynamicBinding;
+            });
+
+            const size_t count = std::ranges::distance(dynamicInputs);
+            if (count == 0) return {};
+
+            uint32_t* offsets = device->GetFrameArena().Allocate<uint32_t>(count);
+            for (size_t i = 0; const FrameGraphResource* input: dynamicInputs)
+                offsets[i++] = input->dynamicOffset;
+
+            return {offsets, count};
+        }
+
         void FrameGraphRenderPass::CreateFramebuffer()
         {
             FramebufferCreateInfo framebufferCreateInfo = {
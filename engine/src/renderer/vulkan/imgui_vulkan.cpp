@@ -6,6 +6,7 @@
 
 #include "imgui_internal.h"
 #include "renderer/vulkan/vulkan_utils.h"
+#include "util/profiler.h"
 
 #define APP_USE_UNLIMITED_FRAME_RATE
 
@@ -207,7 +208,7 @@ namespace MongooseVK
         init_info.QueueFamily = vulkanDevice->GetQueueFamilyIndex();
         init_info.Queue = vulkanDevice->GetPresentQueue();
         init_info.DescriptorPool = vulkanDevice->GetGuiDescriptorPool();
-        init_info.RenderPass = renderer->frameGraph->renderPasses["UiPass"]->GetRenderPass()->Get();
+        init_info.RenderPass = renderer->frameGraph->GetPass("UiPass")->GetRenderPass()->Get();
         init_info.MinImageCount = 2;
         init_info.ImageCount = 2;
         init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
@@ -218,6 +219,8 @@ namespace MongooseVK
 
     void ImGuiVulkan::DrawUi()
     {
+        PROFILE_FUNCTION();
+
         const auto io = ImGui::GetIO();
 
         // Start the Dear ImGui frame
@@ -228,7 +231,17 @@ namespace MongooseVK
         ImGui::Begin("Debug Window");
         for (ImGuiWindow* uiWindow: uiWindows)
         {
-            if (ImGui::CollapsingHeader(uiWindow->GetTitle()))
+            const bool open = ImGui::CollapsingHeader(uiWindow->GetTitle());
+            if (open != uiWindow->isOpen)
+            {
+                uiWindow->isOpen = open;
+                if (open)
+                    uiWindow->OnOpen();
+                else
+                    uiWindow->OnClose();
+            }
+
+            if (open)
             {
                 uiWindow->Draw();
             }
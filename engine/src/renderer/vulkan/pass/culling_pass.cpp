@@ -0,0 +1,97 @@
+#include "renderer/vulkan/pass/culling_pass.h"
+
+#include "renderer/vulkan/vulkan_descriptor_writer.h"
+#include "renderer/vulkan/vulkan_texture.h"
+
+namespace MongooseVK
+{
+    CullingPass::CullingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution, const CullingPhase _phase)
+        : FrameGraphRenderPass(vulkanDevice, _resolution), phase(_phase) {}
+
+    void CullingPass::Init()
+    {
+        // Compute only, there are no attachments to create
+        CreateDescriptors();
+        CreatePipeline();
+    }
+
+    void CullingPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
+    {
+        const VulkanGpuScene* gpuScene = scene->gpuScene;
+        if (!gpuScene || gpuScene->GetDrawCount() == 0) return;
+
+        if (phase == CULLING_PHASE_EARLY)
+        {
+            const AllocatedBuffer& drawCountBuffer = gpuScene->GetDrawCountBuffer();
+            vkCmdFillBuffer(commandBuffer, drawCountBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+            const AllocatedBuffer& cullingStatsBuffer = gpuScene->GetCullingStatsBuffer();
+            vkCmdFillBuffer(commandBuffer, cullingStatsBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+        }
+
+        // Also orders the visibility reads after the late phase of the previous frame, and in the late phase the
+        // counters after the early phase
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+        const VulkanPipeline* pipeline = device->GetPipeline(pipelineHandle);
+        CullingPushConstantData pushConstantData = gpuScene->GetCullingPushConstantData(phase);
+        pushConstantData.depthResolution = {resolution.width, resolution.height};
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, 1,
+                                &passDescriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipeline->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           sizeof(CullingPushConstantData), &pushConstantData);
+        vkCmdDispatch(commandBuffer, (pushConstantData.drawCount + CULLING_WORKGROUP_SIZE - 1) / CULLING_WORKGROUP_SIZE, 1, 1);
+
+        // The statistics are read back on the CPU once the frame fence is signaled
+        VkMemoryBarrier cullingBarrier{};
+        cullingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullingBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullingBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                             0, 1, &cullingBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    void CullingPass::Resize(VkExtent2D _resolution) {}
+
+    void CullingPass::CreateDescriptors()
+    {
+        passDescriptorSetLayoutHandle = VulkanDescriptorSetLayoutBuilder(device)
+                                        .AddBinding({0, DescriptorSetBindingType::TextureSampler, {ShaderStage::ComputeShader}})
+                                        .Build();
+
+        // The early phase never samples the pyramid, it is bound in both phases to share the pipeline layout
+        const VulkanTexture* depthPyramid = device->GetTexture(inputs[0]->textureHandle);
+
+        VkDescriptorImageInfo depthPyramidInfo{};
+        depthPyramidInfo.sampler = depthPyramid->GetSampler();
+        depthPyramidInfo.imageView = depthPyramid->GetImageView();
+        depthPyramidInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VulkanDescriptorWriter(*device->GetDescriptorSetLayout(passDescriptorSetLayoutHandle), device->GetShaderDescriptorPool())
+                .WriteImage(0, depthPyramidInfo)
+                .Build(passDescriptorSet);
+    }
+
+    void CullingPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
+    {
+        pipelineCreate.name = phase == CULLING_PHASE_EARLY ? "CullingPass" : "OcclusionCullingPass";
+        pipelineCreate.computeShaderPath = "draw_culling.comp";
+        pipelineCreate.descriptorSetLayouts = {passDescriptorSetLayoutHandle};
+
+        pipelineCreate.pushConstantData.shaderStageBits = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreate.pushConstantData.size = sizeof(CullingPushConstantData);
+    }
+}
@@ -0,0 +1,128 @@
+#include "renderer/vulkan/pass/depth_pyramid_pass.h"
+
+#include <algorithm>
+
+#include "renderer/vulkan/vulkan_descriptor_writer.h"
+#include "renderer/vulkan/vulkan_gpu_scene.h"
+#include "renderer/vulkan/vulkan_texture.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static constexpr uint32_t DEPTH_PYRAMID_WORKGROUP_SIZE = 8;
+    }
+
+    DepthPyramidPass::DepthPyramidPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution) {}
+
+    DepthPyramidPass::~DepthPyramidPass()
+    {
+        if (!mipDescriptorSets.empty())
+            vkFreeDescriptorSets(device->GetDevice(), device->GetShaderDescriptorPool().GetDescriptorPool(),
+                                 static_cast<uint32_t>(mipDescriptorSets.size()), mipDescriptorSets.data());
+    }
+
+    void DepthPyramidPass::Init()
+    {
+        // Compute only, the pyramid mips are written as storage images
+        CreateDescriptors();
+        CreatePipeline();
+    }
+
+    void DepthPyramidPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
+    {
+        const VulkanGpuScene* gpuScene = scene->gpuScene;
+        if (!gpuScene || gpuScene->GetDrawCount() == 0) return;
+
+        // The frame graph moves the depth buffer into a read only layout and the pyramid into GENERAL before the pass
+        const VulkanTexture* pyramidTexture = device->GetTexture(outputs[0].first->textureHandle);
+        const uint32_t mipLevels = pyramidTexture->createInfo.mipLevels;
+
+        const VulkanPipeline* pipeline = device->GetPipeline(pipelineHandle);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+
+        VkExtent2D sourceSize = resolution;
+        for (uint32_t mip = 0; mip < mipLevels; mip++)
+        {
+            const VkExtent2D destinationSize = {std::max(sourceSize.width / 2, 1u), std::max(sourceSize.height / 2, 1u)};
+
+            const DepthPyramidPushConstantData pushConstantData{
+                .sourceSize = glm::ivec2(sourceSize.width, sourceSize.height),
+                .destinationSize = glm::ivec2(destinationSize.width, destinationSize.height),
+            };
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, 1,
+                                    &mipDescriptorSets[mip], 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipeline->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                               sizeof(DepthPyramidPushConstantData), &pushConstantData);
+            vkCmdDispatch(commandBuffer,
+                          (destinationSize.width + Utils::DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / Utils::DEPTH_PYRAMID_WORKGROUP_SIZE,
+                          (destinationSize.height + Utils::DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / Utils::DEPTH_PYRAMID_WORKGROUP_SIZE,
+                          1);
+
+            sourceSize = destinationSize;
+
+            // Makes the mip visible to the next reduction, the frame graph syncs the last one with the late culling phase
+            if (mip + 1 == mipLevels) break;
+
+            VkMemoryBarrier mipBarrier{};
+            mipBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            mipBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            mipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 0, 1, &mipBarrier, 0, nullptr, 0, nullptr);
+        }
+    }
+
+    void DepthPyramidPass::Resize(VkExtent2D _resolution) {}
+
+    void DepthPyramidPass::CreateDescriptors()
+    {
+        passDescriptorSetLayoutHandle = VulkanDescriptorSetLayoutBuilder(device)
+                                        .AddBinding({0, DescriptorSetBindingType::TextureSampler, {ShaderStage::ComputeShader}})
+                                        .AddBinding({1, DescriptorSetBindingType::StorageImage, {ShaderStage::ComputeShader}})
+                                        .Build();
+
+        const VulkanTexture* depthTexture = device->GetTexture(inputs[0]->textureHandle);
+        const VulkanTexture* pyramidTexture = device->GetTexture(outputs[0].first->textureHandle);
+
+        mipDescriptorSets.resize(pyramidTexture->createInfo.mipLevels);
+        for (uint32_t mip = 0; mip < mipDescriptorSets.size(); mip++)
+        {
+            VkDescriptorImageInfo sourceInfo{};
+            if (mip == 0)
+            {
+                sourceInfo.sampler = depthTexture->GetSampler();
+                sourceInfo.imageView = depthTexture->GetImageView();
+                sourceInfo.imageLayout = ImageUtils::GetShaderReadLayoutFromFormat(depthTexture->createInfo.format);
+            } else
+            {
+                sourceInfo.sampler = pyramidTexture->GetSampler();
+                sourceInfo.imageView = pyramidTexture->GetMipmapImageView(mip - 1, 0);
+                sourceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            }
+
+            VkDescriptorImageInfo destinationInfo{};
+            destinationInfo.imageView = pyramidTexture->GetMipmapImageView(mip, 0);
+            destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VulkanDescriptorWriter(*device->GetDescriptorSetLayout(passDescriptorSetLayoutHandle), device->GetShaderDescriptorPool())
+                    .WriteImage(0, sourceInfo)
+                    .WriteImage(1, destinationInfo)
+                    .Build(mipDescriptorSets[mip]);
+        }
+    }
+
+    void DepthPyramidPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
+    {
+        pipelineCreate.name = "DepthPyramidPass";
+        pipelineCreate.computeShaderPath = "depth_pyramid.comp";
+        pipelineCreate.descriptorSetLayouts = {passDescriptorSetLayoutHandle};
+
+        pipelineCreate.pushConstantData.shaderStageBits = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreate.pushConstantData.size = sizeof(DepthPyramidPushConstantData);
+    }
+}
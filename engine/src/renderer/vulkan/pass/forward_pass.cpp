@@ -0,0 +1,60 @@
+#include "renderer/vulkan/pass/forward_pass.h"
+
+#include <renderer/vulkan/vulkan_framebuffer.h>
+#include <renderer/vulkan/vulkan_gpu_scene.h>
+
+namespace MongooseVK
+{
+    ForwardPass::ForwardPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution) {}
+
+    void ForwardPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
+    {
+        const VulkanGpuScene* gpuScene = scene->gpuScene;
+        if (!gpuScene || gpuScene->GetDrawCount() == 0) return;
+
+        VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
+
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
+        device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
+
+        DrawDataPushConstantData pushConstantData{
+            .drawDataAddress = gpuScene->GetDrawDataAddress(),
+            .instanceDataAddress = gpuScene->GetInstanceDataAddress(),
+        };
+
+        DrawIndirectParams drawIndirectParams{};
+        drawIndirectParams.commandBuffer = commandBuffer;
+        drawIndirectParams.pipelineHandle = pipelineHandle;
+        drawIndirectParams.pushConstantParams = {&pushConstantData, sizeof(DrawDataPushConstantData)};
+        drawIndirectParams.descriptorSets = device->GetFrameArena().Copy({
+            device->bindlessTextureDescriptorSet,
+            device->materialDescriptorSet,
+            passDescriptorSet
+        });
+        drawIndirectParams.dynamicOffsets = GetDynamicOffsets();
+
+        gpuScene->FillDrawIndirectParams(drawIndirectParams, DRAW_LIST_ALPHA_TESTED);
+        device->DrawIndirect(drawIndirectParams);
+
+        EndRenderPass(commandBuffer);
+    }
+
+    void ForwardPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
+    {
+        pipelineCreate.name = "ForwardPass";
+        pipelineCreate.vertexShaderPath = "base-pass.vert";
+        pipelineCreate.fragmentShaderPath = "forward-pass.frag";
+        pipelineCreate.vertexFormat = vertexFormat;
+
+        pipelineCreate.descriptorSetLayouts = {
+            device->bindlessTexturesDescriptorSetLayoutHandle,
+            device->materialsDescriptorSetLayoutHandle,
+            passDescriptorSetLayoutHandle
+        };
+
+        pipelineCreate.disableBlending = false;
+
+        pipelineCreate.pushConstantData.shaderStageBits = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pipelineCreate.pushConstantData.size = sizeof(DrawDataPushConstantData);
+    }
+}
@@ -3,60 +3,54 @@
 #include <random>
 #include <glm/gtc/packing.inl>
 #include <renderer/vulkan/vulkan_framebuffer.h>
-#include <renderer/vulkan/vulkan_mesh.h>
+#include <renderer/vulkan/vulkan_gpu_scene.h>
 
 #include "renderer/vulkan/vulkan_pipeline.h"
 
 namespace MongooseVK
 {
-    GBufferPass::GBufferPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution) {}
+    GBufferPass::GBufferPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution, const DrawList _drawList)
+        : FrameGraphRenderPass(vulkanDevice, _resolution), drawList(_drawList) {}
 
     void GBufferPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
     {
         const VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(resolution, commandBuffer);
-        GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, resolution);
 
-        DrawCommandParams drawCommandParams{};
-        drawCommandParams.commandBuffer = commandBuffer;
-        drawCommandParams.pipelineHandle = pipelineHandle;
-
-        for (size_t i = 0; i < scene->meshes.size(); i++)
+        const VulkanGpuScene* gpuScene = scene->gpuScene;
+        if (gpuScene && gpuScene->GetDrawCount() > 0)
         {
-            if (!scene->meshes[i]) continue;
-
-            for (auto& meshlet: scene->meshes[i]->GetMeshlets())
-            {
-                VulkanMaterial* material = device->GetMaterial(meshlet.material);
-
-                if (material->params.alphaTested) continue;
-
-                SimplePushConstantData pushConstantData{
-                    .modelMatrix = scene->GetTransform(i).GetTransform(),
-                    .materialIndex = material->index,
-                };
-
-                drawCommandParams.meshlet = &meshlet;
-                drawCommandParams.pushConstantParams = {&pushConstantData, sizeof(SimplePushConstantData)};
-                drawCommandParams.descriptorSets = {
-                    device->bindlessTextureDescriptorSet,
-                    device->materialDescriptorSet,
-                    passDescriptorSet
-                };
-
-                device->DrawMeshlet(drawCommandParams);
-            }
+            DrawDataPushConstantData pushConstantData{
+                .drawDataAddress = gpuScene->GetDrawDataAddress(),
+                .instanceDataAddress = gpuScene->GetInstanceDataAddress(),
+            };
+
+            DrawIndirectParams drawIndirectParams{};
+            drawIndirectParams.commandBuffer = commandBuffer;
+            drawIndirectParams.pipelineHandle = pipelineHandle;
+            drawIndirectParams.pushConstantParams = {&pushConstantData, sizeof(DrawDataPushConstantData)};
+            drawIndirectParams.descriptorSets = device->GetFrameArena().Copy({
+                device->bindlessTextureDescriptorSet,
+                device->materialDescriptorSet,
+                passDescriptorSet
+            });
+            drawIndirectParams.dynamicOffsets = GetDynamicOffsets();
+
+            gpuScene->FillDrawIndirectParams(drawIndirectParams, drawList);
+            device->DrawIndirect(drawIndirectParams);
         }
 
-        GetRenderPass()->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void GBufferPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
     {
-        pipelineCreate.name = "GBufferPass";
+        pipelineCreate.name = drawList == DRAW_LIST_OPAQUE_LATE ? "GBufferLatePass" : "GBufferPass";
         pipelineCreate.vertexShaderPath = "gbuffer.vert";
         pipelineCreate.fragmentShaderPath = "gbuffer.frag";
+        pipelineCreate.vertexFormat = vertexFormat;
 
         pipelineCreate.descriptorSetLayouts = {
             device->bindlessTexturesDescriptorSetLayoutHandle,
@@ -66,7 +60,7 @@ namespace MongooseVK
 
         pipelineCreate.pushConstantData = {
             .shaderStageBits = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            .size = sizeof(SimplePushConstantData),
+            .size = sizeof(DrawDataPushConstantData),
         };
     }
 }
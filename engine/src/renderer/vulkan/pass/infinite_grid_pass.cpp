@@ -17,8 +17,8 @@ namespace MongooseVK
     {
         const VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-        GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
 
         DrawCommandParams drawCommandParams{};
         drawCommandParams.commandBuffer = commandBuffer;
@@ -26,14 +26,15 @@ namespace MongooseVK
         drawCommandParams.pushConstantParams.data = &gridParams;
         drawCommandParams.pushConstantParams.size = sizeof(GridParams);
         drawCommandParams.pipelineHandle = pipelineHandle;
-        drawCommandParams.descriptorSets = {
+        drawCommandParams.descriptorSets = device->GetFrameArena().Copy({
             device->bindlessTextureDescriptorSet,
             device->materialDescriptorSet,
             passDescriptorSet
-        };
+        });
+        drawCommandParams.dynamicOffsets = GetDynamicOffsets();
 
         device->DrawMeshlet(drawCommandParams);
-        GetRenderPass()->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void InfiniteGridPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
@@ -0,0 +1,94 @@
+#include "renderer/vulkan/pass/light_clustering_pass.h"
+
+#include <algorithm>
+
+#include "renderer/vulkan/vulkan_descriptor_writer.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static constexpr uint32_t LIGHT_CLUSTERING_WORKGROUP_SIZE = 128;
+    }
+
+    LightClusteringPass::LightClusteringPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution) {}
+
+    void LightClusteringPass::Init()
+    {
+        // Compute only, there are no attachments to create
+        CreateDescriptors();
+        CreatePipeline();
+
+        // The index counter is cleared right before the dispatch
+        shaderStages |= VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    }
+
+    void LightClusteringPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
+    {
+        const uint32_t lightCount = static_cast<uint32_t>(std::min<size_t>(scene->pointLights.size() + scene->spotLights.size(),
+                                                                            MAX_SCENE_LIGHTS));
+
+        // The lighting shaders skip the clusters entirely without scene lights
+        if (lightCount == 0) return;
+
+        const AllocatedBuffer& lightClusterIndices = outputs[1].first->allocatedBuffer;
+
+        // The frame graph orders the clear and the dispatch after the previous frame's lighting reads
+        vkCmdFillBuffer(commandBuffer, lightClusterIndices.buffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+        const VulkanPipeline* pipeline = device->GetPipeline(pipelineHandle);
+        const LightClusteringPushConstantData pushConstantData{};
+        const std::span<const uint32_t> dynamicOffsets = GetDynamicOffsets();
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, 1,
+                                &passDescriptorSet, dynamicOffsets.size(), dynamicOffsets.data());
+        vkCmdPushConstants(commandBuffer, pipeline->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           sizeof(LightClusteringPushConstantData), &pushConstantData);
+        vkCmdDispatch(commandBuffer, (LIGHT_CLUSTER_COUNT + Utils::LIGHT_CLUSTERING_WORKGROUP_SIZE - 1) / Utils::LIGHT_CLUSTERING_WORKGROUP_SIZE,
+                      1, 1);
+    }
+
+    void LightClusteringPass::Resize(VkExtent2D _resolution) {}
+
+    void LightClusteringPass::CreateDescriptors()
+    {
+        passDescriptorSetLayoutHandle = VulkanDescriptorSetLayoutBuilder(device)
+                                        .AddBinding({0, DescriptorSetBindingType::UniformBufferDynamic, {ShaderStage::ComputeShader}})
+                                        .AddBinding({1, DescriptorSetBindingType::UniformBufferDynamic, {ShaderStage::ComputeShader}})
+                                        .AddBinding({2, DescriptorSetBindingType::StorageBufferDynamic, {ShaderStage::ComputeShader}})
+                                        .AddBinding({3, DescriptorSetBindingType::StorageBuffer, {ShaderStage::ComputeShader}})
+                                        .AddBinding({4, DescriptorSetBindingType::StorageBuffer, {ShaderStage::ComputeShader}})
+                                        .Build();
+
+        // Camera, lights and scene lights in, light clusters and their index lists out
+        VulkanDescriptorWriter(*device->GetDescriptorSetLayout(passDescriptorSetLayoutHandle), device->GetShaderDescriptorPool())
+                .WriteBuffer(0, GetDescriptorBufferInfo(inputs[0]))
+                .WriteBuffer(1, GetDescriptorBufferInfo(inputs[1]))
+                .WriteBuffer(2, GetDescriptorBufferInfo(inputs[2]))
+                .WriteBuffer(3, GetDescriptorBufferInfo(outputs[0].first))
+                .WriteBuffer(4, GetDescriptorBufferInfo(outputs[1].first))
+                .Build(passDescriptorSet);
+    }
+
+    void LightClusteringPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
+    {
+        pipelineCreate.name = "LightClusteringPass";
+        pipelineCreate.computeShaderPath = "light_clustering.comp";
+        pipelineCreate.descriptorSetLayouts = {passDescriptorSetLayoutHandle};
+
+        pipelineCreate.pushConstantData.shaderStageBits = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreate.pushConstantData.size = sizeof(LightClusteringPushConstantData);
+    }
+}
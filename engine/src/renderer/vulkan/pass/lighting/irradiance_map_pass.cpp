@@ -57,10 +57,10 @@ namespace MongooseVK
             drawCommandParams.commandBuffer = commandBuffer;
             drawCommandParams.meshlet = &cubeMesh->GetMeshlets()[0];
             drawCommandParams.pipelineHandle = pipelineHandle;
-            drawCommandParams.descriptorSets = {
+            drawCommandParams.descriptorSets = device->GetFrameArena().Copy({
                 device->bindlessTextureDescriptorSet,
                 passDescriptorSet
-            };
+            });
 
             IrradiancePushConstantData pushConstantData;
             pushConstantData.projection = m_CaptureProjection;
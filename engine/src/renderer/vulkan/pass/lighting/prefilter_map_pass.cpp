@@ -69,10 +69,10 @@ namespace MongooseVK
                 drawCommandParams.commandBuffer = commandBuffer;
                 drawCommandParams.pipelineHandle = pipelineHandle;
                 drawCommandParams.meshlet = &cubeMesh->GetMeshlets()[0];
-                drawCommandParams.descriptorSets = {
+                drawCommandParams.descriptorSets = device->GetFrameArena().Copy({
                     device->bindlessTextureDescriptorSet,
                     passDescriptorSet
-                };
+                });
 
                 PrefilterData pushConstantData;
                 pushConstantData.projection = m_CaptureProjection;
@@ -1,73 +1,52 @@
 #include "renderer/vulkan/pass/lighting_pass.h"
 
+#include <renderer/mesh.h>
 #include <renderer/vulkan/vulkan_framebuffer.h>
-#include <renderer/vulkan/vulkan_mesh.h>
-
-#include "renderer/shader_cache.h"
-#include "resource/resource_manager.h"
-#include "util/log.h"
 
 namespace MongooseVK
 {
-    LightingPass::LightingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution) {}
+    LightingPass::LightingPass(VulkanDevice* vulkanDevice, VkExtent2D _resolution): FrameGraphRenderPass(vulkanDevice, _resolution)
+    {
+        screenRect = CreateScope<VulkanMesh>(device);
+        screenRect->AddMeshlet(Primitives::RECTANGLE_VERTICES, Primitives::RECTANGLE_INDICES);
+    }
 
     void LightingPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
     {
         VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-        GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
-
-        DrawCommandParams drawCommandParams{};
-        drawCommandParams.commandBuffer = commandBuffer;
-        drawCommandParams.pipelineHandle = pipelineHandle;
-
-        for (size_t i = 0; i < scene->meshes.size(); i++)
-        {
-            if (!scene->meshes[i]) continue;
-
-            for (auto& meshlet: scene->meshes[i]->GetMeshlets())
-            {
-                VulkanMaterial* material = device->GetMaterial(meshlet.material);
 
-                SimplePushConstantData pushConstantData;
-                pushConstantData.modelMatrix = scene->GetTransform(i).GetTransform();
-                pushConstantData.materialIndex = material->index;
+        DrawCommandParams drawParams{};
+        drawParams.commandBuffer = commandBuffer;
+        drawParams.meshlet = &screenRect->GetMeshlets()[0];
+        drawParams.pipelineHandle = pipelineHandle;
+        drawParams.descriptorSets = device->GetFrameArena().Copy({
+            device->bindlessTextureDescriptorSet,
+            device->materialDescriptorSet,
+            passDescriptorSet
+        });
+        drawParams.dynamicOffsets = GetDynamicOffsets();
 
-                drawCommandParams.pushConstantParams = {
-                    &pushConstantData,
-                    sizeof(SimplePushConstantData)
-                };
+        device->DrawMeshlet(drawParams);
 
-                drawCommandParams.meshlet = &meshlet;
-                drawCommandParams.descriptorSets = {
-                    device->bindlessTextureDescriptorSet,
-                    device->materialDescriptorSet,
-                    passDescriptorSet
-                };
-
-                device->DrawMeshlet(drawCommandParams);
-            }
-        }
-
-        GetRenderPass()->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void LightingPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
     {
         pipelineCreate.name = "LightingPass";
-        pipelineCreate.vertexShaderPath = "base-pass.vert";
-        pipelineCreate.fragmentShaderPath = "lighting-pass.frag";
+        pipelineCreate.vertexShaderPath = "quad.vert";
+        pipelineCreate.fragmentShaderPath = "deferred_lighting.frag";
+
+        pipelineCreate.cullMode = PipelineCullMode::Front;
+        pipelineCreate.enableDepthTest = false;
 
         pipelineCreate.descriptorSetLayouts = {
             device->bindlessTexturesDescriptorSetLayoutHandle,
             device->materialsDescriptorSetLayoutHandle,
             passDescriptorSetLayoutHandle
         };
-
-        pipelineCreate.disableBlending = false;
-
-        pipelineCreate.pushConstantData.shaderStageBits = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pipelineCreate.pushConstantData.size = sizeof(SimplePushConstantData);
     }
 }
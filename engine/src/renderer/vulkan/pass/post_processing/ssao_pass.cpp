@@ -47,19 +47,18 @@ namespace MongooseVK
     {
         VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-        VulkanRenderPass* renderPass = device->renderPassPool.Get(renderPassHandle.handle);
-
-        renderPass->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
 
         DrawCommandParams drawParams{};
         drawParams.commandBuffer = commandBuffer;
         drawParams.meshlet = &screenRect->GetMeshlets()[0];
         drawParams.pipelineHandle = pipelineHandle;
-        drawParams.descriptorSets = {
+        drawParams.descriptorSets = device->GetFrameArena().Copy({
             passDescriptorSet,
             ssaoDescriptorSet,
-        };
+        });
+        drawParams.dynamicOffsets = GetDynamicOffsets();
 
         ssaoParams.resolution = glm::vec2(resolution.width, resolution.height);
         drawParams.pushConstantParams = {
@@ -68,7 +67,7 @@ namespace MongooseVK
         };
 
         device->DrawMeshlet(drawParams);
-        renderPass->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void SSAOPass::Resize(VkExtent2D _resolution)
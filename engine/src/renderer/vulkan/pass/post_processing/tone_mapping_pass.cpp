@@ -17,10 +17,8 @@ namespace MongooseVK
     {
         VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-        VulkanRenderPass* renderPass = device->renderPassPool.Get(renderPassHandle.handle);
-
-        renderPass->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
 
         DrawCommandParams drawParams{};
         drawParams.commandBuffer = commandBuffer;
@@ -28,9 +26,9 @@ namespace MongooseVK
 
         drawParams.pipelineHandle = pipelineHandle;
 
-        drawParams.descriptorSets = {
+        drawParams.descriptorSets = device->GetFrameArena().Copy({
             passDescriptorSet,
-        };
+        });
 
         drawParams.pushConstantParams = {
             &toneMappingParams,
@@ -38,7 +36,7 @@ namespace MongooseVK
         };
 
         device->DrawMeshlet(drawParams);
-        renderPass->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void ToneMappingPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
@@ -1,7 +1,7 @@
 #include "renderer/vulkan/pass/shadow_map_pass.h"
 
 #include <renderer/vulkan/vulkan_framebuffer.h>
-#include <renderer/vulkan/vulkan_mesh.h>
+#include <renderer/vulkan/vulkan_gpu_scene.h>
 #include <renderer/vulkan/vulkan_texture.h>
 
 #include "renderer/shader_cache.h"
@@ -33,41 +33,37 @@ namespace MongooseVK
 
     void ShadowMapPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
     {
+        const VulkanGpuScene* gpuScene = scene->gpuScene;
+
         for (uint32_t i = 0; i < framebufferHandles.size(); i++)
         {
             VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[i]);
 
+            commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
             device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-            GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
-
-            DrawCommandParams geometryDrawParams{};
-            geometryDrawParams.commandBuffer = commandBuffer;
-            geometryDrawParams.pipelineHandle = pipelineHandle;
-
-            ShadowMapPushConstantData pushConstantData;
 
-            pushConstantData.projection = scene->directionalLight.cascades[i].viewProjMatrix;
-
-            for (size_t i = 0; i < scene->meshes.size(); i++)
+            if (gpuScene && gpuScene->GetDrawCount() > 0)
             {
-                if (!scene->meshes[i]) continue;
-
-                pushConstantData.modelMatrix = scene->GetTransform(i).GetTransform();
-
-                geometryDrawParams.pushConstantParams = {
+                ShadowMapPushConstantData pushConstantData;
+                pushConstantData.projection = scene->directionalLight.cascades[i].viewProjMatrix;
+                pushConstantData.drawDataAddress = gpuScene->GetDrawDataAddress();
+                pushConstantData.instanceDataAddress = gpuScene->GetInstanceDataAddress();
+
+                DrawIndirectParams drawIndirectParams{};
+                drawIndirectParams.commandBuffer = commandBuffer;
+                drawIndirectParams.pipelineHandle = pipelineHandle;
+                drawIndirectParams.pushConstantParams = {
                     &pushConstantData,
                     sizeof(ShadowMapPushConstantData),
                     VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT
                 };
 
-                for (auto& meshlet: scene->meshes[i]->GetMeshlets())
-                {
-                    geometryDrawParams.meshlet = &meshlet;
-                    device->DrawMeshlet(geometryDrawParams);
-                }
+                // Each cascade has its own list, culled against the cascade frustum
+                gpuScene->FillDrawIndirectParams(drawIndirectParams, static_cast<DrawList>(DRAW_LIST_SHADOW_CASCADE_0 + i));
+                device->DrawIndirect(drawIndirectParams);
             }
 
-            GetRenderPass()->End(commandBuffer);
+            commandBuffer = EndRenderPass(commandBuffer);
         }
     }
 
@@ -78,6 +74,7 @@ namespace MongooseVK
         pipelineCreate.name = "ShadowMapPass";
         pipelineCreate.vertexShaderPath = "depth_only.vert";
         pipelineCreate.fragmentShaderPath = "empty.frag";
+        pipelineCreate.vertexFormat = vertexFormat;
 
         pipelineCreate.cullMode = PipelineCullMode::Front;
 
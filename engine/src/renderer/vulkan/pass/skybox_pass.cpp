@@ -18,18 +18,19 @@ namespace MongooseVK
     {
         const VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
 
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-        GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
 
         DrawCommandParams drawCommandParams{};
         drawCommandParams.commandBuffer = commandBuffer;
         drawCommandParams.meshlet = &cubeMesh->GetMeshlets()[0];
         drawCommandParams.pipelineHandle = pipelineHandle;
-        drawCommandParams.descriptorSets = {
+        drawCommandParams.descriptorSets = device->GetFrameArena().Copy({
             device->bindlessTextureDescriptorSet,
             device->materialDescriptorSet,
             passDescriptorSet
-        };
+        });
+        drawCommandParams.dynamicOffsets = GetDynamicOffsets();
 
         SkyboxPushConstantData pushConstantData;
         pushConstantData.skyboxTextureIndex = scene->skyboxTexture.handle;
@@ -41,7 +42,7 @@ namespace MongooseVK
 
         device->DrawMeshlet(drawCommandParams);
 
-        GetRenderPass()->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void SkyboxPass::LoadPipeline(PipelineCreateInfo& pipelineCreate)
@@ -11,11 +11,10 @@ namespace MongooseVK
     void UiPass::Render(VkCommandBuffer commandBuffer, SceneGraph* scene)
     {
         const VulkanFramebuffer* framebuffer = device->GetFramebuffer(framebufferHandles[0]);
+        commandBuffer = BeginRenderPass(commandBuffer, framebuffer);
         device->SetViewportAndScissor(framebuffer->extent, commandBuffer);
-
-        GetRenderPass()->Begin(commandBuffer, framebuffer->framebuffer, framebuffer->extent);
         ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-        GetRenderPass()->End(commandBuffer);
+        EndRenderPass(commandBuffer);
     }
 
     void UiPass::LoadPipeline(PipelineCreateInfo& pipelineCreate) {}
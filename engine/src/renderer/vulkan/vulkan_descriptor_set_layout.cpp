@@ -19,6 +19,10 @@ namespace MongooseVK
                     return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
                 case DescriptorSetBindingType::StorageBuffer:
                     return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                case DescriptorSetBindingType::UniformBufferDynamic:
+                    return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                case DescriptorSetBindingType::StorageBufferDynamic:
+                    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 
                 default:
                     ASSERT(false, "Unknown descriptor type");
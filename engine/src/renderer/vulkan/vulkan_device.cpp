@@ -5,6 +5,8 @@
 #include <backends/imgui_impl_vulkan.h>
 
 #include "util/core.h"
+#include "util/job_system.h"
+#include "util/profiler.h"
 #include "renderer/vulkan/vulkan_mesh.h"
 #include "renderer/vulkan/vulkan_utils.h"
 #include "renderer/vulkan/vulkan_pipeline.h"
@@ -43,6 +45,16 @@ namespace MongooseVK
 
     VulkanDevice::~VulkanDevice()
     {
+        uploadManager->WaitIdle();
+        for (auto& geometryArena: geometryArenas)
+            geometryArena.reset();
+
+        uniformRing.reset();
+        gpuProfiler.reset();
+        pipelineCache.reset();
+
+        uploadManager.reset();
+
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
             vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
@@ -50,6 +62,12 @@ namespace MongooseVK
             vkDestroyFence(device, inFlightFences[i], nullptr);
         }
 
+        for (const auto& framePools: secondaryCommandPools)
+        {
+            for (const SecondaryCommandPool& pool: framePools)
+                vkDestroyCommandPool(device, pool.commandPool, nullptr);
+        }
+
         vkDestroyCommandPool(device, commandPool, nullptr);
 
         vkDestroyDevice(device, nullptr);
@@ -81,16 +99,54 @@ namespace MongooseVK
         if (!params.descriptorSets.empty())
         {
             vkCmdBindDescriptorSets(params.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout,
-                                    0, params.descriptorSets.size(), params.descriptorSets.data(), 0, nullptr);
+                                    0, params.descriptorSets.size(), params.descriptorSets.data(),
+                                    params.dynamicOffsets.size(), params.dynamicOffsets.data());
         }
 
-        params.meshlet->Bind(params.commandBuffer);
-        vkCmdDrawIndexed(params.commandBuffer, params.meshlet->indices.size(), 1, 0, 0, 0);
+        const GeometryAllocation& geometry = params.meshlet->geometry;
+
+        params.meshlet->geometryArena->Bind(params.commandBuffer);
+        vkCmdDrawIndexed(params.commandBuffer, geometry.indexCount, 1, geometry.firstIndex, geometry.vertexOffset, 0);
+        drawCallCounter++;
+    }
+
+    void VulkanDevice::DrawIndirect(const DrawIndirectParams& params)
+    {
+        VulkanPipeline* pipeline = GetPipeline(params.pipelineHandle);
+
+        if (params.pushConstantParams.data)
+        {
+            vkCmdPushConstants(params.commandBuffer,
+                               pipeline->pipelineLayout,
+                               params.pushConstantParams.shaderStageFlags,
+                               0,
+                               params.pushConstantParams.size,
+                               params.pushConstantParams.data);
+        }
+
+        vkCmdBindPipeline(params.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+
+        if (!params.descriptorSets.empty())
+        {
+            vkCmdBindDescriptorSets(params.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout,
+                                    0, params.descriptorSets.size(), params.descriptorSets.data(),
+                                    params.dynamicOffsets.size(), params.dynamicOffsets.data());
+        }
+
+        params.geometryArena->Bind(params.commandBuffer);
+
+        // One call per draw list, the culling pass writes both the commands and the count
+        vkCmdDrawIndexedIndirectCount(params.commandBuffer,
+                                      params.indirectBuffer, params.indirectOffset,
+                                      params.countBuffer, params.countOffset,
+                                      params.maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
         drawCallCounter++;
     }
 
     void VulkanDevice::DrawFrame(VkSwapchainKHR swapchain, DrawFrameFunction draw, OutOfDateErrorCallback errorCallback)
     {
+        PROFILE_FUNCTION();
+
         VkResult result = SetupNextFrame(swapchain);
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -99,14 +155,23 @@ namespace MongooseVK
             return;
         }
 
-        frameDeletionQueue.Flush();
+        // The fence of this frame index has been waited on, what was released while it was last recorded can go
+        frameDeletionQueues[currentFrame].Flush();
+        deletionFrame = currentFrame;
+
+        // Anything still recorded in the upload manager has to land before this frame reads it
+        const UploadToken uploadToken = uploadManager->Flush();
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
         VK_CHECK_MSG(vkBeginCommandBuffer(commandBuffers[currentFrame], &beginInfo), "Failed to begin recording command buffer.");
+        gpuProfiler->ResetQueries(commandBuffers[currentFrame]);
 
-        draw(commandBuffers[currentFrame], currentImageIndex);
+        {
+            PROFILE_SCOPE("Record frame");
+            draw(commandBuffers[currentFrame], currentImageIndex);
+        }
 
         // End command buffer
         result = vkEndCommandBuffer(commandBuffers[currentFrame]);
@@ -114,10 +179,16 @@ namespace MongooseVK
 
         // Submit commands
         VkSemaphore* signalSemaphores = {(&renderFinishedSemaphores[currentFrame])};
-        VK_CHECK_MSG(SubmitDrawCommands(signalSemaphores), "Failed to submit draw command buffer.");
+        {
+            PROFILE_SCOPE("Submit frame");
+            VK_CHECK_MSG(SubmitDrawCommands(signalSemaphores, uploadToken), "Failed to submit draw command buffer.");
+        }
 
         // Present frame
-        result = PresentFrame(swapchain, currentImageIndex, signalSemaphores);
+        {
+            PROFILE_SCOPE("Present frame");
+            result = PresentFrame(swapchain, currentImageIndex, signalSemaphores);
+        }
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || getReadyToResize)
         {
             getReadyToResize = false;
@@ -187,6 +258,9 @@ namespace MongooseVK
         allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
         vmaCreateAllocator(&allocatorInfo, &vmaAllocator);
 
+        uploadManager = CreateScope<VulkanUploadManager>(this);
+        geometryArenas[0] = CreateScope<VulkanGeometryArena>(this, VertexFormat{});
+
         texturePool.Init(1024);
         materialPool.Init(10000);
         renderPassPool.Init(128);
@@ -204,17 +278,34 @@ namespace MongooseVK
         CreateCommandPool();
         CreateDescriptorPool();
         CreateCommandBuffers();
+        CreateSecondaryCommandPools();
         CreateSyncObjects();
+
+        for (auto& frameArena: frameArenas)
+            frameArena = CreateScope<LinearArena>(FRAME_ARENA_SIZE);
+
+        uniformRing = CreateScope<VulkanUniformRing>(this, UNIFORM_RING_FRAME_SIZE, MAX_FRAMES_IN_FLIGHT);
+        gpuProfiler = CreateScope<VulkanGpuProfiler>(this, MAX_FRAMES_IN_FLIGHT);
+        pipelineCache = CreateScope<VulkanPipelineCache>(this, std::filesystem::path("cache") / "pipeline_cache.bin");
     }
 
-    VkResult VulkanDevice::SubmitDrawCommands(const VkSemaphore* signalSemaphores) const
+    VkResult VulkanDevice::SubmitDrawCommands(const VkSemaphore* signalSemaphores, const UploadToken uploadToken) const
     {
+        // Binary semaphores ignore their entry in the timeline value array
+        const VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame], uploadManager->GetTimelineSemaphore()};
+        const VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+        const uint64_t waitValues[] = {0, uploadToken};
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+        timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineSubmitInfo.waitSemaphoreValueCount = 2;
+        timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineSubmitInfo;
 
-        const VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-        const VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.waitSemaphoreCount = 2;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
 
@@ -224,7 +315,7 @@ namespace MongooseVK
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        return vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]);
+        return QueueSubmit(graphicsQueue, submitInfo, inFlightFences[currentFrame]);
     }
 
     VkResult VulkanDevice::PresentFrame(VkSwapchainKHR swapchain, const uint32_t imageIndex,
@@ -238,15 +329,22 @@ namespace MongooseVK
         presentInfo.pSwapchains = &swapchain;
         presentInfo.pImageIndices = &imageIndex;
 
-        return vkQueuePresentKHR(presentQueue, &presentInfo);
+        return QueuePresent(presentInfo);
     }
 
     VkResult VulkanDevice::SetupNextFrame(VkSwapchainKHR swapchain)
     {
-        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        {
+            PROFILE_SCOPE("Wait for frame fence");
+            vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        }
 
-        const VkResult result = vkAcquireNextImageKHR(device, swapchain,UINT64_MAX,
-                                                      imageAvailableSemaphores[currentFrame],VK_NULL_HANDLE, &currentImageIndex);
+        VkResult result;
+        {
+            PROFILE_SCOPE("Acquire swapchain image");
+            result = vkAcquireNextImageKHR(device, swapchain,UINT64_MAX,
+                                           imageAvailableSemaphores[currentFrame],VK_NULL_HANDLE, &currentImageIndex);
+        }
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
             return VK_ERROR_OUT_OF_DATE_KHR;
@@ -257,6 +355,16 @@ namespace MongooseVK
         vkResetFences(device, 1, &inFlightFences[currentFrame]);
         vkResetCommandBuffer(commandBuffers[currentFrame], 0);
 
+        for (SecondaryCommandPool& pool: secondaryCommandPools[currentFrame])
+        {
+            vkResetCommandPool(device, pool.commandPool, 0);
+            pool.usedCount = 0;
+        }
+
+        frameArenas[currentFrame]->Reset();
+        uniformRing->BeginFrame(currentFrame);
+        gpuProfiler->BeginFrame(currentFrame);
+
         return VK_SUCCESS;
     }
 
@@ -297,6 +405,29 @@ namespace MongooseVK
 
     static std::mutex resourceMutex;
 
+    static uint32_t GetTextureMipLevels(const TextureCreateInfo& createInfo)
+    {
+        return createInfo.generateMipMaps
+                   ? static_cast<uint32_t>(std::floor(
+                       std::log2(std::max(createInfo.resolution.width, createInfo.resolution.height)))) + 1
+                   : createInfo.mipLevels;
+    }
+
+    static ImageBuilder GetTextureImageBuilder(VulkanDevice* device, const TextureCreateInfo& createInfo)
+    {
+        return ImageBuilder(device)
+               .SetFormat(createInfo.format)
+               .SetResolution(createInfo.resolution.width, createInfo.resolution.height)
+               .SetTiling(VK_IMAGE_TILING_OPTIMAL)
+               .AddUsage(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+               .AddUsage(VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+               .AddUsage(ImageUtils::GetUsageFromFormat(createInfo.format))
+               .SetInitialLayout(ImageUtils::GetLayoutFromFormat(createInfo.format))
+               .SetMipLevels(GetTextureMipLevels(createInfo))
+               .SetArrayLayers(createInfo.arrayLayers)
+               .SetFlags(createInfo.flags);
+    }
+
     TextureHandle VulkanDevice::CreateTexture(const TextureCreateInfo& _createInfo)
     {
         std::lock_guard lock(resourceMutex);
@@ -304,22 +435,10 @@ namespace MongooseVK
         TextureHandle textureHandle = {texture->index};
         TextureCreateInfo createInfo = _createInfo;
 
-        createInfo.mipLevels = createInfo.generateMipMaps
-                                   ? static_cast<uint32_t>(std::floor(
-                                       std::log2(std::max(createInfo.resolution.width, createInfo.resolution.height)))) + 1
-                                   : createInfo.mipLevels;
-
-        texture->allocatedImage = ImageBuilder(this)
-                                  .SetFormat(createInfo.format)
-                                  .SetResolution(createInfo.resolution.width, createInfo.resolution.height)
-                                  .SetTiling(VK_IMAGE_TILING_OPTIMAL)
-                                  .AddUsage(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
-                                  .AddUsage(VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
-                                  .AddUsage(ImageUtils::GetUsageFromFormat(createInfo.format))
-                                  .SetInitialLayout(ImageUtils::GetLayoutFromFormat(createInfo.format))
-                                  .SetMipLevels(createInfo.mipLevels)
-                                  .SetArrayLayers(createInfo.arrayLayers)
-                                  .SetFlags(createInfo.flags)
+        createInfo.mipLevels = GetTextureMipLevels(createInfo);
+
+        texture->allocatedImage = GetTextureImageBuilder(this, createInfo)
+                                  .SetAliasing(createInfo.aliasAllocation, createInfo.aliasOffset)
                                   .Build();
 
 
@@ -378,10 +497,13 @@ namespace MongooseVK
 
         texture->createInfo = createInfo;
 
+        // Aliased images share their memory with other images, their user initializes them every time it takes
+        // the memory over
         if (createInfo.data && createInfo.size > 0)
         {
             UploadTextureData(textureHandle, createInfo.data, createInfo.size);
-        } else if (ImageUtils::GetLayoutFromFormat(createInfo.format) != VK_IMAGE_LAYOUT_UNDEFINED)
+        } else if (createInfo.aliasAllocation == VK_NULL_HANDLE &&
+                   ImageUtils::GetLayoutFromFormat(createInfo.format) != VK_IMAGE_LAYOUT_UNDEFINED)
         {
             ImmediateSubmit([&](const VkCommandBuffer cmd) {
                 VulkanUtils::TransitionImageLayout(cmd, texture->allocatedImage,
@@ -397,6 +519,11 @@ namespace MongooseVK
         return textureHandle;
     }
 
+    VkMemoryRequirements VulkanDevice::GetTextureMemoryRequirements(const TextureCreateInfo& createInfo)
+    {
+        return GetTextureImageBuilder(this, createInfo).GetMemoryRequirements();
+    }
+
     VulkanTexture* VulkanDevice::GetTexture(const TextureHandle textureHandle)
     {
         return texturePool.Get(textureHandle.handle);
@@ -404,98 +531,12 @@ namespace MongooseVK
 
     void VulkanDevice::UploadTextureData(TextureHandle textureHandle, const void* data, uint64_t size)
     {
-        if (!data || size == 0) return;
-
-        VulkanTexture* texture = GetTexture(textureHandle);
-        const auto stagingBuffer = CreateBuffer(size,
-                                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-                                                VMA_MEMORY_USAGE_CPU_ONLY);
-
-        memcpy(stagingBuffer.GetData(), data, stagingBuffer.GetBufferSize());
-
-        ImmediateSubmit([&](const VkCommandBuffer cmd) {
-            VulkanUtils::TransitionImageLayout(cmd, texture->allocatedImage,
-                                               VK_IMAGE_ASPECT_COLOR_BIT,
-                                               VK_IMAGE_LAYOUT_UNDEFINED,
-                                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                               texture->createInfo.mipLevels);
-
-            VulkanUtils::CopyBufferToImage(cmd, texture->allocatedImage.image,
-                                           texture->createInfo.resolution.width,
-                                           texture->createInfo.resolution.height,
-                                           stagingBuffer.buffer);
-
-            if (texture->createInfo.mipLevels > 1)
-            {
-                VulkanUtils::GenerateMipmaps(cmd,
-                                             GetPhysicalDevice(),
-                                             texture->allocatedImage,
-                                             VulkanUtils::ConvertImageFormat(texture->createInfo.format),
-                                             texture->createInfo.resolution.width,
-                                             texture->createInfo.resolution.height,
-                                             texture->createInfo.mipLevels);
-            } else
-            {
-                VulkanUtils::TransitionImageLayout(cmd, texture->allocatedImage,
-                                                   VK_IMAGE_ASPECT_COLOR_BIT,
-                                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                                                   texture->createInfo.mipLevels);
-            }
-        });
-
-        DestroyBuffer(stagingBuffer);
+        uploadManager->UploadTexture(GetTexture(textureHandle), data, size);
     }
 
     void VulkanDevice::UploadCubemapTextureData(TextureHandle textureHandle, const Bitmap* cubemap)
     {
-        VulkanTexture* texture = GetTexture(textureHandle);
-        const TextureCreateInfo info = texture->createInfo;
-
-        const auto stagingBuffer = CreateBuffer(cubemap->pixelData.size(),
-                                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-                                                VMA_MEMORY_USAGE_CPU_ONLY);
-
-        memcpy(stagingBuffer.GetData(), cubemap->pixelData.data(), cubemap->pixelData.size());
-
-        std::vector<VkBufferImageCopy> bufferCopyRegions;
-        for (uint32_t face = 0; face < 6; face++)
-        {
-            const uint64_t offset = Bitmap::GetImageOffsetForFace(*cubemap, face);
-            VkBufferImageCopy bufferCopyRegion = {};
-            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            bufferCopyRegion.imageSubresource.mipLevel = 0;
-            bufferCopyRegion.imageSubresource.baseArrayLayer = face;
-            bufferCopyRegion.imageSubresource.layerCount = 1;
-            bufferCopyRegion.imageExtent = {info.resolution.width, info.resolution.height, 1};
-            bufferCopyRegion.bufferOffset = offset;
-            bufferCopyRegions.push_back(bufferCopyRegion);
-        }
-
-        ImmediateSubmit([&](const VkCommandBuffer cmd) {
-            VulkanUtils::TransitionImageLayout(cmd,
-                                               texture->allocatedImage,
-                                               VK_IMAGE_ASPECT_COLOR_BIT,
-                                               VK_IMAGE_LAYOUT_UNDEFINED,
-                                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-            vkCmdCopyBufferToImage(cmd,
-                                   stagingBuffer.buffer,
-                                   texture->allocatedImage.image,
-                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                   6,
-                                   bufferCopyRegions.data());
-
-            VulkanUtils::GenerateCubemapMipmaps(cmd,
-                                                GetPhysicalDevice(),
-                                                texture->allocatedImage,
-                                                VulkanUtils::ConvertImageFormat(info.format),
-                                                info.resolution.width,
-                                                info.resolution.height,
-                                                info.mipLevels);
-        });
-
-        DestroyBuffer(stagingBuffer);
+        uploadManager->UploadCubemap(GetTexture(textureHandle), cubemap);
     }
 
     void VulkanDevice::MakeBindlessTexture(TextureHandle textureHandle)
@@ -516,7 +557,7 @@ namespace MongooseVK
     void VulkanDevice::DestroyTexture(TextureHandle textureHandle)
     {
         if (textureHandle == INVALID_TEXTURE_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanTexture* texture = GetTexture(textureHandle);
 
             vkDestroySampler(device, texture->sampler, nullptr);
@@ -561,7 +602,7 @@ namespace MongooseVK
     void VulkanDevice::DestroyMaterial(MaterialHandle materialHandle)
     {
         if (materialHandle == INVALID_MATERIAL_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanMaterial* material = GetMaterial(materialHandle);
 
             DestroyBuffer(material->materialBuffer);
@@ -615,7 +656,7 @@ namespace MongooseVK
             attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
             attachment.initialLayout = config.depthAttachment->loadOp == RenderPassOperation::LoadOp::Load
                                            ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-                                           : VK_IMAGE_LAYOUT_UNDEFINED;
+                                           : config.depthAttachment->initialLayout;
             attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
             attachmentDescriptions.push_back(attachment);
@@ -674,7 +715,7 @@ namespace MongooseVK
     void VulkanDevice::DestroyRenderPass(RenderPassHandle renderPassHandle)
     {
         if (renderPassHandle == INVALID_RENDER_PASS_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanRenderPass* renderPass = renderPassPool.Get(renderPassHandle.handle);
             vkDestroyRenderPass(device, renderPass->Get(), nullptr);
             renderPassPool.Release(renderPass);
@@ -724,7 +765,7 @@ namespace MongooseVK
     void VulkanDevice::DestroyFramebuffer(FramebufferHandle framebufferHandle)
     {
         if (framebufferHandle == INVALID_FRAMEBUFFER_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanFramebuffer* framebuffer = framebufferPool.Get(framebufferHandle.handle);
 
             vkDestroyFramebuffer(GetDevice(), framebuffer->framebuffer, nullptr);
@@ -743,6 +784,8 @@ namespace MongooseVK
         VkCommandBuffer commandBuffer;
         vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
 
+        const UploadToken uploadToken = uploadManager->Flush();
+
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -753,17 +796,54 @@ namespace MongooseVK
 
         vkEndCommandBuffer(commandBuffer);
 
+        const VkSemaphore uploadSemaphore = uploadManager->GetTimelineSemaphore();
+        constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+        timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineSubmitInfo.waitSemaphoreValueCount = 1;
+        timelineSubmitInfo.pWaitSemaphoreValues = &uploadToken;
+
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineSubmitInfo;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &uploadSemaphore;
+        submitInfo.pWaitDstStageMask = &waitStage;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue);
+        QueueSubmit(graphicsQueue, submitInfo);
+        QueueWaitIdle(graphicsQueue);
 
         vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
     }
 
+    VkResult VulkanDevice::QueueSubmit(const VkQueue queue, const VkSubmitInfo& submitInfo, const VkFence fence) const
+    {
+        std::lock_guard lock(queueMutex);
+        return vkQueueSubmit(queue, 1, &submitInfo, fence);
+    }
+
+    VkResult VulkanDevice::QueuePresent(const VkPresentInfoKHR& presentInfo) const
+    {
+        std::lock_guard lock(queueMutex);
+        return vkQueuePresentKHR(presentQueue, &presentInfo);
+    }
+
+    void VulkanDevice::QueueWaitIdle(const VkQueue queue) const
+    {
+        std::lock_guard lock(queueMutex);
+        vkQueueWaitIdle(queue);
+    }
+
+    void VulkanDevice::WaitIdle() const
+    {
+        // Waits on every queue, which counts as using all of them
+        std::lock_guard lock(queueMutex);
+        vkDeviceWaitIdle(device);
+    }
+
     VkSurfaceKHR VulkanDevice::CreateSurface(GLFWwindow* glfwWindow) const
     {
         VkSurfaceKHR surface;
@@ -807,36 +887,58 @@ namespace MongooseVK
 
         constexpr float queue_priority = 1.0f;
 
+        std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
+
         VkDeviceQueueCreateInfo queue_create_info{};
         queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queue_create_info.queueFamilyIndex = indices.graphicsFamily.value();
         queue_create_info.queueCount = 1;
         queue_create_info.pQueuePriorities = &queue_priority;
+        queue_create_infos.push_back(queue_create_info);
+
+        if (indices.HasDedicatedTransfer())
+        {
+            queue_create_info.queueFamilyIndex = indices.transferFamily.value();
+            queue_create_infos.push_back(queue_create_info);
+        }
 
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
-        VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
-        descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-        descriptorIndexingFeatures.pNext = nullptr;
-        descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
-        descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        // Timeline semaphores, descriptor indexing, buffer device address and indirect count are all core 1.2 features,
+        // the frame graph records its barriers with synchronization2 from 1.3
+        VkPhysicalDeviceVulkan13Features vulkan13Features{};
+        vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        vulkan13Features.pNext = nullptr;
 
-        VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures{};
-        bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
-        bufferDeviceAddressFeatures.pNext = &descriptorIndexingFeatures;
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.pNext = &vulkan13Features;
 
         VkPhysicalDeviceFeatures2 deviceFeatures2{};
         deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-        deviceFeatures2.pNext = &bufferDeviceAddressFeatures;
+        deviceFeatures2.pNext = &vulkan12Features;
 
         // Fetch all features
         vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
 
+        if (!vulkan12Features.timelineSemaphore)
+            throw std::runtime_error("Timeline semaphores are not supported by the device!");
+
+        if (!vulkan12Features.drawIndirectCount || !deviceFeatures2.features.multiDrawIndirect ||
+            !deviceFeatures2.features.drawIndirectFirstInstance)
+            throw std::runtime_error("Indirect count draws are not supported by the device!");
+
+        if (!vulkan13Features.synchronization2)
+            throw std::runtime_error("Synchronization2 is not supported by the device!");
+
+        // Everything supported is enabled, including pipelineStatisticsQuery and inheritedQueries. The GPU profiler
+        // keeps its statistics queries active across the secondary command buffers the passes are recorded into.
+        enabledFeatures = deviceFeatures2.features;
 
         VkDeviceCreateInfo createInfo{};
-        createInfo.pQueueCreateInfos = &queue_create_info;
-        createInfo.queueCreateInfoCount = 1;
+        createInfo.pQueueCreateInfos = queue_create_infos.data();
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
         //createInfo.pEnabledFeatures = &deviceFeatures;
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.pNext = &deviceFeatures2;
@@ -852,6 +954,9 @@ namespace MongooseVK
         vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
         vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
 
+        transferQueueFamilyIndex = indices.transferFamily.value();
+        vkGetDeviceQueue(device, transferQueueFamilyIndex, 0, &transferQueue);
+
         return device;
     }
 
@@ -878,6 +983,30 @@ namespace MongooseVK
         return prevDrawCallCount;
     }
 
+    VulkanGeometryArena* VulkanDevice::GetGeometryArena(const VertexFormat& vertexFormat)
+    {
+        std::lock_guard lock(geometryArenaMutex);
+
+        Scope<VulkanGeometryArena>& geometryArena = geometryArenas[vertexFormat.GetIndex()];
+        if (!geometryArena)
+            geometryArena = CreateScope<VulkanGeometryArena>(this, vertexFormat);
+
+        return geometryArena.get();
+    }
+
+    std::vector<VulkanGeometryArena*> VulkanDevice::GetGeometryArenas()
+    {
+        std::lock_guard lock(geometryArenaMutex);
+
+        std::vector<VulkanGeometryArena*> arenas;
+        for (const auto& geometryArena: geometryArenas)
+        {
+            if (geometryArena) arenas.push_back(geometryArena.get());
+        }
+
+        return arenas;
+    }
+
 
     VkInstance VulkanDevice::CreateVkInstance(const std::vector<const char*>& deviceExtensions,
                                               const std::vector<const char*>& validationLayers)
@@ -997,8 +1126,11 @@ namespace MongooseVK
         shaderDescriptorPool = VulkanDescriptorPool::Builder(this)
                                .SetMaxSets(100)
                                .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100)
+                               .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 100)
                                .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100)
                                .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100)
+                               .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 100)
+                               .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 100)
                                .SetPoolFlags(
                                    VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT | VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)
                                .Build();
@@ -1071,6 +1203,62 @@ namespace MongooseVK
         VK_CHECK_MSG(vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()), "Failed to allocate command buffers.");
     }
 
+    void VulkanDevice::CreateSecondaryCommandPools()
+    {
+        const JobSystem* jobSystem = JobSystem::Get();
+        const size_t threadCount = (jobSystem ? jobSystem->GetWorkerCount() : 0) + 1;
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = GetQueueFamilyIndex();
+
+        for (auto& framePools: secondaryCommandPools)
+        {
+            framePools.resize(threadCount);
+
+            for (SecondaryCommandPool& pool: framePools)
+                VK_CHECK_MSG(vkCreateCommandPool(device, &poolInfo, nullptr, &pool.commandPool), "Failed to create secondary command pool.");
+        }
+    }
+
+    VkCommandBuffer VulkanDevice::BeginSecondaryCommandBuffer(const VkCommandBufferInheritanceInfo& inheritanceInfo)
+    {
+        const JobSystem* jobSystem = JobSystem::Get();
+        const size_t threadIndex = jobSystem ? jobSystem->GetThreadIndex() : 0;
+
+        std::vector<SecondaryCommandPool>& framePools = secondaryCommandPools[currentFrame];
+        if (threadIndex >= framePools.size())
+            throw std::runtime_error("No secondary command pool for the recording thread!");
+
+        SecondaryCommandPool& pool = framePools[threadIndex];
+        if (pool.usedCount == pool.commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            VK_CHECK_MSG(vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer), "Failed to allocate secondary command buffer.");
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+
+        const VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (inheritanceInfo.renderPass != VK_NULL_HANDLE)
+            beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        VK_CHECK_MSG(vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin recording secondary command buffer.");
+
+        return commandBuffer;
+    }
+
     uint32_t VulkanDevice::GetQueueFamilyIndex() const
     {
         return VulkanUtils::FindQueueFamilies(physicalDevice, surface).graphicsFamily.value();
@@ -1117,10 +1305,37 @@ namespace MongooseVK
         vmaUnmapMemory(vmaAllocator, buffer.allocation);
     }
 
+    void VulkanDevice::UploadBufferData(const AllocatedBuffer& buffer, const void* data, const uint64_t size, const uint64_t offset)
+    {
+        uploadManager->UploadBuffer(buffer, data, size, offset);
+    }
+
     void VulkanDevice::DestroyBuffer(const AllocatedBuffer& buffer)
     {
-        frameDeletionQueue.Push([=] {
-            vmaDestroyBuffer(vmaAllocator, buffer.buffer, buffer.allocation);
+        GetFrameDeletionQueue().Push([this, vkBuffer = buffer.buffer, allocation = buffer.allocation] {
+            vmaDestroyBuffer(vmaAllocator, vkBuffer, allocation);
+        });
+    }
+
+    VmaAllocation VulkanDevice::AllocateMemory(const VkMemoryRequirements& memoryRequirements)
+    {
+        LOG_TRACE("Allocate memory: " + std::to_string(memoryRequirements.size / 1024) + " kB");
+
+        VmaAllocationCreateInfo vmaallocInfo = {};
+        vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VK_CHECK_MSG(vmaAllocateMemory(vmaAllocator, &memoryRequirements, &vmaallocInfo, &allocation, nullptr),
+                     "Failed to allocate memory.");
+
+        return allocation;
+    }
+
+    void VulkanDevice::FreeMemory(VmaAllocation allocation)
+    {
+        if (allocation == VK_NULL_HANDLE) return;
+        GetFrameDeletionQueue().Push([=] {
+            vmaFreeMemory(vmaAllocator, allocation);
         });
     }
 
@@ -1154,11 +1369,12 @@ namespace MongooseVK
     void VulkanDevice::DestroyPipeline(PipelineHandle pipelineHandle)
     {
         if (pipelineHandle == INVALID_PIPELINE_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanPipeline* pipeline = pipelinePool.Get(pipelineHandle.handle);
 
             vkDestroyShaderModule(GetDevice(), pipeline->vertexShaderModule, nullptr);
             vkDestroyShaderModule(GetDevice(), pipeline->fragmentShaderModule, nullptr);
+            vkDestroyShaderModule(GetDevice(), pipeline->computeShaderModule, nullptr);
             vkDestroyPipeline(GetDevice(), pipeline->pipeline, nullptr);
             vkDestroyPipelineLayout(GetDevice(), pipeline->pipelineLayout, nullptr);
 
@@ -1190,6 +1406,14 @@ namespace MongooseVK
         descriptorSetLayoutInfo.pNext = &layoutBindingFlags;
         descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
 
+        // Dynamic buffers can't be updated after bind, their offsets are given at bind time instead
+        for (uint32_t i = 0; i < descriptorSetLayout->bindingCount; i++)
+        {
+            const VkDescriptorType type = descriptorSetLayout->bindings[i].descriptorType;
+            if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+                descriptorSetLayoutInfo.flags = 0;
+        }
+
         VK_CHECK_MSG(vkCreateDescriptorSetLayout(GetDevice(), &descriptorSetLayoutInfo, nullptr, &descriptorSetLayout->descriptorSetLayout),
                      "Failed to create descriptor set layout.");
 
@@ -1204,7 +1428,7 @@ namespace MongooseVK
     void VulkanDevice::DestroyDescriptorSetLayout(DescriptorSetLayoutHandle descriptorSetLayoutHandle)
     {
         if (descriptorSetLayoutHandle == INVALID_DESCRIPTOR_SET_LAYOUT_HANDLE) return;
-        frameDeletionQueue.Push([=] {
+        GetFrameDeletionQueue().Push([=] {
             VulkanDescriptorSetLayout* descriptorSetLayout = descriptorSetLayoutPool.Get(descriptorSetLayoutHandle.handle);
             if (descriptorSetLayout && descriptorSetLayout->descriptorSetLayout)
             {
@@ -0,0 +1,198 @@
+#include "renderer/vulkan/vulkan_geometry_arena.h"
+
+#include <algorithm>
+
+#include "renderer/vulkan/vulkan_device.h"
+#include "util/log.h"
+
+namespace MongooseVK
+{
+    VulkanGeometryArena::VulkanGeometryArena(VulkanDevice* vulkanDevice, const VertexFormat& vertexFormat): device(vulkanDevice),
+        vertexFormat(vertexFormat)
+    {
+        for (uint32_t stream = 0; stream < GetVertexStreamCount(); stream++)
+            vertexStreams[stream] = CreateVertexBuffer(stream, GEOMETRY_ARENA_INITIAL_VERTEX_CAPACITY);
+
+        indexBuffer = CreateIndexBuffer(GEOMETRY_ARENA_INITIAL_INDEX_CAPACITY);
+
+        vertexAllocator.Init(GEOMETRY_ARENA_INITIAL_VERTEX_CAPACITY);
+        indexAllocator.Init(GEOMETRY_ARENA_INITIAL_INDEX_CAPACITY);
+    }
+
+    VulkanGeometryArena::~VulkanGeometryArena()
+    {
+        for (uint32_t stream = 0; stream < GetVertexStreamCount(); stream++)
+            vmaDestroyBuffer(device->GetVmaAllocator(), vertexStreams[stream].buffer, vertexStreams[stream].allocation);
+
+        vmaDestroyBuffer(device->GetVmaAllocator(), indexBuffer.buffer, indexBuffer.allocation);
+    }
+
+    GeometryAllocation VulkanGeometryArena::Allocate(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices,
+                                                     const BoundingBox& bounds)
+    {
+        // Every draw is indexed, geometry without indices is never drawn and gets no ranges. The empty allocation
+        // is not valid, so Free skips it as well.
+        if (vertices.empty() || indices.empty())
+        {
+            LOG_WARN("Geometry arena: skipped geometry without vertices or indices");
+            return {};
+        }
+
+        ASSERT(vertices.size() >= 3, "Vertex count must be at least 3");
+
+        std::lock_guard lock(arenaMutex);
+
+        uint64_t vertexOffset = vertexAllocator.Allocate(vertices.size());
+        if (vertexOffset == INVALID_ALLOCATION_OFFSET)
+        {
+            GrowVertexBuffer(vertexAllocator.GetCapacity() + vertices.size());
+            vertexOffset = vertexAllocator.Allocate(vertices.size());
+
+            if (vertexOffset == INVALID_ALLOCATION_OFFSET)
+                throw std::runtime_error("Failed to allocate vertices in the geometry arena!");
+        }
+
+        uint64_t firstIndex = indexAllocator.Allocate(indices.size());
+        if (firstIndex == INVALID_ALLOCATION_OFFSET)
+        {
+            GrowIndexBuffer(indexAllocator.GetCapacity() + indices.size());
+            firstIndex = indexAllocator.Allocate(indices.size());
+
+            if (firstIndex == INVALID_ALLOCATION_OFFSET)
+            {
+                vertexAllocator.Free(vertexOffset, vertices.size());
+                throw std::runtime_error("Failed to allocate indices in the geometry arena!");
+            }
+        }
+
+        if (!vertexFormat.packed)
+        {
+            device->UploadBufferData(vertexStreams[0], vertices.data(), vertices.size_bytes(), vertexOffset * sizeof(Vertex));
+        } else
+        {
+            // Uploads copy into staging right away so the encode buffer can be reused for every stream
+            for (uint32_t stream = 0; stream < GetVertexStreamCount(); stream++)
+            {
+                const uint32_t stride = vertexFormat.GetStreamStride(stream);
+                VertexEncoding::EncodeStream(vertexFormat, stream, vertices, bounds, encodedVertices);
+                device->UploadBufferData(vertexStreams[stream], encodedVertices.data(), encodedVertices.size(), vertexOffset * stride);
+            }
+        }
+        device->UploadBufferData(indexBuffer, indices.data(), indices.size_bytes(), firstIndex * sizeof(uint32_t));
+
+        allocationCount++;
+
+        return {
+            .vertexOffset = static_cast<int32_t>(vertexOffset),
+            .vertexCount = static_cast<uint32_t>(vertices.size()),
+            .firstIndex = static_cast<uint32_t>(firstIndex),
+            .indexCount = static_cast<uint32_t>(indices.size()),
+        };
+    }
+
+    void VulkanGeometryArena::Free(const GeometryAllocation& allocation)
+    {
+        if (!allocation.IsValid()) return;
+
+        device->GetFrameDeletionQueue().Push([=, this] {
+            std::lock_guard lock(arenaMutex);
+
+            vertexAllocator.Free(allocation.vertexOffset, allocation.vertexCount);
+            indexAllocator.Free(allocation.firstIndex, allocation.indexCount);
+            allocationCount--;
+        });
+    }
+
+    void VulkanGeometryArena::Bind(const VkCommandBuffer commandBuffer) const
+    {
+        std::array<VkBuffer, MAX_VERTEX_STREAMS> buffers{};
+        const std::array<VkDeviceSize, MAX_VERTEX_STREAMS> offsets{};
+        for (uint32_t stream = 0; stream < GetVertexStreamCount(); stream++)
+            buffers[stream] = vertexStreams[stream].buffer;
+
+        vkCmdBindVertexBuffers(commandBuffer, 0, GetVertexStreamCount(), buffers.data(), offsets.data());
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    GeometryArenaStats VulkanGeometryArena::GetStats()
+    {
+        std::lock_guard lock(arenaMutex);
+
+        return {
+            .vertexFormat = vertexFormat,
+            .vertexSize = vertexFormat.GetVertexSize(),
+            .vertexCapacity = vertexAllocator.GetCapacity(),
+            .vertexUsed = vertexAllocator.GetUsed(),
+            .vertexFragmentation = vertexAllocator.GetFragmentation(),
+            .indexCapacity = indexAllocator.GetCapacity(),
+            .indexUsed = indexAllocator.GetUsed(),
+            .indexFragmentation = indexAllocator.GetFragmentation(),
+            .allocations = allocationCount,
+        };
+    }
+
+    void VulkanGeometryArena::GrowVertexBuffer(const uint64_t requiredCapacity)
+    {
+        const uint64_t newCapacity = std::max(vertexAllocator.GetCapacity() * 2, requiredCapacity);
+        LOG_TRACE("Geometry arena: grow vertex buffer to " + std::to_string(newCapacity) + " vertices");
+
+        for (uint32_t stream = 0; stream < GetVertexStreamCount(); stream++)
+        {
+            const AllocatedBuffer newBuffer = CreateVertexBuffer(stream, newCapacity);
+            CopyBuffer(vertexStreams[stream], newBuffer, vertexAllocator.GetCapacity() * vertexFormat.GetStreamStride(stream));
+
+            device->DestroyBuffer(vertexStreams[stream]);
+            vertexStreams[stream] = newBuffer;
+        }
+
+        vertexAllocator.Grow(newCapacity);
+    }
+
+    void VulkanGeometryArena::GrowIndexBuffer(const uint64_t requiredCapacity)
+    {
+        const uint64_t newCapacity = std::max(indexAllocator.GetCapacity() * 2, requiredCapacity);
+        LOG_TRACE("Geometry arena: grow index buffer to " + std::to_string(newCapacity) + " indices");
+
+        const AllocatedBuffer newBuffer = CreateIndexBuffer(newCapacity);
+        CopyBuffer(indexBuffer, newBuffer, indexAllocator.GetCapacity() * sizeof(uint32_t));
+
+        device->DestroyBuffer(indexBuffer);
+        indexBuffer = newBuffer;
+        indexAllocator.Grow(newCapacity);
+    }
+
+    AllocatedBuffer VulkanGeometryArena::CreateVertexBuffer(const uint32_t stream, const uint64_t capacity) const
+    {
+        return device->CreateBuffer(capacity * vertexFormat.GetStreamStride(stream),
+                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                    VMA_MEMORY_USAGE_GPU_ONLY);
+    }
+
+    AllocatedBuffer VulkanGeometryArena::CreateIndexBuffer(const uint64_t capacity) const
+    {
+        return device->CreateBuffer(capacity * sizeof(uint32_t),
+                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                    VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                    VMA_MEMORY_USAGE_GPU_ONLY);
+    }
+
+    void VulkanGeometryArena::CopyBuffer(const AllocatedBuffer& src, const AllocatedBuffer& dst, const uint64_t size) const
+    {
+        // Waits for every pending upload into the old buffer before copying it
+        device->ImmediateSubmit([&](const VkCommandBuffer commandBuffer) {
+            const VkBufferCopy region{
+                .srcOffset = 0,
+                .dstOffset = 0,
+                .size = size,
+            };
+            vkCmdCopyBuffer(commandBuffer, src.buffer, dst.buffer, 1, &region);
+        });
+    }
+}
@@ -0,0 +1,202 @@
+#include "renderer/vulkan/vulkan_gpu_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static constexpr VkQueryPipelineStatisticFlags PROFILER_PIPELINE_STATISTICS =
+                VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+        static_assert(sizeof(GpuPipelineStatistics) == 5 * sizeof(uint64_t), "One counter per statistics flag");
+    }
+
+    VulkanGpuProfiler::VulkanGpuProfiler(VulkanDevice* vulkanDevice, const uint32_t frameCount): device(vulkanDevice)
+    {
+        timestampPeriod = device->GetDeviceProperties().limits.timestampPeriod;
+        frames.resize(frameCount);
+
+        // Frames are recorded for the graphics queue, only the low timestampValidBits of its timestamps count
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device->GetPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device->GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        const uint32_t validBits = queueFamilies[device->GetQueueFamilyIndex()].timestampValidBits;
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo timestampPoolInfo{};
+        timestampPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        timestampPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        timestampPoolInfo.queryCount = 2 * GPU_PROFILER_MAX_SCOPES * frameCount;
+
+        VK_CHECK_MSG(vkCreateQueryPool(device->GetDevice(), &timestampPoolInfo, nullptr, &timestampPool),
+                     "Failed to create GPU profiler timestamp query pool.");
+
+        // Every pass is recorded into secondary command buffers, a statistics query active across
+        // vkCmdExecuteCommands and the pipelineStatistics of their inheritance info both need inheritedQueries
+        const VkPhysicalDeviceFeatures& features = device->GetEnabledFeatures();
+        if (!features.pipelineStatisticsQuery || !features.inheritedQueries) return;
+
+        VkQueryPoolCreateInfo statisticsPoolInfo{};
+        statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsPoolInfo.queryCount = GPU_PROFILER_MAX_SCOPES * frameCount;
+        statisticsPoolInfo.pipelineStatistics = Utils::PROFILER_PIPELINE_STATISTICS;
+
+        VK_CHECK_MSG(vkCreateQueryPool(device->GetDevice(), &statisticsPoolInfo, nullptr, &pipelineStatisticsPool),
+                     "Failed to create GPU profiler pipeline statistics query pool.");
+    }
+
+    VulkanGpuProfiler::~VulkanGpuProfiler()
+    {
+        vkDestroyQueryPool(device->GetDevice(), timestampPool, nullptr);
+
+        if (pipelineStatisticsPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(device->GetDevice(), pipelineStatisticsPool, nullptr);
+    }
+
+    void VulkanGpuProfiler::BeginFrame(const uint32_t frameIndex)
+    {
+        currentFrame = frameIndex;
+        FrameQueries& frame = frames[currentFrame];
+
+        const uint32_t scopeCount = frame.scopeCount;
+        if (scopeCount > 0)
+        {
+            std::array<uint64_t, 2 * GPU_PROFILER_MAX_SCOPES> timestamps{};
+            const VkResult result = vkGetQueryPoolResults(device->GetDevice(), timestampPool,
+                                                          2 * GPU_PROFILER_MAX_SCOPES * currentFrame, 2 * scopeCount,
+                                                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+                                                          VK_QUERY_RESULT_64_BIT);
+
+            std::array<GpuPipelineStatistics, GPU_PROFILER_MAX_SCOPES> statistics{};
+            const bool statisticsRead = frame.pipelineStatistics &&
+                                        vkGetQueryPoolResults(device->GetDevice(), pipelineStatisticsPool,
+                                                              GPU_PROFILER_MAX_SCOPES * currentFrame, scopeCount,
+                                                              sizeof(statistics), statistics.data(),
+                                                              sizeof(GpuPipelineStatistics),
+                                                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+            if (result == VK_SUCCESS)
+            {
+                for (uint32_t i = 0; i < scopeCount; i++)
+                {
+                    const uint64_t ticks = GetTicks(timestamps[2 * i], timestamps[2 * i + 1]);
+                    AddSample(frame.scopes[i], static_cast<float>(ticks) * timestampPeriod / 1000000.0f);
+
+                    if (statisticsRead)
+                        scopeStats[frame.scopes[i]].pipelineStatistics = statistics[i];
+                }
+
+                frameTime = static_cast<float>(GetTicks(timestamps[0], timestamps[2 * scopeCount - 1])) * timestampPeriod / 1000000.0f;
+            }
+        }
+
+        frame.scopeCount = 0;
+
+        // Changes between frames only, the scopes and the inherited statistics of a frame have to agree
+        pipelineStatisticsEnabled = pipelineStatisticsRequested && IsPipelineStatisticsSupported();
+        frame.pipelineStatistics = pipelineStatisticsEnabled;
+    }
+
+    void VulkanGpuProfiler::ResetQueries(const VkCommandBuffer commandBuffer) const
+    {
+        vkCmdResetQueryPool(commandBuffer, timestampPool, 2 * GPU_PROFILER_MAX_SCOPES * currentFrame, 2 * GPU_PROFILER_MAX_SCOPES);
+
+        if (pipelineStatisticsEnabled)
+            vkCmdResetQueryPool(commandBuffer, pipelineStatisticsPool, GPU_PROFILER_MAX_SCOPES * currentFrame, GPU_PROFILER_MAX_SCOPES);
+    }
+
+    uint32_t VulkanGpuProfiler::BeginScope(const VkCommandBuffer commandBuffer, const char* name)
+    {
+        FrameQueries& frame = frames[currentFrame];
+        if (frame.scopeCount == GPU_PROFILER_MAX_SCOPES) return INVALID_GPU_PROFILER_SCOPE;
+
+        const uint32_t scope = frame.scopeCount++;
+        frame.scopes[scope] = GetStatsIndex(name);
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool,
+                            2 * (GPU_PROFILER_MAX_SCOPES * currentFrame + scope));
+
+        if (frame.pipelineStatistics)
+            vkCmdBeginQuery(commandBuffer, pipelineStatisticsPool, GPU_PROFILER_MAX_SCOPES * currentFrame + scope, 0);
+
+        return scope;
+    }
+
+    void VulkanGpuProfiler::EndScope(const VkCommandBuffer commandBuffer, const uint32_t scope)
+    {
+        if (scope == INVALID_GPU_PROFILER_SCOPE) return;
+
+        if (frames[currentFrame].pipelineStatistics)
+            vkCmdEndQuery(commandBuffer, pipelineStatisticsPool, GPU_PROFILER_MAX_SCOPES * currentFrame + scope);
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool,
+                            2 * (GPU_PROFILER_MAX_SCOPES * currentFrame + scope) + 1);
+    }
+
+    VkQueryPipelineStatisticFlags VulkanGpuProfiler::GetInheritedPipelineStatistics() const
+    {
+        return frames[currentFrame].pipelineStatistics ? Utils::PROFILER_PIPELINE_STATISTICS : 0;
+    }
+
+    const GpuScopeStats* VulkanGpuProfiler::GetScopeStats(const std::string& name) const
+    {
+        const auto stats = std::ranges::find(scopeStats, name, &GpuScopeStats::name);
+        return stats != scopeStats.end() ? &*stats : nullptr;
+    }
+
+    void VulkanGpuProfiler::ResetStats()
+    {
+        for (GpuScopeStats& stats: scopeStats)
+            stats = {.name = stats.name};
+    }
+
+    uint32_t VulkanGpuProfiler::GetStatsIndex(const char* name)
+    {
+        const auto statsIndex = statsIndices.find(name);
+        if (statsIndex != statsIndices.end()) return statsIndex->second;
+
+        const uint32_t index = static_cast<uint32_t>(scopeStats.size());
+        scopeStats.push_back({.name = name});
+        histories.emplace_back();
+        statsIndices[name] = index;
+
+        return index;
+    }
+
+    uint64_t VulkanGpuProfiler::GetTicks(const uint64_t begin, const uint64_t end) const
+    {
+        // Masked before subtracting, the difference stays right when the counter wraps in between
+        return ((end & timestampMask) - (begin & timestampMask)) & timestampMask;
+    }
+
+    void VulkanGpuProfiler::AddSample(const uint32_t statsIndex, const float time)
+    {
+        GpuScopeStats& stats = scopeStats[statsIndex];
+        std::array<float, GPU_PROFILER_HISTORY_SIZE>& history = histories[statsIndex];
+
+        history[stats.sampleCount % GPU_PROFILER_HISTORY_SIZE] = time;
+        stats.sampleCount++;
+        stats.lastTime = time;
+
+        const uint32_t count = std::min(stats.sampleCount, GPU_PROFILER_HISTORY_SIZE);
+        std::array<float, GPU_PROFILER_HISTORY_SIZE> sorted = history;
+        std::sort(sorted.begin(), sorted.begin() + count);
+
+        stats.minTime = sorted[0];
+        stats.avgTime = std::accumulate(sorted.begin(), sorted.begin() + count, 0.0f) / static_cast<float>(count);
+        stats.p99Time = sorted[static_cast<uint32_t>(std::ceil(0.99f * static_cast<float>(count))) - 1];
+    }
+}
@@ -0,0 +1,252 @@
+#include "renderer/vulkan/vulkan_gpu_scene.h"
+
+#include <cstring>
+
+#include "renderer/scene.h"
+#include "renderer/vulkan/vulkan_device.h"
+#include "util/log.h"
+
+namespace MongooseVK
+{
+    VulkanGpuScene::VulkanGpuScene(VulkanDevice* vulkanDevice): device(vulkanDevice) {}
+
+    VulkanGpuScene::~VulkanGpuScene()
+    {
+        DestroyResources();
+    }
+
+    void VulkanGpuScene::Build(SceneGraph& scene)
+    {
+        DestroyResources();
+
+        instanceNodes.clear();
+        instanceData.clear();
+
+        geometryArena = device->GetGeometryArena(scene.vertexFormat);
+
+        std::vector<GpuDrawData> drawData{};
+
+        for (size_t nodeIndex = 0; nodeIndex < scene.meshes.size(); nodeIndex++)
+        {
+            if (!scene.meshes[nodeIndex]) continue;
+
+            const uint32_t instanceIndex = static_cast<uint32_t>(instanceNodes.size());
+            instanceNodes.push_back(static_cast<int64_t>(nodeIndex));
+            instanceData.push_back({});
+
+            for (const VulkanMeshlet& meshlet: scene.meshes[nodeIndex]->GetMeshlets())
+            {
+                GpuDrawData meshletDraw{};
+                meshletDraw.boundsCenter = glm::vec4(meshlet.bounds.GetCenter(), 0.0f);
+                meshletDraw.boundsExtent = glm::vec4(meshlet.bounds.GetExtent(), 0.0f);
+                meshletDraw.firstIndex = meshlet.geometry.firstIndex;
+                meshletDraw.vertexOffset = meshlet.geometry.vertexOffset;
+                meshletDraw.instanceIndex = instanceIndex;
+
+                if (meshlet.material != INVALID_MATERIAL_HANDLE)
+                {
+                    const VulkanMaterial* material = device->GetMaterial(meshlet.material);
+                    meshletDraw.materialIndex = material->index;
+                    meshletDraw.flags = material->params.alphaTested ? DRAW_FLAG_ALPHA_TESTED : 0;
+                }
+
+                if (meshlet.clusters.empty())
+                {
+                    AddDraw(drawData, meshletDraw, MeshClustering::MakeBoundingCluster(meshlet.bounds, meshlet.GetIndexCount()));
+                    continue;
+                }
+
+                for (const MeshCluster& cluster: meshlet.clusters)
+                    AddDraw(drawData, meshletDraw, cluster);
+            }
+        }
+
+        if (drawData.empty()) return;
+
+        drawCapacity = static_cast<uint32_t>(drawData.size());
+        CreateResources(drawData);
+
+        LOG_TRACE("GPU scene: " + std::to_string(instanceData.size()) + " instances, " + std::to_string(drawData.size()) + " clusters");
+    }
+
+    void VulkanGpuScene::Update(const SceneGraph& scene, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPosition)
+    {
+        if (frameResources.empty()) return;
+
+        const FrameResources& frame = frameResources[device->currentFrame];
+
+        // GPU_TO_CPU memory doesn't have to be coherent, the GPU writes only become visible after invalidating
+        vmaInvalidateAllocation(device->GetVmaAllocator(), frame.cullingStatsBuffer.allocation, 0, VK_WHOLE_SIZE);
+        memcpy(&cullingStats, frame.cullingStatsBuffer.GetData(), sizeof(GpuCullingStats));
+
+        for (size_t i = 0; i < instanceNodes.size(); i++)
+            instanceData[i].modelMatrix = scene.GetWorldMatrix(instanceNodes[i]);
+
+        memcpy(frame.instanceDataBuffer.GetData(), instanceData.data(), instanceData.size() * sizeof(GpuInstanceData));
+
+        std::array<CullingView, CULLING_VIEW_COUNT> views{};
+        views[0] = ExtractFrustum(cameraViewProjection);
+        views[0].origin = glm::vec4(cameraPosition, 1.0f);
+
+        // Shadow passes render back faces, so their views skip normal cone culling
+        for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; i++)
+            views[i + 1] = ExtractFrustum(scene.directionalLight.cascades[i].viewProjMatrix);
+
+        viewsAddress = device->GetUniformRing().Push(views).address;
+    }
+
+    CullingPushConstantData VulkanGpuScene::GetCullingPushConstantData(const CullingPhase phase) const
+    {
+        const FrameResources& frame = frameResources[device->currentFrame];
+
+        return {
+            .viewsAddress = viewsAddress,
+            .drawDataAddress = drawDataBuffer.address,
+            .instanceDataAddress = frame.instanceDataBuffer.address,
+            .visibilityAddress = visibilityBuffer.address,
+            .drawCommandsAddress = frame.drawCommandBuffer.address,
+            .drawCountsAddress = frame.drawCountBuffer.address,
+            .statsAddress = frame.cullingStatsBuffer.address,
+            .drawCount = GetDrawCount(),
+            .drawCapacity = drawCapacity,
+            .phase = phase,
+            .flags = occlusionCulling ? CULLING_FLAG_OCCLUSION : 0u,
+        };
+    }
+
+    VkDeviceAddress VulkanGpuScene::GetInstanceDataAddress() const
+    {
+        return frameResources[device->currentFrame].instanceDataBuffer.address;
+    }
+
+    const AllocatedBuffer& VulkanGpuScene::GetDrawCountBuffer() const
+    {
+        return frameResources[device->currentFrame].drawCountBuffer;
+    }
+
+    const AllocatedBuffer& VulkanGpuScene::GetCullingStatsBuffer() const
+    {
+        return frameResources[device->currentFrame].cullingStatsBuffer;
+    }
+
+    void VulkanGpuScene::FillDrawIndirectParams(DrawIndirectParams& params, const DrawList drawList) const
+    {
+        const FrameResources& frame = frameResources[device->currentFrame];
+
+        // Buffers are bound at record time as the arena replaces them when it grows
+        params.geometryArena = geometryArena;
+        params.indirectBuffer = frame.drawCommandBuffer.buffer;
+        params.indirectOffset = static_cast<VkDeviceSize>(drawList) * drawCapacity * sizeof(VkDrawIndexedIndirectCommand);
+        params.countBuffer = frame.drawCountBuffer.buffer;
+        params.countOffset = static_cast<VkDeviceSize>(drawList) * sizeof(uint32_t);
+        params.maxDrawCount = drawCapacity;
+    }
+
+    void VulkanGpuScene::CreateResources(const std::vector<GpuDrawData>& drawData)
+    {
+        // Cluster data never changes after the build, it is uploaded once and shared by all frames in flight
+        drawDataBuffer = device->CreateBuffer(sizeof(GpuDrawData) * drawCapacity,
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                              VMA_MEMORY_USAGE_GPU_ONLY);
+        device->UploadBufferData(drawDataBuffer, drawData.data(), drawData.size() * sizeof(GpuDrawData));
+
+        // Starts out empty, the first frame draws everything in the late phase
+        const std::vector<uint32_t> visibility(drawCapacity, 0);
+        visibilityBuffer = device->CreateBuffer(sizeof(uint32_t) * drawCapacity,
+                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                VMA_MEMORY_USAGE_GPU_ONLY);
+        device->UploadBufferData(visibilityBuffer, visibility.data(), visibility.size() * sizeof(uint32_t));
+
+        frameResources.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for (FrameResources& frame: frameResources)
+        {
+            frame.instanceDataBuffer = device->CreateBuffer(sizeof(GpuInstanceData) * instanceData.size(),
+                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+            frame.drawCommandBuffer = device->CreateBuffer(
+                sizeof(VkDrawIndexedIndirectCommand) * drawCapacity * DRAW_LIST_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            frame.drawCountBuffer = device->CreateBuffer(sizeof(uint32_t) * DRAW_LIST_COUNT,
+                                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                         VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                         VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                                         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                         VMA_MEMORY_USAGE_GPU_ONLY);
+
+            frame.cullingStatsBuffer = device->CreateBuffer(sizeof(GpuCullingStats),
+                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                                            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                            VMA_MEMORY_USAGE_GPU_TO_CPU);
+            memset(frame.cullingStatsBuffer.GetData(), 0, sizeof(GpuCullingStats));
+
+            memcpy(frame.instanceDataBuffer.GetData(), instanceData.data(), instanceData.size() * sizeof(GpuInstanceData));
+        }
+    }
+
+    void VulkanGpuScene::DestroyResources()
+    {
+        for (const FrameResources& frame: frameResources)
+        {
+            device->DestroyBuffer(frame.instanceDataBuffer);
+            device->DestroyBuffer(frame.drawCommandBuffer);
+            device->DestroyBuffer(frame.drawCountBuffer);
+            device->DestroyBuffer(frame.cullingStatsBuffer);
+        }
+
+        if (!frameResources.empty())
+        {
+            device->DestroyBuffer(drawDataBuffer);
+            device->DestroyBuffer(visibilityBuffer);
+        }
+
+        frameResources.clear();
+        drawDataBuffer = {};
+        visibilityBuffer = {};
+        cullingStats = {};
+        drawCapacity = 0;
+    }
+
+    void VulkanGpuScene::AddDraw(std::vector<GpuDrawData>& drawData, const GpuDrawData& meshletDraw, const MeshCluster& cluster)
+    {
+        GpuDrawData draw = meshletDraw;
+        draw.boundingSphere = glm::vec4(cluster.center, cluster.radius);
+        draw.cone = glm::vec4(cluster.coneAxis, cluster.coneCutoff);
+        draw.firstIndex = meshletDraw.firstIndex + cluster.firstIndex;
+        draw.indexCount = cluster.indexCount;
+
+        drawData.push_back(draw);
+    }
+
+    CullingView VulkanGpuScene::ExtractFrustum(const glm::mat4& viewProjection)
+    {
+        const glm::mat4 m = glm::transpose(viewProjection);
+
+        // Gribb-Hartmann, planes point inwards. The near plane uses the -w <= z clip bound
+        // which is conservative for both depth conventions.
+        CullingView view{};
+        view.viewProjection = viewProjection;
+        view.frustumPlanes[0] = m[3] + m[0]; // Left
+        view.frustumPlanes[1] = m[3] - m[0]; // Right
+        view.frustumPlanes[2] = m[3] + m[1]; // Bottom
+        view.frustumPlanes[3] = m[3] - m[1]; // Top
+        view.frustumPlanes[4] = m[3] + m[2]; // Near
+        view.frustumPlanes[5] = m[3] - m[2]; // Far
+
+        for (glm::vec4& plane: view.frustumPlanes)
+            plane /= glm::length(glm::vec3(plane));
+
+        return view;
+    }
+}
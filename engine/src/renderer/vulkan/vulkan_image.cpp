@@ -27,7 +27,7 @@ namespace MongooseVK
         }
     }
 
-    AllocatedImage ImageBuilder::Build()
+    VkImageCreateInfo ImageBuilder::GetImageCreateInfo() const
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -47,11 +47,42 @@ namespace MongooseVK
         if (flags)
             imageInfo.flags = flags;
 
+        return imageInfo;
+    }
+
+    VkMemoryRequirements ImageBuilder::GetMemoryRequirements() const
+    {
+        const VkImageCreateInfo imageInfo = GetImageCreateInfo();
+
+        const VkDeviceImageMemoryRequirements requirementsInfo{
+            .sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+            .pCreateInfo = &imageInfo,
+        };
+
+        VkMemoryRequirements2 memoryRequirements{.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+        vkGetDeviceImageMemoryRequirements(device->GetDevice(), &requirementsInfo, &memoryRequirements);
+
+        return memoryRequirements.memoryRequirements;
+    }
+
+    AllocatedImage ImageBuilder::Build()
+    {
+        const VkImageCreateInfo imageInfo = GetImageCreateInfo();
 
         AllocatedImage allocatedImage;
         allocatedImage.width = width;
         allocatedImage.height = height;
 
+        // The allocation stays with its owner, destroying the image leaves the memory alone
+        if (aliasAllocation != VK_NULL_HANDLE)
+        {
+            VK_CHECK_MSG(vmaCreateAliasingImage2(device->GetVmaAllocator(), aliasAllocation, aliasOffset, &imageInfo,
+                             &allocatedImage.image),
+                         "Failed to create aliasing image.");
+
+            return allocatedImage;
+        }
+
         VmaAllocationCreateInfo vmaallocInfo = {};
         vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
@@ -3,86 +3,67 @@
 
 namespace MongooseVK
 {
-    VulkanMesh::VulkanMesh(VulkanDevice* vulkanDevice): vulkanDevice(vulkanDevice) {}
+    VulkanMesh::VulkanMesh(VulkanDevice* vulkanDevice, const VertexFormat& vertexFormat, const MeshResidency residency):
+        vulkanDevice(vulkanDevice), geometryArena(vulkanDevice->GetGeometryArena(vertexFormat)), vertexFormat(vertexFormat),
+        residency(residency) {}
 
     VulkanMesh::~VulkanMesh()
     {
         for (const auto& meshlet: meshlets)
         {
-            vulkanDevice->DestroyBuffer(meshlet.vertexBuffer);
-            vulkanDevice->DestroyBuffer(meshlet.indexBuffer);
+            meshlet.geometryArena->Free(meshlet.geometry);
         }
     }
 
-    VulkanMeshlet VulkanMesh::MakeMeshlet(VulkanDevice* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
-        MaterialHandle materialHandle)
+    VulkanMeshlet VulkanMesh::MakeMeshlet(VulkanDevice* device, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                          MaterialHandle materialHandle, const VertexFormat& vertexFormat,
+                                          const MeshResidency residency)
     {
+        VulkanGeometryArena* geometryArena = device->GetGeometryArena(vertexFormat);
+        const BoundingBox bounds = BoundingBox::FromVertices(vertices);
+
         return {
-            .vertices = vertices,
-            .indices = indices,
-            .vertexBuffer = CreateVertexBuffer(device, vertices),
-            .indexBuffer = CreateIndexBuffer(device, indices),
-            .material = materialHandle
+            .geometryArena = geometryArena,
+            .geometry = geometryArena->Allocate(vertices, indices, bounds),
+            .material = materialHandle,
+            .bounds = bounds,
+            .cpuData = residency == MeshResidency::KeepCpuCopy ? MakeCpuData(vertices, indices) : nullptr,
         };
     }
 
-    void VulkanMesh::AddMeshlet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    void VulkanMesh::AddMeshlet(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
                                 MaterialHandle materialHandle)
     {
-        const VulkanMeshlet meshlet = {
-            .vertices = vertices,
-            .indices = indices,
-            .vertexBuffer = CreateVertexBuffer(vulkanDevice, vertices),
-            .indexBuffer = CreateIndexBuffer(vulkanDevice, indices),
-            .material = materialHandle
-        };
-
-        meshlets.push_back(meshlet);
+        AddMeshlet(vertices, indices, materialHandle, BoundingBox::FromVertices(vertices));
     }
 
-    AllocatedBuffer VulkanMesh::CreateVertexBuffer(VulkanDevice* device, const std::vector<Vertex>& vertices)
+    void VulkanMesh::AddMeshlet(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                MaterialHandle materialHandle, const BoundingBox& bounds,
+                                std::span<const MeshCluster> clusters)
     {
-        ASSERT(vertices.size() >= 3, "Vertex count must be at least 3");
-
-        const auto bufferSize = sizeof(vertices[0]) * vertices.size();
-        const auto stagingBuffer = device->CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY);
-
-        memcpy(stagingBuffer.GetData(), vertices.data(), bufferSize);
-
-        AllocatedBuffer vertexBuffer = device->CreateBuffer(
-            stagingBuffer.GetBufferSize(),
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VMA_MEMORY_USAGE_GPU_ONLY);
-
-        device->CopyBuffer(stagingBuffer, vertexBuffer);
-        device->DestroyBuffer(stagingBuffer);
-
-        return vertexBuffer;
+        // Quantized positions have to lie inside the bounds, which loader provided bounds do not guarantee
+        const BoundingBox meshletBounds = vertexFormat.quantizedPosition ? BoundingBox::FromVertices(vertices) : bounds;
+
+        meshlets.push_back({
+            .geometryArena = geometryArena,
+            .geometry = geometryArena->Allocate(vertices, indices, meshletBounds),
+            .material = materialHandle,
+            .bounds = meshletBounds,
+            .clusters = std::vector<MeshCluster>(clusters.begin(), clusters.end()),
+            .cpuData = residency == MeshResidency::KeepCpuCopy ? MakeCpuData(vertices, indices) : nullptr,
+        });
     }
 
-    AllocatedBuffer VulkanMesh::CreateIndexBuffer(VulkanDevice* device, const std::vector<uint32_t>& indices)
+    Ref<MeshletCpuData> VulkanMesh::MakeCpuData(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
     {
-        const auto bufferSize = sizeof(indices[0]) * indices.size();
-        const auto stagingBuffer = device->CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY);
-
-        memcpy(stagingBuffer.GetData(), indices.data(), bufferSize);
+        const auto cpuData = CreateRef<MeshletCpuData>();
 
-        AllocatedBuffer indexBuffer = device->CreateBuffer(
-            stagingBuffer.GetBufferSize(),
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VMA_MEMORY_USAGE_GPU_ONLY);
+        cpuData->positions.reserve(vertices.size());
+        for (const Vertex& vertex: vertices)
+            cpuData->positions.push_back(vertex.pos);
 
-        device->CopyBuffer(stagingBuffer, indexBuffer);
-        device->DestroyBuffer(stagingBuffer);
+        cpuData->indices.assign(indices.begin(), indices.end());
 
-        return indexBuffer;
+        return cpuData;
     }
 }
@@ -1,5 +1,7 @@
 #include "renderer/vulkan/vulkan_pipeline.h"
 
+#include <chrono>
+
 #include "renderer/vulkan/vulkan_utils.h"
 #include "renderer/vulkan/vulkan_device.h"
 #include "renderer/mesh.h"
@@ -7,6 +9,7 @@
 
 #include "util/filesystem.h"
 #include "util/log.h"
+#include "util/profiler.h"
 
 namespace MongooseVK
 {
@@ -93,7 +96,7 @@ namespace MongooseVK
 
         std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos;
 
-        const auto vert_shader_code = ShaderCache::shaderCache.at(vertexShaderPath);
+        const auto vert_shader_code = ShaderCache::GetShader(vertexShaderPath, vertexFormat.GetShaderDefines());
         const auto frag_shader_code = ShaderCache::shaderCache.at(fragmentShaderPath);
 
         VkShaderModule vertexShaderModule = VulkanUtils::CreateShaderModule(vulkanDevice->GetDevice(), vert_shader_code);
@@ -113,13 +116,13 @@ namespace MongooseVK
         frag_shader_stage_create_info.pName = "main";
         pipelineShaderStageCreateInfos.push_back(frag_shader_stage_create_info);
 
-        auto binding_description = VulkanVertex::GetBindingDescription();
-        auto attribute_descriptions = VulkanVertex::GetAttributeDescriptions();
+        auto binding_descriptions = VulkanVertex::GetBindingDescriptions(vertexFormat);
+        auto attribute_descriptions = VulkanVertex::GetAttributeDescriptions(vertexFormat);
 
         VkPipelineVertexInputStateCreateInfo vertex_input_info{};
         vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertex_input_info.vertexBindingDescriptionCount = 1;
-        vertex_input_info.pVertexBindingDescriptions = &binding_description;
+        vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
+        vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
         vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
         vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
 
@@ -157,27 +160,7 @@ namespace MongooseVK
         dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
         dynamicState.pDynamicStates = dynamicStates.data();
 
-        std::vector<VkDescriptorSetLayout> vkDescriptorSetLayouts{};
-        for (auto& handle: descriptorSetLayouts)
-        {
-            auto descriptorSetLayout = vulkanDevice->GetDescriptorSetLayout(handle);
-            vkDescriptorSetLayouts.push_back(descriptorSetLayout->descriptorSetLayout);
-        }
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = vkDescriptorSetLayouts.size();
-        pipelineLayoutInfo.pSetLayouts = vkDescriptorSetLayouts.data();
-
-        if (!pushConstantRanges.empty())
-        {
-            pipelineLayoutInfo.pushConstantRangeCount = pushConstantRanges.size();
-            pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
-        }
-
-        VK_CHECK_MSG(
-            vkCreatePipelineLayout(vulkanDevice->GetDevice(), &pipelineLayoutInfo, nullptr, &vulkanPipeline->pipelineLayout),
-            "Failed to create pipeline layout.");
+        CreatePipelineLayout(vulkanDevice, vulkanPipeline);
 
         renderInfo.colorAttachmentCount = colorAttachmentFormats.size();
         renderInfo.pColorAttachmentFormats = colorAttachmentFormats.data();
@@ -210,18 +193,90 @@ namespace MongooseVK
         pipelineInfo.pDepthStencilState = &depthStencil;
         pipelineInfo.pNext = &renderInfo;
 
-        VK_CHECK_MSG(
-            vkCreateGraphicsPipelines(vulkanDevice->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vulkanPipeline->pipeline),
-            "Failed to create graphics pipeline.");
+        VulkanPipelineCache& pipelineCache = vulkanDevice->GetPipelineCache();
+        {
+            PROFILE_SCOPE("Create graphics pipeline");
+            const auto start = std::chrono::steady_clock::now();
+
+            VK_CHECK_MSG(
+                vkCreateGraphicsPipelines(vulkanDevice->GetDevice(), pipelineCache.Get(), 1, &pipelineInfo, nullptr, &vulkanPipeline->pipeline),
+                "Failed to create graphics pipeline.");
+
+            pipelineCache.AddCreation(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
 
         vulkanPipeline->vertexShaderModule = vertexShaderModule;
         vulkanPipeline->fragmentShaderModule = fragmentShaderModule;
 
+        return pipelineHandle;
+    }
+
+    PipelineHandle VulkanPipelineBuilder::BuildCompute(VulkanDevice* vulkanDevice)
+    {
+        PipelineHandle pipelineHandle = vulkanDevice->CreatePipeline();
+        VulkanPipeline* vulkanPipeline = vulkanDevice->GetPipeline(pipelineHandle);
+
+        const auto comp_shader_code = ShaderCache::shaderCache.at(computeShaderPath);
+        VkShaderModule computeShaderModule = VulkanUtils::CreateShaderModule(vulkanDevice->GetDevice(), comp_shader_code);
+
+        VkPipelineShaderStageCreateInfo comp_shader_stage_create_info{};
+        comp_shader_stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        comp_shader_stage_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        comp_shader_stage_create_info.module = computeShaderModule;
+        comp_shader_stage_create_info.pName = "main";
+
+        CreatePipelineLayout(vulkanDevice, vulkanPipeline);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = comp_shader_stage_create_info;
+        pipelineInfo.layout = vulkanPipeline->pipelineLayout;
+
+        VulkanPipelineCache& pipelineCache = vulkanDevice->GetPipelineCache();
+        {
+            PROFILE_SCOPE("Create compute pipeline");
+            const auto start = std::chrono::steady_clock::now();
+
+            VK_CHECK_MSG(
+                vkCreateComputePipelines(vulkanDevice->GetDevice(), pipelineCache.Get(), 1, &pipelineInfo, nullptr, &vulkanPipeline->pipeline),
+                "Failed to create compute pipeline.");
+
+            pipelineCache.AddCreation(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        vulkanPipeline->computeShaderModule = computeShaderModule;
+        vulkanPipeline->bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+        return pipelineHandle;
+    }
+
+    void VulkanPipelineBuilder::CreatePipelineLayout(VulkanDevice* vulkanDevice, VulkanPipeline* vulkanPipeline)
+    {
+        std::vector<VkDescriptorSetLayout> vkDescriptorSetLayouts{};
+        for (auto& handle: descriptorSetLayouts)
+        {
+            auto descriptorSetLayout = vulkanDevice->GetDescriptorSetLayout(handle);
+            vkDescriptorSetLayouts.push_back(descriptorSetLayout->descriptorSetLayout);
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = vkDescriptorSetLayouts.size();
+        pipelineLayoutInfo.pSetLayouts = vkDescriptorSetLayouts.data();
+
+        if (!pushConstantRanges.empty())
+        {
+            pipelineLayoutInfo.pushConstantRangeCount = pushConstantRanges.size();
+            pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+        }
+
+        VK_CHECK_MSG(
+            vkCreatePipelineLayout(vulkanDevice->GetDevice(), &pipelineLayoutInfo, nullptr, &vulkanPipeline->pipelineLayout),
+            "Failed to create pipeline layout.");
+
         vulkanPipeline->descriptorSetLayoutCount = descriptorSetLayouts.size();
         for (size_t i = 0; i < descriptorSetLayouts.size(); i++)
             vulkanPipeline->descriptorSetLayouts[i] = descriptorSetLayouts[i];
-
-        return pipelineHandle;
     }
 
     PipelineHandle VulkanPipelineBuilder::Build(VulkanDevice* vulkanDevice, PipelineCreateInfo& config)
@@ -229,6 +284,8 @@ namespace MongooseVK
         // SPR-V Shader source
         vertexShaderPath = config.vertexShaderPath;
         fragmentShaderPath = config.fragmentShaderPath;
+        computeShaderPath = config.computeShaderPath;
+        vertexFormat = config.vertexFormat;
 
         // Various flags
         polygonMode = Utils::ConvertPolygonMode(config.polygonMode);
@@ -301,6 +358,9 @@ namespace MongooseVK
             pushConstantRanges.push_back(pushConstantRange);
         }
 
+        if (!computeShaderPath.empty())
+            return BuildCompute(vulkanDevice);
+
         return Build(vulkanDevice);
     }
 
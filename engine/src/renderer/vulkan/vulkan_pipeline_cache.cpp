@@ -0,0 +1,203 @@
+#include "renderer/vulkan/vulkan_pipeline_cache.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_utils.h"
+#include "util/log.h"
+#include "util/mapped_file.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        struct PipelineCacheFileHeader {
+            uint32_t magic = PIPELINE_CACHE_MAGIC;
+            uint32_t version = PIPELINE_CACHE_VERSION;
+            uint32_t vendorID = 0;
+            uint32_t deviceID = 0;
+            uint32_t driverVersion = 0;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE]{};
+            uint64_t dataSize = 0;
+            uint64_t dataHash = 0;
+        };
+
+        // FNV-1a, drivers don't all survive being handed corrupted cache data
+        static uint64_t HashPipelineCacheData(const uint8_t* data, const uint64_t size)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint64_t i = 0; i < size; i++)
+            {
+                hash ^= data[i];
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        static PipelineCacheFileHeader GetPipelineCacheFileHeader(const VkPhysicalDeviceProperties& properties)
+        {
+            PipelineCacheFileHeader header{};
+            header.vendorID = properties.vendorID;
+            header.deviceID = properties.deviceID;
+            header.driverVersion = properties.driverVersion;
+            memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+            return header;
+        }
+
+        // The header Vulkan puts in front of its own data has to agree with the device as well
+        static bool IsPipelineCacheDataValid(const uint8_t* data, const uint64_t size, const VkPhysicalDeviceProperties& properties)
+        {
+            if (size < sizeof(VkPipelineCacheHeaderVersionOne)) return false;
+
+            VkPipelineCacheHeaderVersionOne header{};
+            memcpy(&header, data, sizeof(header));
+
+            return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+                   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                   header.vendorID == properties.vendorID &&
+                   header.deviceID == properties.deviceID &&
+                   memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+    }
+
+    VulkanPipelineCache::VulkanPipelineCache(VulkanDevice* vulkanDevice, std::filesystem::path cachePath)
+        : device(vulkanDevice), path(std::move(cachePath))
+    {
+        std::vector<uint8_t> data{};
+        if (Load(data))
+            loadedSize = data.size();
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        VK_CHECK_MSG(vkCreatePipelineCache(device->GetDevice(), &cacheInfo, nullptr, &pipelineCache),
+                     "Failed to create pipeline cache.");
+    }
+
+    VulkanPipelineCache::~VulkanPipelineCache()
+    {
+        vkDestroyPipelineCache(device->GetDevice(), pipelineCache, nullptr);
+    }
+
+    bool VulkanPipelineCache::Save() const
+    {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device->GetDevice(), pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+            return false;
+
+        std::vector<uint8_t> data(dataSize);
+        if (vkGetPipelineCacheData(device->GetDevice(), pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+        {
+            LOG_WARN("Failed to read pipeline cache data");
+            return false;
+        }
+
+        Utils::PipelineCacheFileHeader header = Utils::GetPipelineCacheFileHeader(device->GetDeviceProperties());
+        header.dataSize = dataSize;
+        header.dataHash = Utils::HashPipelineCacheData(data.data(), dataSize);
+
+        const std::filesystem::path tempPath = path.string() + ".tmp";
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        // Written next to the final file and renamed, a crash never leaves a half written cache behind
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                LOG_WARN("Failed to create pipeline cache: " + tempPath.string());
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(dataSize));
+
+            if (!file.good())
+            {
+                LOG_WARN("Failed to write pipeline cache: " + tempPath.string());
+                file.close();
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            LOG_WARN("Failed to store pipeline cache: " + path.string());
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        LOG_INFO("Saved pipeline cache: " + path.string() + " (" + std::to_string(dataSize / 1024) + " KB)");
+        return true;
+    }
+
+    void VulkanPipelineCache::AddCreation(const uint64_t nanoseconds)
+    {
+        pipelineCount.fetch_add(1, std::memory_order_relaxed);
+        creationTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    PipelineCacheStats VulkanPipelineCache::GetStats() const
+    {
+        return {
+            .pipelineCount = pipelineCount.load(std::memory_order_relaxed),
+            .creationTime = static_cast<float>(creationTime.load(std::memory_order_relaxed)) / 1000000.0f,
+            .loadedSize = loadedSize,
+        };
+    }
+
+    bool VulkanPipelineCache::Load(std::vector<uint8_t>& data) const
+    {
+        if (!std::filesystem::exists(path))
+        {
+            LOG_INFO("No pipeline cache, pipelines are created cold");
+            return false;
+        }
+
+        const MappedFile cacheFile(path);
+        if (!cacheFile.IsOpen() || cacheFile.GetSize() < sizeof(Utils::PipelineCacheFileHeader))
+        {
+            LOG_WARN("Failed to map pipeline cache: " + path.string());
+            return false;
+        }
+
+        const VkPhysicalDeviceProperties& properties = device->GetDeviceProperties();
+        const Utils::PipelineCacheFileHeader expectedHeader = Utils::GetPipelineCacheFileHeader(properties);
+
+        Utils::PipelineCacheFileHeader header{};
+        memcpy(&header, cacheFile.GetData(), sizeof(header));
+
+        if (header.magic != PIPELINE_CACHE_MAGIC ||
+            header.version != PIPELINE_CACHE_VERSION ||
+            header.vendorID != expectedHeader.vendorID ||
+            header.deviceID != expectedHeader.deviceID ||
+            header.driverVersion != expectedHeader.driverVersion ||
+            memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            LOG_INFO("Pipeline cache was written by another device or driver: " + path.string());
+            return false;
+        }
+
+        const uint8_t* cacheData = cacheFile.GetData() + sizeof(header);
+        if (header.dataSize != cacheFile.GetSize() - sizeof(header) ||
+            header.dataHash != Utils::HashPipelineCacheData(cacheData, header.dataSize) ||
+            !Utils::IsPipelineCacheDataValid(cacheData, header.dataSize, properties))
+        {
+            LOG_WARN("Pipeline cache is corrupted: " + path.string());
+            return false;
+        }
+
+        data.assign(cacheData, cacheData + header.dataSize);
+
+        LOG_INFO("Loaded pipeline cache: " + path.string() + " (" + std::to_string(header.dataSize / 1024) + " KB)");
+        return true;
+    }
+}
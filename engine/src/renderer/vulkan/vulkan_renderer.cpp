@@ -1,5 +1,6 @@
 #include "renderer/vulkan/vulkan_renderer.h"
 
+#include <cmath>
 #include <ranges>
 #include <renderer/vulkan/vulkan_texture.h>
 #include <renderer/vulkan/vulkan_utils.h>
@@ -9,7 +10,7 @@
 #include <renderer/vulkan/pass/skybox_pass.h>
 #include <renderer/vulkan/pass/lighting/brdf_lut_pass.h>
 
-#include <util/thread_pool.h>
+#include <util/profiler.h>
 #include <util/timer.h>
 
 #include "renderer/vulkan/vulkan_device.h"
@@ -27,8 +28,7 @@ namespace MongooseVK
 {
     VulkanRenderer::~VulkanRenderer()
     {
-        device->DestroyBuffer(cameraBuffer->allocatedBuffer);
-        device->DestroyBuffer(lightBuffer->allocatedBuffer);
+        device->DestroyBuffer(sceneLightsBuffer->allocatedBuffer);
 
         device->DestroyTexture(brdfLUT->textureHandle);
         device->DestroyTexture(prefilteredMap->textureHandle);
@@ -40,6 +40,7 @@ namespace MongooseVK
 
         delete cameraBuffer;
         delete lightBuffer;
+        delete sceneLightsBuffer;
     }
 
     void VulkanRenderer::Init(const uint32_t width, const uint32_t height)
@@ -61,6 +62,8 @@ namespace MongooseVK
 
     void VulkanRenderer::CalculateIBL()
     {
+        PROFILE_FUNCTION();
+
         irradiancePass = new IrradianceMapPass(device);
         brdfLutPass = new BrdfLUTPass(device);
         prefilterPass = new PrefilterMapPass(device);
@@ -118,18 +121,26 @@ namespace MongooseVK
         });
     }
 
-    void VulkanRenderer::LoadScene(const std::string& gltfPath, const std::string& hdrPath)
+    void VulkanRenderer::LoadScene(const std::string& gltfPath, const std::string& hdrPath, const VertexFormat& vertexFormat)
     {
+        PROFILE_FUNCTION();
+
         isSceneLoaded = false;
 
         LOG_TRACE("Load scene");
-        sceneGraph = ResourceManager::LoadSceneGraph(device, gltfPath, hdrPath);
+        sceneGraph = ResourceManager::LoadSceneGraph(device, gltfPath, hdrPath, vertexFormat);
         sceneGraph->directionalLight.direction = normalize(glm::vec3(0.0f, -2.0f, -1.0f));
 
         CreateExternalResources();
         CalculateIBL();
 
+        frameGraph->SetVertexFormat(vertexFormat);
         frameGraph->Compile(renderResolution);
+        frameColorHandle = frameGraph->GetResourceHandle("main_frame_color");
+
+        const PipelineCacheStats pipelineStats = device->GetPipelineCache().GetStats();
+        LOG_INFO("Created {} pipelines in {:.2f} ms ({} pipeline cache)", pipelineStats.pipelineCount, pipelineStats.creationTime,
+                 pipelineStats.loadedSize > 0 ? "warm" : "cold");
 
         frameGraph->AddPass<SkyboxPass::Data>("SkyboxPass", [&](FrameGraph::PassBuilder& builder, SkyboxPass::Data& params) {
                                                   params.cubeMesh = ResourceManager::LoadMesh(device, "resources/models/cube.obj");
@@ -150,21 +161,49 @@ namespace MongooseVK
     {
         if (!isSceneLoaded) return;
 
+        PROFILE_FUNCTION();
+
         device->DrawFrame(vulkanSwapChain->GetSwapChain(),
                           [&](const VkCommandBuffer cmd, const uint32_t imgIndex) {
-                              RotateLight(deltaTime);
-                              sceneGraph->directionalLight.UpdateCascades(camera);
-                              UpdateLightsBuffer();
-                              UpdateCameraBuffer(camera);
+                              {
+                                  PROFILE_SCOPE("Update scene");
+                                  RotateLight(deltaTime);
+                                  sceneGraph->directionalLight.UpdateCascades(camera);
+                                  UpdateLightsBuffer(camera);
+                                  UpdateCameraBuffer(camera);
+                                  sceneGraph->UpdateWorldMatrices();
+                                  sceneGraph->gpuScene->SetOcclusionCulling(IsOcclusionCullingEnabled());
+                                  sceneGraph->gpuScene->Update(*sceneGraph, camera.GetProjection() * camera.GetView(),
+                                                               camera.GetTransform().m_Position);
+                              }
 
                               DrawFrame(cmd, imgIndex);
                           },
-                          std::bind(&VulkanRenderer::ResizeSwapchain, this));
+                          [this] { ResizeSwapchain(); });
+
+        // A debug view was toggled while recording the UI of this frame, the next one is drawn with the new reads
+        if (frameGraph->IsCompilePending())
+        {
+            IdleWait();
+            frameGraph->Resize(renderResolution);
+            frameColorHandle = frameGraph->GetResourceHandle("main_frame_color");
+        }
+    }
+
+    void VulkanRenderer::SetOcclusionCulling(const bool enabled)
+    {
+        for (const char* passName: {"DepthPyramidPass", "OcclusionCullingPass", "GBufferLatePass"})
+            frameGraph->SetPassEnabled(passName, enabled);
+    }
+
+    bool VulkanRenderer::IsOcclusionCullingEnabled() const
+    {
+        return frameGraph->IsPassEnabled("OcclusionCullingPass");
     }
 
     void VulkanRenderer::IdleWait()
     {
-        vkDeviceWaitIdle(device->GetDevice());
+        device->WaitIdle();
     }
 
     void VulkanRenderer::Resize(const int width, const int height)
@@ -200,7 +239,16 @@ namespace MongooseVK
     {
         IdleWait();
         CreateSwapchain();
+
+        // Every pass pipeline is created again, mostly out of the pipeline cache
+        const PipelineCacheStats statsBefore = device->GetPipelineCache().GetStats();
         frameGraph->Resize(renderResolution);
+        const PipelineCacheStats statsAfter = device->GetPipelineCache().GetStats();
+
+        LOG_TRACE("Resize created {} pipelines in {:.2f} ms", statsAfter.pipelineCount - statsBefore.pipelineCount,
+                  statsAfter.creationTime - statsBefore.creationTime);
+
+        frameColorHandle = frameGraph->GetResourceHandle("main_frame_color");
     }
 
     void VulkanRenderer::UpdateCameraBuffer(Camera& camera)
@@ -211,7 +259,7 @@ namespace MongooseVK
             .cameraPosition = camera.GetTransform().m_Position
         };
 
-        memcpy(cameraBuffer->allocatedBuffer.GetData(), &bufferData, sizeof(CameraBuffer));
+        cameraBuffer->dynamicOffset = device->GetUniformRing().Push(bufferData).offset;
     }
 
     void VulkanRenderer::RotateLight(float deltaTime)
@@ -223,7 +271,7 @@ namespace MongooseVK
         sceneGraph->directionalLight.direction = normalize(glm::vec3(glm::vec4(sceneGraph->directionalLight.direction, 1.0f) * rot_mat));
     }
 
-    void VulkanRenderer::UpdateLightsBuffer()
+    void VulkanRenderer::UpdateLightsBuffer(const Camera& camera)
     {
         LightsBuffer bufferData;
 
@@ -239,23 +287,73 @@ namespace MongooseVK
         bufferData.ambientIntensity = sceneGraph->directionalLight.ambientIntensity;
         bufferData.bias = sceneGraph->directionalLight.bias;
 
-        memcpy(lightBuffer->allocatedBuffer.GetData(), &bufferData, sizeof(LightsBuffer));
+        // Written into the region of the frame being recorded, the GPU may still be reading the previous frame's
+        const VkDeviceSize sceneLightsOffset = device->currentFrame * sceneLightsFrameSize;
+        sceneLightsBuffer->dynamicOffset = static_cast<uint32_t>(sceneLightsOffset);
+
+        // Point lights first, spot lights after them
+        GpuLight* sceneLights = reinterpret_cast<GpuLight*>(static_cast<uint8_t*>(sceneLightsBuffer->allocatedBuffer.GetData()) +
+                                                            sceneLightsOffset);
+        uint32_t lightCount = 0;
+
+        for (const PointLight& light: sceneGraph->pointLights)
+        {
+            if (lightCount == MAX_SCENE_LIGHTS) break;
+
+            sceneLights[lightCount++] = {
+                .positionRadius = glm::vec4(light.position, light.attenuationRadius),
+                .colorIntensity = glm::vec4(light.color, light.intensity),
+            };
+        }
+
+        for (const SpotLight& light: sceneGraph->spotLights)
+        {
+            if (lightCount == MAX_SCENE_LIGHTS) break;
+
+            sceneLights[lightCount++] = {
+                .positionRadius = glm::vec4(light.position, light.attenuationRadius),
+                .colorIntensity = glm::vec4(light.color, light.intensity),
+                .spotDirection = glm::vec4(normalize(light.direction), std::cos(light.attenuationAngle)),
+            };
+        }
+
+        // Slice k starts at near * (far / near)^(k / sliceCount)
+        const float nearPlane = camera.GetNearPlane();
+        const float farPlane = camera.GetFarPlane();
+        const float sliceScale = static_cast<float>(LIGHT_CLUSTER_COUNT_Z) / std::log(farPlane / nearPlane);
+
+        bufferData.clusterGrid = {LIGHT_CLUSTER_COUNT_X, LIGHT_CLUSTER_COUNT_Y, LIGHT_CLUSTER_COUNT_Z, lightCount};
+        bufferData.clusterScale = {
+            static_cast<float>(LIGHT_CLUSTER_COUNT_X) / static_cast<float>(renderResolution.width),
+            static_cast<float>(LIGHT_CLUSTER_COUNT_Y) / static_cast<float>(renderResolution.height),
+            sliceScale,
+            -std::log(nearPlane) * sliceScale,
+        };
+
+        lightBuffer->dynamicOffset = device->GetUniformRing().Push(bufferData).offset;
     }
 
     void VulkanRenderer::PresentFrame(const VkCommandBuffer& commandBuffer, uint32_t imageIndex, TextureHandle textureToPresent)
     {
         VkImage swapchainImage = vulkanSwapChain->GetImages()[imageIndex];
-        VulkanTexture* presentTexture = device->GetTexture(textureToPresent);
-
-        VulkanUtils::TransitionImageLayout(commandBuffer, presentTexture->allocatedImage,
-                                           VK_IMAGE_ASPECT_COLOR_BIT,
-                                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-        VulkanUtils::TransitionImageLayout(commandBuffer, swapchainImage,
-                                           VK_IMAGE_ASPECT_COLOR_BIT,
-                                           VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        const VulkanTexture* presentTexture = device->GetTexture(textureToPresent);
+
+        // The frame graph exports the presented texture in TRANSFER_SRC, only the swapchain image is transitioned here.
+        // The acquire semaphore is waited on at the color attachment output stage, the first barrier chains with it.
+        VkImageMemoryBarrier2 swapchainBarrier{};
+        swapchainBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        swapchainBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        swapchainBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+        swapchainBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        swapchainBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        swapchainBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        swapchainBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        swapchainBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        swapchainBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        swapchainBarrier.image = swapchainImage;
+        swapchainBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        VulkanUtils::InsertImageMemoryBarrier2(commandBuffer, swapchainBarrier);
 
         VulkanUtils::CopyParams copyParams{};
         copyParams.regionWidth = renderResolution.width;
@@ -263,15 +361,15 @@ namespace MongooseVK
 
         CopyImage(commandBuffer, presentTexture->allocatedImage, swapchainImage, copyParams);
 
-        VulkanUtils::TransitionImageLayout(commandBuffer, swapchainImage,
-                                           VK_IMAGE_ASPECT_COLOR_BIT,
-                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                           VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        // The present waits on the render finished semaphore, no destination stage is needed
+        swapchainBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        swapchainBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        swapchainBarrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        swapchainBarrier.dstAccessMask = VK_ACCESS_2_NONE;
+        swapchainBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        swapchainBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-        VulkanUtils::TransitionImageLayout(commandBuffer, presentTexture->allocatedImage,
-                                           VK_IMAGE_ASPECT_COLOR_BIT,
-                                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        VulkanUtils::InsertImageMemoryBarrier2(commandBuffer, swapchainBarrier);
     }
 
     void VulkanRenderer::DrawFrame(const VkCommandBuffer& commandBuffer, uint32_t imageIndex)
@@ -282,43 +380,44 @@ namespace MongooseVK
 
         frameGraph->Execute(commandBuffer, sceneGraph);
 
-        PresentFrame(commandBuffer, imageIndex, frameGraph->GetResource("main_frame_color")->textureHandle);
+        PresentFrame(commandBuffer, imageIndex, frameGraph->GetResource(frameColorHandle)->textureHandle);
     }
 
     void VulkanRenderer::CreateExternalResources()
     {
         std::vector<FrameGraph::FrameGraphResourceCreate> frameGraphInputCreations;
 
-        // Lights Buffer
+        // Lights Buffer, rewritten every frame in the uniform ring
         {
-            FrameGraph::FrameGraphBufferCreateInfo bufferCreateInfo{};
-            bufferCreateInfo.size = sizeof(LightsBuffer);
-            bufferCreateInfo.usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-            bufferCreateInfo.memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-
-            FrameGraph::FrameGraphResourceCreate inputCreation{};
-            inputCreation.name = "lights_buffer";
-            inputCreation.type = FrameGraph::ResourceUsage::Type::Buffer;
-            inputCreation.bufferCreateInfo = bufferCreateInfo;
-
-            lightBuffer = CreateFrameGraphBufferResource(inputCreation.name, inputCreation.bufferCreateInfo);
-            frameGraph->AddExternalResource(inputCreation.name, lightBuffer);
+            lightBuffer = CreateFrameGraphUniformResource("lights_buffer", sizeof(LightsBuffer));
+            frameGraph->AddExternalResource(lightBuffer->name, lightBuffer);
         }
 
-        // Camera Buffer
+        // Scene Lights Buffer, a region per frame in flight bound with a dynamic offset
         {
+            const VkDeviceSize alignment = device->GetDeviceProperties().limits.minStorageBufferOffsetAlignment;
+            sceneLightsFrameSize = (sizeof(GpuLight) * MAX_SCENE_LIGHTS + alignment - 1) & ~(alignment - 1);
+
             FrameGraph::FrameGraphBufferCreateInfo bufferCreateInfo{};
-            bufferCreateInfo.size = sizeof(CameraBuffer);
-            bufferCreateInfo.usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            bufferCreateInfo.size = sceneLightsFrameSize * MAX_FRAMES_IN_FLIGHT;
+            bufferCreateInfo.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
             bufferCreateInfo.memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
 
             FrameGraph::FrameGraphResourceCreate inputCreation{};
-            inputCreation.name = "camera_buffer";
+            inputCreation.name = "scene_lights_buffer";
             inputCreation.type = FrameGraph::ResourceUsage::Type::Buffer;
             inputCreation.bufferCreateInfo = bufferCreateInfo;
 
-            cameraBuffer = CreateFrameGraphBufferResource(inputCreation.name, inputCreation.bufferCreateInfo);
-            frameGraph->AddExternalResource(inputCreation.name, cameraBuffer);
+            sceneLightsBuffer = CreateFrameGraphBufferResource(inputCreation.name, inputCreation.bufferCreateInfo);
+            sceneLightsBuffer->bufferInfo.size = sceneLightsFrameSize;
+            sceneLightsBuffer->dynamicBinding = true;
+            frameGraph->AddExternalResource(inputCreation.name, sceneLightsBuffer);
+        }
+
+        // Camera Buffer, rewritten every frame in the uniform ring
+        {
+            cameraBuffer = CreateFrameGraphUniformResource("camera_buffer", sizeof(CameraBuffer));
+            frameGraph->AddExternalResource(cameraBuffer->name, cameraBuffer);
         }
 
         // BRDF LUT
@@ -393,6 +492,7 @@ namespace MongooseVK
         FrameGraph::FrameGraphResource* graphResource = new FrameGraph::FrameGraphResource();
         graphResource->name = resourceName;
         graphResource->type = FrameGraph::ResourceUsage::Type::Buffer;
+        graphResource->bufferInfo = createInfo;
         graphResource->allocatedBuffer = device->CreateBuffer(
             createInfo.size,
             createInfo.usageFlags,
@@ -401,4 +501,21 @@ namespace MongooseVK
 
         return graphResource;
     }
+
+    FrameGraph::FrameGraphResource* VulkanRenderer::CreateFrameGraphUniformResource(const char* resourceName, const uint64_t size)
+    {
+        // Shares the uniform ring buffer, passes bind it with the offset of the current frame's allocation
+        FrameGraph::FrameGraphResource* graphResource = new FrameGraph::FrameGraphResource();
+        graphResource->name = resourceName;
+        graphResource->type = FrameGraph::ResourceUsage::Type::Buffer;
+        graphResource->bufferInfo = {
+            .size = size,
+            .usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        };
+        graphResource->allocatedBuffer.buffer = device->GetUniformRing().GetBuffer();
+        graphResource->dynamicBinding = true;
+
+        return graphResource;
+    }
 }
@@ -7,14 +7,17 @@
 
 namespace MongooseVK
 {
-    void VulkanRenderPass::Begin(const VkCommandBuffer commandBuffer, const VkFramebuffer framebuffer, const VkExtent2D extent)
+    void VulkanRenderPass::Begin(const VkCommandBuffer commandBuffer, const VkFramebuffer framebuffer, const VkExtent2D extent,
+                                 const VkSubpassContents contents)
     {
-        std::vector<VkClearValue> clearValues;
+        // Every color attachment and the depth attachment, kept off the heap since this runs for every pass
+        std::array<VkClearValue, std::tuple_size_v<decltype(config.colorAttachments)> + 1> clearValues{};
+        uint32_t clearValueCount = 0;
 
         for (size_t i = 0; i < config.numColorAttachments; i++)
         {
             const ColorAttachment colorAttachment = config.colorAttachments[i];
-            clearValues.push_back({
+            clearValues[clearValueCount++] = {
                 .color = {
                     {
                         colorAttachment.clearColor.x,
@@ -23,25 +26,24 @@ namespace MongooseVK
                         colorAttachment.clearColor.w
                     }
                 }
-            });
+            };
         }
 
         if (config.depthAttachment.has_value())
         {
-            clearValues.push_back({.depthStencil = {1.0f, 0}});
+            clearValues[clearValueCount++] = {.depthStencil = {1.0f, 0}};
         }
 
-
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = renderPass;
         renderPassInfo.framebuffer = framebuffer;
         renderPassInfo.renderArea.offset = {0, 0};
         renderPassInfo.renderArea.extent = extent;
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.clearValueCount = clearValueCount;
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
     }
 
     void VulkanRenderPass::End(const VkCommandBuffer commandBuffer)
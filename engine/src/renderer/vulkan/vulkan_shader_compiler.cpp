@@ -1,53 +1,91 @@
 #include "renderer/vulkan/vulkan_shader_compiler.h"
 
 #include <filesystem>
-#include <sstream>
 
 #include "util/core.h"
 #include "util/filesystem.h"
 #include "util/log.h"
+#include "util/profiler.h"
 
 namespace MongooseVK
 {
-    shaderc_include_result* ShaderIncluder::GetInclude(const char* requested_source, shaderc_include_type type,
-                                                       const char* requesting_source, size_t include_depth)
+    namespace Utils
     {
-        const auto includePath = std::string("shader/glsl/includes/").append(requested_source);
-        const auto includeSourceRaw = FileSystem::ReadFile(includePath);
+        // Owns what shaderc reads until it releases the include
+        struct ShaderIncludeResult {
+            shaderc_include_result result{};
+            std::string sourceName{};
+            std::vector<char> content{};
+        };
+
+        static void AddDefines(CompilationInfo& info)
+        {
+            for (const std::string& define: info.defines)
+                info.options.AddMacroDefinition(define);
+        }
+    }
 
-        const auto result = new shaderc_include_result(); {
+    ShaderIncludeCache ShaderIncluder::LoadIncludes()
+    {
+        ShaderIncludeCache includes{};
+        for (const auto& file: FileSystem::GetFilesFromDirectory(SHADER_INCLUDE_PATH, true))
+            includes[file.filename().string()] = FileSystem::ReadFile(file.string());
 
-            const uint32_t sourceLength = includeSourceRaw.size();
-            char* includeSource = (char*) malloc(sourceLength);
-            memcpy(includeSource, includeSourceRaw.data(), includeSourceRaw.size());
+        return includes;
+    }
 
-            const std::string requestedSourcePath = std::filesystem::current_path().append(requested_source).string();
-            const uint32_t sourcePathLength = requestedSourcePath.size();
-            char* sourcePath = (char*) malloc(sourcePathLength);
-            memcpy(sourcePath, requestedSourcePath.c_str(), sourcePathLength);
+    shaderc_include_result* ShaderIncluder::GetInclude(const char* requested_source, shaderc_include_type type,
+                                                       const char* requesting_source, size_t include_depth)
+    {
+        const auto includeResult = new Utils::ShaderIncludeResult();
+        includeResult->sourceName = std::filesystem::current_path().append(requested_source).string();
+
+        // Cached includes are shared by every compiler and only read, anything else comes from disk
+        const std::vector<char>* content = nullptr;
+        if (includeCache)
+        {
+            const auto cachedInclude = includeCache->find(requested_source);
+            if (cachedInclude != includeCache->end()) content = &cachedInclude->second;
+        }
 
-            result->content = includeSource;
-            result->content_length = sourceLength;
-            result->source_name = sourcePath;
-            result->source_name_length = sourcePathLength;
+        if (!content)
+        {
+            includeResult->content = FileSystem::ReadFile(std::string(SHADER_INCLUDE_PATH).append(requested_source));
+            content = &includeResult->content;
         }
 
-        return result;
+        shaderc_include_result& result = includeResult->result;
+        result.content = content->data();
+        result.content_length = content->size();
+        result.source_name = includeResult->sourceName.c_str();
+        result.source_name_length = includeResult->sourceName.size();
+        result.user_data = includeResult;
+
+        return &result;
     }
 
     void ShaderIncluder::ReleaseInclude(shaderc_include_result* data)
     {
-        delete data;
+        delete static_cast<Utils::ShaderIncludeResult*>(data->user_data);
+    }
+
+    VulkanShaderCompiler::VulkanShaderCompiler(const ShaderIncludeCache* _includeCache, const ShaderCompileSettings& _settings)
+        : settings(_settings), includeCache(_includeCache)
+    {
+        options.SetTargetEnvironment(settings.targetEnv, settings.targetEnvVersion);
+        options.SetTargetSpirv(settings.spirvVersion);
+        options.SetOptimizationLevel(settings.optimizationLevel);
     }
 
-    VulkanShaderCompiler::VulkanShaderCompiler() {}
     VulkanShaderCompiler::~VulkanShaderCompiler() {}
 
     void VulkanShaderCompiler::PreprocessShader(CompilationInfo& info)
     {
-        LOG_INFO("Preprocessing shader: {0}", info.fileName);
+        PROFILE_FUNCTION();
+        LOG_TRACE("Preprocessing shader: {0}", info.fileName);
 
-        info.options.SetIncluder(std::make_unique<ShaderIncluder>());
+        info.options.SetIncluder(std::make_unique<ShaderIncluder>(includeCache));
+        Utils::AddDefines(info);
         info.source = FileSystem::ReadFile(info.fileName);
 
         const auto result = compiler.PreprocessGlsl(info.source.data(),
@@ -63,16 +101,13 @@ namespace MongooseVK
         const size_t newSize = result.cend() - src;
         info.source.resize(newSize);
         memcpy(info.source.data(), src, newSize);
-
-        LOG_INFO("-------------- Preprocessed GLSL source code -------------------");
-        const std::string output(info.source.begin(), info.source.end());
-        LOG_TRACE(output);
     }
 
     void VulkanShaderCompiler::CompileFileToAssembly(CompilationInfo& info)
     {
         LOG_INFO("Compile shader to assembly: {0}", info.fileName);
 
+        Utils::AddDefines(info);
         info.source = FileSystem::ReadFile(info.fileName);
 
         const auto result = compiler.CompileGlslToSpvAssembly(info.source.data(),
@@ -96,25 +131,14 @@ namespace MongooseVK
 
     std::vector<uint32_t> VulkanShaderCompiler::CompileFile(CompilationInfo& info)
     {
-        LOG_INFO("Compile shader: {0}", info.fileName);
-
-        info.source = FileSystem::ReadFile(info.fileName);
-        info.options.SetIncluder(std::make_unique<ShaderIncluder>());
-
-        //const auto result = compiler.AssembleToSpv(info.source.data(), info.source.size(), info.options);
-        const auto preprocessResult = compiler.PreprocessGlsl(info.source.data(),
-                                                              info.source.size(),
-                                                              info.kind,
-                                                              info.fileName.c_str(),
-                                                              info.options);
+        PreprocessShader(info);
+        return CompilePreprocessed(info);
+    }
 
-        if (preprocessResult.GetCompilationStatus() != shaderc_compilation_status_success)
-            ASSERT(false, "Failed to preprocess shader: " + preprocessResult.GetErrorMessage()); {
-            const char* src = preprocessResult.cbegin();
-            const size_t newSize = preprocessResult.cend() - src;
-            info.source.resize(newSize);
-            memcpy(info.source.data(), src, newSize);
-        }
+    std::vector<uint32_t> VulkanShaderCompiler::CompilePreprocessed(const CompilationInfo& info)
+    {
+        PROFILE_SCOPE(Profiler::InternName(info.fileName));
+        LOG_INFO("Compile shader: {0}", info.fileName);
 
         const auto result = compiler.CompileGlslToSpv(info.source.data(), info.source.size(), info.kind, info.fileName.c_str(), "main", options);
 
@@ -128,11 +152,6 @@ namespace MongooseVK
             memcpy(output.data(), src, wordCount * sizeof(uint32_t));
         }
 
-        LOG_INFO("-------------- SPIR-V Binary Code -------------------");
-        std::stringstream converter;
-        converter << output[0];
-        LOG_TRACE("Magic number: {0}", converter.str());
-
         return output;
     }
 }
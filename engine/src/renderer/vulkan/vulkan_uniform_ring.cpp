@@ -0,0 +1,49 @@
+#include "renderer/vulkan/vulkan_uniform_ring.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "renderer/vulkan/vulkan_device.h"
+
+namespace MongooseVK
+{
+    VulkanUniformRing::VulkanUniformRing(VulkanDevice* vulkanDevice, const VkDeviceSize _frameSize, const uint32_t frameCount)
+        : device(vulkanDevice)
+    {
+        // Device addresses of the allocations are read as std140/std430 blocks, 16 bytes covers both
+        alignment = std::max<VkDeviceSize>(device->GetDeviceProperties().limits.minUniformBufferOffsetAlignment, 16);
+        frameSize = (_frameSize + alignment - 1) & ~(alignment - 1);
+
+        buffer = device->CreateBuffer(frameSize * frameCount,
+                                      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                      VMA_MEMORY_USAGE_CPU_TO_GPU);
+    }
+
+    VulkanUniformRing::~VulkanUniformRing()
+    {
+        vmaDestroyBuffer(device->GetVmaAllocator(), buffer.buffer, buffer.allocation);
+    }
+
+    void VulkanUniformRing::BeginFrame(const uint32_t frameIndex)
+    {
+        peakUsed = std::max(peakUsed, GetUsed());
+        frameBegin = frameIndex * frameSize;
+        frameUsed.store(0, std::memory_order_relaxed);
+    }
+
+    UniformAllocation VulkanUniformRing::Allocate(const VkDeviceSize size)
+    {
+        const VkDeviceSize alignedSize = (size + alignment - 1) & ~(alignment - 1);
+        const VkDeviceSize offset = frameUsed.fetch_add(alignedSize, std::memory_order_relaxed);
+
+        // Unlike CPU scratch memory there is nothing to fall back to, the GPU reads the region as it is
+        if (offset + alignedSize > frameSize)
+            throw std::runtime_error("Uniform ring is out of memory for the frame!");
+
+        return {
+            .data = static_cast<std::byte*>(buffer.GetData()) + frameBegin + offset,
+            .offset = static_cast<uint32_t>(frameBegin + offset),
+            .address = buffer.address + frameBegin + offset,
+        };
+    }
+}
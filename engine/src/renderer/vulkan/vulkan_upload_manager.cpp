@@ -0,0 +1,530 @@
+#include "renderer/vulkan/vulkan_upload_manager.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "renderer/bitmap.h"
+#include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_texture.h"
+#include "renderer/vulkan/vulkan_utils.h"
+#include "util/log.h"
+
+namespace MongooseVK
+{
+    namespace
+    {
+        uint64_t AlignUp(const uint64_t value, const uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        constexpr VkAccessFlags BUFFER_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                                                     VK_ACCESS_INDEX_READ_BIT |
+                                                     VK_ACCESS_UNIFORM_READ_BIT |
+                                                     VK_ACCESS_SHADER_READ_BIT |
+                                                     VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+
+    VulkanUploadManager::VulkanUploadManager(VulkanDevice* vulkanDevice): device(vulkanDevice)
+    {
+        graphicsQueueFamily = device->GetQueueFamilyIndex();
+        transferQueueFamily = device->GetTransferQueueFamilyIndex();
+        dedicatedTransferQueue = transferQueueFamily != graphicsQueueFamily;
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = transferQueueFamily;
+        VK_CHECK_MSG(vkCreateCommandPool(device->GetDevice(), &poolInfo, nullptr, &transferCommandPool),
+                     "Failed to create upload command pool.");
+
+        if (dedicatedTransferQueue)
+        {
+            poolInfo.queueFamilyIndex = graphicsQueueFamily;
+            VK_CHECK_MSG(vkCreateCommandPool(device->GetDevice(), &poolInfo, nullptr, &graphicsCommandPool),
+                         "Failed to create upload command pool.");
+        }
+
+        for (auto& batch: batches)
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            allocInfo.commandPool = transferCommandPool;
+            VK_CHECK_MSG(vkAllocateCommandBuffers(device->GetDevice(), &allocInfo, &batch.transferCommandBuffer),
+                         "Failed to allocate upload command buffer.");
+
+            if (dedicatedTransferQueue)
+            {
+                allocInfo.commandPool = graphicsCommandPool;
+                VK_CHECK_MSG(vkAllocateCommandBuffers(device->GetDevice(), &allocInfo, &batch.graphicsCommandBuffer),
+                             "Failed to allocate upload command buffer.");
+            }
+        }
+
+        VkSemaphoreTypeCreateInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &timelineInfo;
+        VK_CHECK_MSG(vkCreateSemaphore(device->GetDevice(), &semaphoreInfo, nullptr, &timelineSemaphore),
+                     "Failed to create upload timeline semaphore.");
+
+        stagingBuffer = device->CreateBuffer(UPLOAD_STAGING_RING_SIZE,
+                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                             VMA_MEMORY_USAGE_CPU_ONLY);
+
+        LOG_TRACE(std::string("Vulkan: upload manager uses ") + (dedicatedTransferQueue ? "dedicated transfer queue" : "graphics queue"));
+    }
+
+    VulkanUploadManager::~VulkanUploadManager()
+    {
+        WaitIdle();
+
+        vmaDestroyBuffer(device->GetVmaAllocator(), stagingBuffer.buffer, stagingBuffer.allocation);
+        vkDestroySemaphore(device->GetDevice(), timelineSemaphore, nullptr);
+        vkDestroyCommandPool(device->GetDevice(), transferCommandPool, nullptr);
+
+        if (graphicsCommandPool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(device->GetDevice(), graphicsCommandPool, nullptr);
+    }
+
+    UploadToken VulkanUploadManager::UploadBuffer(const AllocatedBuffer& dstBuffer, const void* data, const uint64_t size,
+                                                  const uint64_t dstOffset)
+    {
+        if (!data || size == 0) return INVALID_UPLOAD_TOKEN;
+
+        std::lock_guard lock(uploadMutex);
+
+        const StagingAllocation staging = AllocateStaging(size, 16);
+        memcpy(staging.data, data, size);
+
+        UploadBatch& batch = GetRecordingBatch();
+
+        const VkBufferCopy region{
+            .srcOffset = staging.offset,
+            .dstOffset = dstOffset,
+            .size = size,
+        };
+        vkCmdCopyBuffer(batch.transferCommandBuffer, staging.buffer, dstBuffer.buffer, 1, &region);
+
+        TransferBufferOwnership(batch, dstBuffer.buffer, dstOffset, size);
+
+        return FinishUpload(batch, size);
+    }
+
+    UploadToken VulkanUploadManager::UploadTexture(VulkanTexture* texture, const void* data, const uint64_t size)
+    {
+        if (!data || size == 0) return INVALID_UPLOAD_TOKEN;
+
+        std::lock_guard lock(uploadMutex);
+
+        const StagingAllocation staging = AllocateStaging(size, 16);
+        memcpy(staging.data, data, size);
+
+        UploadBatch& batch = GetRecordingBatch();
+        const TextureCreateInfo& info = texture->createInfo;
+
+        const VkImageSubresourceRange range{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = info.mipLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+
+        VulkanUtils::InsertImageMemoryBarrier(batch.transferCommandBuffer, texture->allocatedImage.image,
+                                              0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                              VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                              VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                              range);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = staging.offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {info.resolution.width, info.resolution.height, 1};
+
+        vkCmdCopyBufferToImage(batch.transferCommandBuffer, staging.buffer, texture->allocatedImage.image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        TransferImageOwnership(batch, texture->allocatedImage.image, range);
+
+        // Blits need a graphics capable queue, so mip generation runs after the ownership acquire
+        const VkCommandBuffer cmd = GetOwnerCommandBuffer(batch);
+        if (info.mipLevels > 1)
+        {
+            VulkanUtils::GenerateMipmaps(cmd,
+                                         device->GetPhysicalDevice(),
+                                         texture->allocatedImage,
+                                         VulkanUtils::ConvertImageFormat(info.format),
+                                         info.resolution.width,
+                                         info.resolution.height,
+                                         info.mipLevels);
+        } else
+        {
+            VulkanUtils::TransitionImageLayout(cmd, texture->allocatedImage,
+                                               VK_IMAGE_ASPECT_COLOR_BIT,
+                                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        return FinishUpload(batch, size);
+    }
+
+    UploadToken VulkanUploadManager::UploadCubemap(VulkanTexture* texture, const Bitmap* cubemap)
+    {
+        if (!cubemap || cubemap->pixelData.empty()) return INVALID_UPLOAD_TOKEN;
+
+        std::lock_guard lock(uploadMutex);
+
+        const uint64_t size = cubemap->pixelData.size();
+        const StagingAllocation staging = AllocateStaging(size, 16);
+        memcpy(staging.data, cubemap->pixelData.data(), size);
+
+        UploadBatch& batch = GetRecordingBatch();
+        const TextureCreateInfo& info = texture->createInfo;
+
+        const VkImageSubresourceRange range{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = info.mipLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 6,
+        };
+
+        VulkanUtils::InsertImageMemoryBarrier(batch.transferCommandBuffer, texture->allocatedImage.image,
+                                              0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                              VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                              VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                              range);
+
+        std::array<VkBufferImageCopy, 6> bufferCopyRegions{};
+        for (uint32_t face = 0; face < 6; face++)
+        {
+            VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[face];
+            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            bufferCopyRegion.imageSubresource.mipLevel = 0;
+            bufferCopyRegion.imageSubresource.baseArrayLayer = face;
+            bufferCopyRegion.imageSubresource.layerCount = 1;
+            bufferCopyRegion.imageExtent = {info.resolution.width, info.resolution.height, 1};
+            bufferCopyRegion.bufferOffset = staging.offset + Bitmap::GetImageOffsetForFace(*cubemap, face);
+        }
+
+        vkCmdCopyBufferToImage(batch.transferCommandBuffer, staging.buffer, texture->allocatedImage.image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(bufferCopyRegions.size()),
+                               bufferCopyRegions.data());
+
+        TransferImageOwnership(batch, texture->allocatedImage.image, range);
+
+        VulkanUtils::GenerateCubemapMipmaps(GetOwnerCommandBuffer(batch),
+                                            device->GetPhysicalDevice(),
+                                            texture->allocatedImage,
+                                            VulkanUtils::ConvertImageFormat(info.format),
+                                            info.resolution.width,
+                                            info.resolution.height,
+                                            info.mipLevels);
+        texture->allocatedImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        return FinishUpload(batch, size);
+    }
+
+    UploadToken VulkanUploadManager::Flush()
+    {
+        std::lock_guard lock(uploadMutex);
+
+        if (batches[currentBatch].recording)
+            SubmitBatch(batches[currentBatch]);
+
+        return lastSubmittedToken;
+    }
+
+    void VulkanUploadManager::Wait(const UploadToken token)
+    {
+        if (token == INVALID_UPLOAD_TOKEN) return;
+
+        {
+            std::lock_guard lock(uploadMutex);
+            UploadBatch& batch = batches[currentBatch];
+            if (batch.recording && token >= batch.token)
+                SubmitBatch(batch);
+        }
+
+        WaitForValue(token);
+
+        std::lock_guard lock(uploadMutex);
+        RetireCompletedBatches();
+    }
+
+    void VulkanUploadManager::WaitIdle()
+    {
+        Wait(Flush());
+    }
+
+    bool VulkanUploadManager::IsComplete(const UploadToken token) const
+    {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device->GetDevice(), timelineSemaphore, &value);
+
+        return value >= token;
+    }
+
+    UploadStats VulkanUploadManager::GetStats()
+    {
+        std::lock_guard lock(uploadMutex);
+        return stats;
+    }
+
+    void VulkanUploadManager::ResetStats()
+    {
+        std::lock_guard lock(uploadMutex);
+        stats = {};
+    }
+
+    VulkanUploadManager::StagingAllocation VulkanUploadManager::AllocateStaging(const uint64_t size, const uint64_t alignment)
+    {
+        // Uploads larger than the whole ring get their own staging buffer, released with the batch
+        if (size > UPLOAD_STAGING_RING_SIZE)
+        {
+            UploadBatch& batch = GetRecordingBatch();
+            const AllocatedBuffer buffer = device->CreateBuffer(size,
+                                                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                                VMA_MEMORY_USAGE_CPU_ONLY);
+            batch.dedicatedStagingBuffers.push_back(buffer);
+            stats.dedicatedStagingBuffers++;
+
+            return {buffer.buffer, 0, buffer.GetData()};
+        }
+
+        while (true)
+        {
+            uint64_t offset = AlignUp(stagingHead, alignment);
+
+            // Allocations never straddle the end of the ring
+            if (offset % UPLOAD_STAGING_RING_SIZE + size > UPLOAD_STAGING_RING_SIZE)
+                offset = AlignUp(offset, UPLOAD_STAGING_RING_SIZE);
+
+            if (offset + size - stagingTail <= UPLOAD_STAGING_RING_SIZE)
+            {
+                stagingHead = offset + size;
+                const uint64_t ringOffset = offset % UPLOAD_STAGING_RING_SIZE;
+
+                return {stagingBuffer.buffer, ringOffset, static_cast<char*>(stagingBuffer.GetData()) + ringOffset};
+            }
+
+            // Out of space, give the pending copies to the GPU and reclaim the oldest batch
+            if (batches[currentBatch].recording)
+                SubmitBatch(batches[currentBatch]);
+
+            if (inFlightBatches.empty())
+            {
+                stagingHead = AlignUp(stagingHead, UPLOAD_STAGING_RING_SIZE);
+                stagingTail = stagingHead;
+                continue;
+            }
+
+            WaitForValue(batches[inFlightBatches.front()].token);
+            RetireCompletedBatches();
+        }
+    }
+
+    VulkanUploadManager::UploadBatch& VulkanUploadManager::GetRecordingBatch()
+    {
+        UploadBatch& batch = batches[currentBatch];
+        if (batch.recording) return batch;
+
+        // Slots are reused round-robin, so this slot is the oldest one still in flight
+        if (!inFlightBatches.empty() && inFlightBatches.front() == currentBatch)
+        {
+            WaitForValue(batch.token);
+            RetireCompletedBatches();
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkResetCommandBuffer(batch.transferCommandBuffer, 0);
+        vkBeginCommandBuffer(batch.transferCommandBuffer, &beginInfo);
+
+        if (dedicatedTransferQueue)
+        {
+            vkResetCommandBuffer(batch.graphicsCommandBuffer, 0);
+            vkBeginCommandBuffer(batch.graphicsCommandBuffer, &beginInfo);
+        }
+
+        // Each batch owns two timeline values: the transfer submit signals the odd one,
+        // the graphics side acquire signals the even one which is handed out as the token
+        batch.token = ++batchCounter * 2;
+        batch.bytes = 0;
+        batch.recording = true;
+
+        return batch;
+    }
+
+    VkCommandBuffer VulkanUploadManager::GetOwnerCommandBuffer(const UploadBatch& batch) const
+    {
+        return dedicatedTransferQueue ? batch.graphicsCommandBuffer : batch.transferCommandBuffer;
+    }
+
+    UploadToken VulkanUploadManager::FinishUpload(UploadBatch& batch, const uint64_t size)
+    {
+        const UploadToken token = batch.token;
+
+        batch.bytes += size;
+        stats.bytes += size;
+        stats.copies++;
+
+        if (batch.bytes >= UPLOAD_BATCH_FLUSH_THRESHOLD)
+            SubmitBatch(batch);
+
+        return token;
+    }
+
+    void VulkanUploadManager::SubmitBatch(UploadBatch& batch)
+    {
+        vkEndCommandBuffer(batch.transferCommandBuffer);
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+        timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineSubmitInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+        if (dedicatedTransferQueue)
+        {
+            vkEndCommandBuffer(batch.graphicsCommandBuffer);
+
+            const uint64_t transferValue = batch.token - 1;
+            timelineSubmitInfo.signalSemaphoreValueCount = 1;
+            timelineSubmitInfo.pSignalSemaphoreValues = &transferValue;
+            submitInfo.pCommandBuffers = &batch.transferCommandBuffer;
+
+            VK_CHECK_MSG(device->QueueSubmit(device->GetTransferQueue(), submitInfo),
+                         "Failed to submit upload batch.");
+
+            constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            timelineSubmitInfo.waitSemaphoreValueCount = 1;
+            timelineSubmitInfo.pWaitSemaphoreValues = &transferValue;
+            timelineSubmitInfo.pSignalSemaphoreValues = &batch.token;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &timelineSemaphore;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.pCommandBuffers = &batch.graphicsCommandBuffer;
+
+            VK_CHECK_MSG(device->QueueSubmit(device->GetGraphicsQueue(), submitInfo),
+                         "Failed to submit upload batch.");
+        } else
+        {
+            timelineSubmitInfo.signalSemaphoreValueCount = 1;
+            timelineSubmitInfo.pSignalSemaphoreValues = &batch.token;
+            submitInfo.pCommandBuffers = &batch.transferCommandBuffer;
+
+            VK_CHECK_MSG(device->QueueSubmit(device->GetGraphicsQueue(), submitInfo),
+                         "Failed to submit upload batch.");
+        }
+
+        batch.recording = false;
+        batch.stagingEnd = stagingHead;
+        lastSubmittedToken = batch.token;
+        stats.batches++;
+
+        inFlightBatches.push_back(currentBatch);
+        currentBatch = (currentBatch + 1) % UPLOAD_BATCH_COUNT;
+    }
+
+    void VulkanUploadManager::RetireCompletedBatches()
+    {
+        uint64_t completedValue = 0;
+        vkGetSemaphoreCounterValue(device->GetDevice(), timelineSemaphore, &completedValue);
+
+        while (!inFlightBatches.empty())
+        {
+            UploadBatch& batch = batches[inFlightBatches.front()];
+            if (batch.token > completedValue) break;
+
+            for (const auto& buffer: batch.dedicatedStagingBuffers)
+                vmaDestroyBuffer(device->GetVmaAllocator(), buffer.buffer, buffer.allocation);
+            batch.dedicatedStagingBuffers.clear();
+
+            stagingTail = std::max(stagingTail, batch.stagingEnd);
+            inFlightBatches.pop_front();
+        }
+    }
+
+    void VulkanUploadManager::WaitForValue(const uint64_t value) const
+    {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timelineSemaphore;
+        waitInfo.pValues = &value;
+
+        VK_CHECK_MSG(vkWaitSemaphores(device->GetDevice(), &waitInfo, UINT64_MAX), "Failed to wait for upload batch.");
+    }
+
+    void VulkanUploadManager::TransferBufferOwnership(const UploadBatch& batch, const VkBuffer buffer, const uint64_t offset,
+                                                      const uint64_t size) const
+    {
+        // On a shared queue the timeline semaphore wait of the consumer is enough
+        if (!dedicatedTransferQueue) return;
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = transferQueueFamily;
+        barrier.dstQueueFamilyIndex = graphicsQueueFamily;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.transferCommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 1, &barrier, 0, nullptr);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = BUFFER_READ_ACCESS;
+        vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                             0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void VulkanUploadManager::TransferImageOwnership(const UploadBatch& batch, const VkImage image,
+                                                     const VkImageSubresourceRange& range) const
+    {
+        if (!dedicatedTransferQueue) return;
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = transferQueueFamily;
+        barrier.dstQueueFamilyIndex = graphicsQueueFamily;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.image = image;
+        barrier.subresourceRange = range;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.transferCommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+    }
+}
@@ -9,12 +9,14 @@
 #include "renderer/vulkan/vulkan_device.h"
 #include "renderer/transform.h"
 #include "renderer/mesh.h"
+#include "renderer/mesh_cluster.h"
 #include "renderer/vulkan/vulkan_material.h"
 #include "renderer/vulkan/vulkan_mesh.h"
 #include "renderer/vulkan/vulkan_renderer.h"
 #include "resource/resource_manager.h"
+#include "resource/scene_cache.h"
+#include "util/job_system.h"
 #include "util/log.h"
-#include "util/timer.h"
 
 namespace MongooseVK
 {
@@ -31,6 +33,8 @@ namespace MongooseVK
             std::vector<Vertex> vertices;
             std::vector<uint32_t> indices;
             int materialIndex = -1;
+            BoundingBox bounds{};
+            std::vector<MeshCluster> clusters;
         };
 
         static std::pair<const float*, int> ReadVertexValue(const tinygltf::Primitive& primitive, const tinygltf::Model& model,
@@ -48,12 +52,16 @@ namespace MongooseVK
             return std::make_pair(buffer, byteStride);
         }
 
-        static std::pair<glm::vec3, glm::vec3> ReadBoundingBoxValues(const tinygltf::Primitive& primitive, const tinygltf::Model& model)
+        // The POSITION accessor bounds are optional in glTF, an empty box means they have to be computed from the vertices
+        static BoundingBox ReadBoundingBoxValues(const tinygltf::Primitive& primitive, const tinygltf::Model& model)
         {
             const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("POSITION")->second];
+            if (accessor.minValues.size() < 3 || accessor.maxValues.size() < 3) return {};
 
-            return std::make_pair(glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
-                                  glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]));
+            return {
+                .min = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
+                .max = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]),
+            };
         }
 
         static uint32_t GetVertexCount(const tinygltf::Primitive& primitive, const tinygltf::Model& model)
@@ -97,8 +105,6 @@ namespace MongooseVK
                 vertices.resize(vertexCount);
                 uint32_t vertexPos = 0;
 
-                std::pair<glm::vec3, glm::vec3> boundingBox = ReadBoundingBoxValues(primitive, model);
-
                 for (auto& vertexAttribute: vAttributes)
                 {
                     if (!HasAttribute(primitive, vertexAttribute.name)) continue;
@@ -186,13 +192,35 @@ namespace MongooseVK
             }
 
             glTFPrimitive result{};
-            result.vertices = vertices;
-            result.indices = indices;
+            result.vertices = std::move(vertices);
+            result.indices = std::move(indices);
             result.materialIndex = primitive.material;
+            result.bounds = ReadBoundingBoxValues(primitive, model);
+            if (result.bounds.min.x > result.bounds.max.x)
+                result.bounds = BoundingBox::FromVertices(result.vertices);
 
             return result;
         }
 
+        static std::vector<std::vector<JobFuture<glTFPrimitive>>> LoadMeshPrimitivesAsync(const tinygltf::Model& model)
+        {
+            std::vector<std::vector<JobFuture<glTFPrimitive>>> primitiveTasks(model.meshes.size());
+
+            for (size_t meshIndex = 0; meshIndex < model.meshes.size(); meshIndex++)
+            {
+                for (const auto& primitive: model.meshes[meshIndex].primitives)
+                {
+                    primitiveTasks[meshIndex].push_back(JobSystem::Async([&primitive, &model] {
+                        glTFPrimitive result = LoadPrimitive(primitive, model);
+                        result.clusters = MeshClustering::BuildClusters(result.vertices, result.indices);
+                        return result;
+                    }));
+                }
+            }
+
+            return primitiveTasks;
+        }
+
         static void LoadGLTFNode(const tinygltf::Node& node,
                                  const tinygltf::Model& model,
                                  const Ref<VulkanMesh>& vulkanMesh,
@@ -203,7 +231,8 @@ namespace MongooseVK
             for (auto& primitive: model.meshes[node.mesh].primitives)
             {
                 glTFPrimitive meshPrimitive = LoadPrimitive(primitive, model);
-                vulkanMesh->AddMeshlet(meshPrimitive.vertices, meshPrimitive.indices, materials[meshPrimitive.materialIndex]);
+                vulkanMesh->AddMeshlet(meshPrimitive.vertices, meshPrimitive.indices, materials[meshPrimitive.materialIndex],
+                                       meshPrimitive.bounds);
             }
         }
     }
@@ -212,15 +241,35 @@ namespace MongooseVK
     std::vector<TextureHandle> GLTFLoader::LoadTextures(VulkanDevice* device, const tinygltf::Model& model,
                                                         const std::filesystem::path& parentPath)
     {
-        std::vector<TextureHandle> textures;
-        for (const tinygltf::Texture& tex: model.textures)
+        // Decode every image in parallel, textures sharing an image share its handle
+        std::vector<JobFuture<ImageResource>> imageTasks;
+        imageTasks.reserve(model.images.size());
+
+        for (const tinygltf::Image& image: model.images)
         {
-            tinygltf::Image image = model.images[tex.source];
             std::string imagePath = parentPath.string() + "/" + image.uri;
+            imageTasks.push_back(JobSystem::Async([imagePath] {
+                return ResourceManager::LoadImageResource(imagePath);
+            }));
+        }
 
-            ResourceManager::LoadTexture( device, imagePath, &textures);
+        // GPU resources are created on the calling thread in image order, uploads are only enqueued here
+        std::vector<TextureHandle> imageTextures;
+        imageTextures.reserve(imageTasks.size());
+
+        for (auto& imageTask: imageTasks)
+        {
+            const ImageResource imageResource = imageTask.Get();
+            imageTextures.push_back(ResourceManager::CreateTextureFromImage(device, imageResource));
+            ResourceManager::ReleaseImage(imageResource);
         }
 
+        std::vector<TextureHandle> textures;
+        textures.reserve(model.textures.size());
+
+        for (const tinygltf::Texture& tex: model.textures)
+            textures.push_back(imageTextures[tex.source]);
+
         return textures;
     }
 
@@ -288,91 +337,108 @@ namespace MongooseVK
         return mesh;
     }
 
-    static void AddNode(VulkanDevice* device,
-                        SceneGraph& scene,
-                        const SceneNodeHandle parent,
-                        const tinygltf::Model& model,
-                        const tinygltf::Node& glTFNode,
-                        const int level)
+    static void BakeNode(BakedSceneData& bakedScene,
+                         const int64_t parent,
+                         const tinygltf::Model& model,
+                         const tinygltf::Node& glTFNode)
     {
-        const int currentNodeIndex = scene.nodes.size();
-        // Setup node
+        BakedNode node{.parent = parent, .mesh = glTFNode.mesh, .name = bakedScene.AddString(glTFNode.name)};
+
+        if (glTFNode.translation.size() == 3)
+        {
+            node.position = glm::make_vec3(glTFNode.translation.data());
+        }
+        if (glTFNode.rotation.size() == 4)
         {
-            scene.nodes.push_back({.parent = parent});
-            scene.nodes[currentNodeIndex].handle = currentNodeIndex;
-            scene.nodes[currentNodeIndex].level = level;
+            glm::quat quaternion = glm::make_quat(glTFNode.rotation.data());
+            node.rotation = eulerAngles(quaternion) * 180.f / static_cast<float>(M_PI);
+        }
+        if (glTFNode.scale.size() == 3)
+        {
+            node.scale = glm::make_vec3(glTFNode.scale.data());
+        }
 
-            scene.names.push_back(glTFNode.name);
+        bakedScene.nodes.push_back(node);
 
-            if (parent != INVALID_SCENE_NODE_HANDLE)
-            {
-                const int64_t firstChildIndex = scene.nodes[parent].firstChild;
+        // Scene node handles start after the implicit root
+        const int64_t handle = static_cast<int64_t>(bakedScene.nodes.size());
+        for (const auto& childNode: glTFNode.children)
+            BakeNode(bakedScene, handle, model, model.nodes[childNode]);
+    }
 
-                if (firstChildIndex == INVALID_SCENE_NODE_HANDLE)
-                {
-                    scene.nodes[parent].firstChild = currentNodeIndex;
-                    scene.nodes[currentNodeIndex].lastSibling = currentNodeIndex;
-                } else
-                {
-                    int64_t lastSiblingIndex = scene.nodes[firstChildIndex].lastSibling;
-                    if (lastSiblingIndex == INVALID_SCENE_NODE_HANDLE)
-                    {
-                        for (lastSiblingIndex = firstChildIndex;
-                             scene.nodes[lastSiblingIndex].nextSibling != INVALID_SCENE_NODE_HANDLE;
-                             lastSiblingIndex = scene.nodes[lastSiblingIndex].nextSibling
-                        );
-                    }
-                    scene.nodes[lastSiblingIndex].nextSibling = currentNodeIndex;
-                    scene.nodes[firstChildIndex].lastSibling = currentNodeIndex;
-                }
-            }
-        }
+    BakedSceneData GLTFLoader::BakeScene(const tinygltf::Model& model, const std::filesystem::path& parentPath)
+    {
+        BakedSceneData bakedScene{};
 
-        // Load transforms
-        {
-            Transform transform;
-            // Generate local node matrix
-            if (glTFNode.translation.size() == 3)
-            {
-                transform.m_Position = glm::make_vec3(glTFNode.translation.data());
-            }
-            if (glTFNode.rotation.size() == 4)
-            {
-                glm::quat quaternion = glm::make_quat(glTFNode.rotation.data());
-                transform.m_Rotation = eulerAngles(quaternion) * 180.f / static_cast<float>(M_PI);
-            }
-            if (glTFNode.scale.size() == 3)
-            {
-                transform.m_Scale = glm::make_vec3(glTFNode.scale.data());
-            }
+        auto primitiveTasks = Utils::LoadMeshPrimitivesAsync(model);
 
-            scene.transforms.push_back(transform);
+        for (const tinygltf::Buffer& buffer: model.buffers)
+        {
+            if (!buffer.uri.empty() && !tinygltf::IsDataURI(buffer.uri))
+                bakedScene.AddDependency(parentPath / buffer.uri);
         }
 
-        // Load mesh
-        {
-            const auto mesh = new VulkanMesh(device);
-            if (glTFNode.mesh > -1) {
-                scene.meshes.push_back(mesh);
-                for (auto& primitive: model.meshes[glTFNode.mesh].primitives)
-                {
-                    Utils::glTFPrimitive meshPrimitive = Utils::LoadPrimitive(primitive, model);
-                    mesh->AddMeshlet(meshPrimitive.vertices, meshPrimitive.indices, scene.materials[meshPrimitive.materialIndex]);
-                }
+        for (const tinygltf::Image& image: model.images)
+            bakedScene.images.push_back(bakedScene.AddString(parentPath.string() + "/" + image.uri));
 
-            }
+        const auto GetTextureImage = [&](const int textureIndex) {
+            return textureIndex >= 0 ? model.textures[textureIndex].source : -1;
+        };
+
+        for (const tinygltf::Material& material: model.materials)
+        {
+            const BakedMaterial bakedMaterial = {
+                .baseColor = glm::make_vec4(material.pbrMetallicRoughness.baseColorFactor.data()),
+                .metallic = static_cast<float>(material.pbrMetallicRoughness.metallicFactor),
+                .roughness = static_cast<float>(material.pbrMetallicRoughness.roughnessFactor),
+                .baseColorImage = GetTextureImage(material.pbrMetallicRoughness.baseColorTexture.index),
+                .metallicRoughnessImage = GetTextureImage(material.pbrMetallicRoughness.metallicRoughnessTexture.index),
+                .normalMapImage = GetTextureImage(material.normalTexture.index),
+                .alphaTested = material.alphaMode != "OPAQUE",
+            };
+
+            bakedScene.materials.push_back(bakedMaterial);
         }
 
-        // Load child nodes
+        // Primitives are appended in mesh order so the baked file is deterministic
+        for (auto& meshTasks: primitiveTasks)
         {
-            for (const auto& childNode: glTFNode.children)
+            BakedMesh bakedMesh{};
+            bakedMesh.firstPrimitive = static_cast<uint32_t>(bakedScene.primitives.size());
+            bakedMesh.primitiveCount = static_cast<uint32_t>(meshTasks.size());
+
+            for (auto& task: meshTasks)
             {
-                AddNode(device, scene, currentNodeIndex, model, model.nodes[childNode], level + 1);
+                const Utils::glTFPrimitive primitive = task.Get();
+
+                bakedScene.primitives.push_back({
+                    .firstVertex = static_cast<uint32_t>(bakedScene.vertices.size()),
+                    .vertexCount = static_cast<uint32_t>(primitive.vertices.size()),
+                    .firstIndex = static_cast<uint32_t>(bakedScene.indices.size()),
+                    .indexCount = static_cast<uint32_t>(primitive.indices.size()),
+                    .firstCluster = static_cast<uint32_t>(bakedScene.clusters.size()),
+                    .clusterCount = static_cast<uint32_t>(primitive.clusters.size()),
+                    .materialIndex = primitive.materialIndex,
+                    .boundsMin = primitive.bounds.min,
+                    .boundsMax = primitive.bounds.max,
+                });
+
+                bakedScene.vertices.insert(bakedScene.vertices.end(), primitive.vertices.begin(), primitive.vertices.end());
+                bakedScene.indices.insert(bakedScene.indices.end(), primitive.indices.begin(), primitive.indices.end());
+                bakedScene.clusters.insert(bakedScene.clusters.end(), primitive.clusters.begin(), primitive.clusters.end());
             }
+
+            bakedScene.meshes.push_back(bakedMesh);
         }
+
+        const tinygltf::Scene& gltfScene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
+        for (auto& node: gltfScene.nodes)
+            BakeNode(bakedScene, 0, model, model.nodes[node]);
+
+        return bakedScene;
     }
 
-    SceneGraph* GLTFLoader::LoadSceneGraph(VulkanDevice* device, const std::string& scenePath)
+    SceneGraph* GLTFLoader::LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const VertexFormat& vertexFormat)
     {
         tinygltf::Model model;
         tinygltf::TinyGLTF loader;
@@ -392,14 +458,9 @@ namespace MongooseVK
             abort();
         }
 
-        const tinygltf::Scene& gltfScene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
-
-        const auto sceneGraph = new SceneGraph();
-        sceneGraph->materials = LoadMaterials(device, model, gltfFilePath.parent_path());
-
-        for (auto& node: gltfScene.nodes)
-            AddNode(device, *sceneGraph, 0, model, model.nodes[node], 1);
+        const BakedSceneData bakedScene = BakeScene(model, gltfFilePath.parent_path());
+        SceneCache::Write(scenePath, bakedScene.GetView());
 
-        return sceneGraph;
+        return SceneCache::CreateSceneGraph(device, bakedScene.GetView(), vertexFormat);
     }
 }
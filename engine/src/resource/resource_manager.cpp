@@ -14,16 +14,19 @@
 
 #include "resource/loaders/gltf_loader.h"
 #include "resource/loaders/obj_loader.h"
+#include "resource/scene_cache.h"
 #include "renderer/bitmap.h"
 #include "renderer/vulkan/vulkan_mesh.h"
 #include "renderer/vulkan/vulkan_device.h"
 #include "renderer/vulkan/vulkan_texture.h"
 #include "util/log.h"
+#include "util/mapped_file.h"
+#include "util/profiler.h"
+#include "util/timer.h"
 
 namespace MongooseVK
 {
     static std::mutex textureMtx;
-    static std::mutex imageResourceMtx;
 
     ImageResource ResourceManager::LoadImageResource(const std::string& imagePath)
     {
@@ -31,13 +34,8 @@ namespace MongooseVK
 
         int width, height, channels;
 
-        unsigned char* pixels;
-
-        // stbi_load isn't completely thread safe
-        {
-            std::lock_guard lock(imageResourceMtx);
-            pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-        }
+        // stb_image keeps its global state in thread locals, so images can be decoded concurrently
+        unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 
         const uint64_t size = width * height * 4;
 
@@ -106,13 +104,7 @@ namespace MongooseVK
     {
         LOG_INFO("Load Texture: " + textureImagePath);
         const ImageResource imageResource = LoadImageResource(textureImagePath);
-        const TextureHandle textureHandle = device->CreateTexture({
-            .resolution = {imageResource.width, imageResource.height},
-            .format = imageResource.format,
-            .data = imageResource.data,
-            .size = imageResource.size,
-            .generateMipMaps = true,
-        });
+        const TextureHandle textureHandle = CreateTextureFromImage(device, imageResource);
         ReleaseImage(imageResource);
 
         // Put handles in a shared std::vector
@@ -122,6 +114,17 @@ namespace MongooseVK
         }
     }
 
+    TextureHandle ResourceManager::CreateTextureFromImage(VulkanDevice* device, const ImageResource& imageResource)
+    {
+        return device->CreateTexture({
+            .resolution = {imageResource.width, imageResource.height},
+            .format = imageResource.format,
+            .data = imageResource.data,
+            .size = imageResource.size,
+            .generateMipMaps = true,
+        });
+    }
+
     Bitmap ResourceManager::LoadHDRCubeMapBitmap(VulkanDevice* device, const std::string& hdrPath)
     {
         VkImageFormatProperties properties;
@@ -165,9 +168,26 @@ namespace MongooseVK
         delete out;
     }
 
-    SceneGraph* ResourceManager::LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const std::string& skyboxPath)
+    SceneGraph* ResourceManager::LoadSceneGraph(VulkanDevice* device, const std::string& scenePath, const std::string& skyboxPath,
+                                                const VertexFormat& vertexFormat)
     {
-        SceneGraph* sceneGraph = GLTFLoader().LoadSceneGraph(device, scenePath);
+        VulkanUploadManager* uploadManager = device->GetUploadManager();
+        uploadManager->ResetStats();
+
+        Timer timer("Load scene graph");
+        PROFILE_FUNCTION();
+
+        // Baked scenes are mapped and encoded straight into staging memory, glTF is only parsed when the cache is stale
+        MappedFile sceneCacheFile;
+        BakedScene bakedScene{};
+
+        SceneGraph* sceneGraph = SceneCache::Map(scenePath, sceneCacheFile, bakedScene)
+                                     ? SceneCache::CreateSceneGraph(device, bakedScene, vertexFormat)
+                                     : GLTFLoader().LoadSceneGraph(device, scenePath, vertexFormat);
+        sceneCacheFile.Close();
+
+        sceneGraph->gpuScene = new VulkanGpuScene(device);
+        sceneGraph->gpuScene->Build(*sceneGraph);
 
         Bitmap cubemapBitmap = LoadHDRCubeMapBitmap(device, skyboxPath);
         const TextureCreateInfo textureCreateInfo = {
@@ -182,6 +202,18 @@ namespace MongooseVK
         sceneGraph->skyboxTexture = device->CreateTexture(textureCreateInfo);
         device->UploadCubemapTextureData(sceneGraph->skyboxTexture, &cubemapBitmap);
 
+        // Loaders only enqueue copies, wait for all of them once here
+        uploadManager->WaitIdle();
+
+        const UploadStats uploadStats = uploadManager->GetStats();
+        LOG_INFO("Scene upload: " + std::to_string(uploadStats.bytes / (1024 * 1024)) + " MB, " +
+                 std::to_string(uploadStats.copies) + " copies in " + std::to_string(uploadStats.batches) + " batches");
+
+        const GeometryArenaStats geometryStats = device->GetGeometryArena(vertexFormat)->GetStats();
+        LOG_INFO("Geometry arena: " + std::to_string(geometryStats.vertexUsed) + "/" + std::to_string(geometryStats.vertexCapacity) +
+                 " vertices (" + std::to_string(geometryStats.vertexSize) + " bytes each), " + std::to_string(geometryStats.indexUsed) + "/" + std::to_string(geometryStats.indexCapacity) +
+                 " indices in " + std::to_string(geometryStats.allocations) + " allocations");
+
         return sceneGraph;
     }
 }
@@ -0,0 +1,438 @@
+#include "resource/scene_cache.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "renderer/scene.h"
+#include "renderer/transform.h"
+#include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_mesh.h"
+#include "resource/resource_manager.h"
+#include "util/job_system.h"
+#include "util/log.h"
+#include "util/profiler.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        enum BakedSceneSection : uint32_t {
+            BAKED_SECTION_STRINGS,
+            BAKED_SECTION_IMAGES,
+            BAKED_SECTION_MATERIALS,
+            BAKED_SECTION_NODES,
+            BAKED_SECTION_MESHES,
+            BAKED_SECTION_PRIMITIVES,
+            BAKED_SECTION_VERTICES,
+            BAKED_SECTION_INDICES,
+            BAKED_SECTION_CLUSTERS,
+            BAKED_SECTION_DEPENDENCIES,
+            BAKED_SECTION_COUNT
+        };
+
+        struct BakedSectionRange {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        struct BakedSceneSource {
+            uint64_t pathHash = 0;
+            int64_t modifiedTime = 0;
+            uint64_t size = 0;
+            uint64_t contentHash = 0;
+
+            bool operator==(const BakedSceneSource& other) const = default;
+        };
+
+        struct BakedSceneHeader {
+            uint32_t magic = BAKED_SCENE_MAGIC;
+            uint32_t version = BAKED_SCENE_VERSION;
+            uint32_t vertexSize = sizeof(Vertex);
+            uint32_t sectionCount = BAKED_SECTION_COUNT;
+            BakedSceneSource source{};
+            BakedSectionRange sections[BAKED_SECTION_COUNT]{};
+        };
+
+        // FNV-1a
+        static uint64_t HashBytes(const void* data, const uint64_t size)
+        {
+            const auto bytes = static_cast<const uint8_t*>(data);
+
+            uint64_t hash = 14695981039346656037ull;
+            for (uint64_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        static uint64_t AlignSectionOffset(const uint64_t offset)
+        {
+            return (offset + BAKED_SCENE_SECTION_ALIGNMENT - 1) & ~(BAKED_SCENE_SECTION_ALIGNMENT - 1);
+        }
+
+        static uint64_t GetPathHash(const std::string& path)
+        {
+            const std::string normalizedPath = std::filesystem::absolute(path).lexically_normal().generic_string();
+            return HashBytes(normalizedPath.data(), normalizedPath.size());
+        }
+
+        static bool GetFileStamp(const std::filesystem::path& path, int64_t& modifiedTime, uint64_t& size)
+        {
+            std::error_code error;
+
+            const auto writeTime = std::filesystem::last_write_time(path, error);
+            if (error) return false;
+
+            size = std::filesystem::file_size(path, error);
+            if (error) return false;
+
+            modifiedTime = writeTime.time_since_epoch().count();
+            return true;
+        }
+
+        static bool ReadSceneSource(const std::string& scenePath, BakedSceneSource& source)
+        {
+            if (!GetFileStamp(scenePath, source.modifiedTime, source.size)) return false;
+
+            const MappedFile sceneFile(scenePath);
+            if (!sceneFile.IsOpen()) return false;
+
+            source.pathHash = GetPathHash(scenePath);
+            source.contentHash = HashBytes(sceneFile.GetData(), sceneFile.GetSize());
+
+            return true;
+        }
+
+        template<typename T>
+        static bool GetSection(const MappedFile& file, const BakedSceneHeader& header, const BakedSceneSection section,
+                               std::span<const T>& result)
+        {
+            const BakedSectionRange& range = header.sections[section];
+
+            if (range.offset % BAKED_SCENE_SECTION_ALIGNMENT != 0) return false;
+            if (range.size % sizeof(T) != 0) return false;
+            if (range.offset > file.GetSize() || range.size > file.GetSize() - range.offset) return false;
+
+            result = {reinterpret_cast<const T*>(file.GetData() + range.offset), range.size / sizeof(T)};
+            return true;
+        }
+
+        static bool IsStringValid(const BakedScene& scene, const BakedString& string)
+        {
+            return string.offset <= scene.strings.size() && string.length <= scene.strings.size() - string.offset;
+        }
+
+        // Checks every index stored in the file so a damaged cache can never read out of bounds
+        static bool IsSceneValid(const BakedScene& scene)
+        {
+            for (const BakedString& image: scene.images)
+                if (!IsStringValid(scene, image)) return false;
+
+            const auto isImageValid = [&](const int32_t image) { return image < static_cast<int32_t>(scene.images.size()); };
+            for (const BakedMaterial& material: scene.materials)
+            {
+                if (!isImageValid(material.baseColorImage) ||
+                    !isImageValid(material.metallicRoughnessImage) ||
+                    !isImageValid(material.normalMapImage))
+                    return false;
+            }
+
+            for (size_t i = 0; i < scene.nodes.size(); i++)
+            {
+                const BakedNode& node = scene.nodes[i];
+                if (node.parent < 0 || node.parent > static_cast<int64_t>(i)) return false;
+                if (node.mesh >= static_cast<int32_t>(scene.meshes.size())) return false;
+                if (!IsStringValid(scene, node.name)) return false;
+            }
+
+            for (const BakedMesh& mesh: scene.meshes)
+            {
+                if (mesh.firstPrimitive > scene.primitives.size() ||
+                    mesh.primitiveCount > scene.primitives.size() - mesh.firstPrimitive)
+                    return false;
+            }
+
+            for (const BakedPrimitive& primitive: scene.primitives)
+            {
+                if (primitive.firstVertex > scene.vertices.size() ||
+                    primitive.vertexCount > scene.vertices.size() - primitive.firstVertex)
+                    return false;
+                if (primitive.firstIndex > scene.indices.size() ||
+                    primitive.indexCount > scene.indices.size() - primitive.firstIndex)
+                    return false;
+                if (primitive.firstCluster > scene.clusters.size() ||
+                    primitive.clusterCount > scene.clusters.size() - primitive.firstCluster)
+                    return false;
+                if (primitive.materialIndex >= static_cast<int32_t>(scene.materials.size())) return false;
+
+                for (const MeshCluster& cluster: scene.clusters.subspan(primitive.firstCluster, primitive.clusterCount))
+                {
+                    if (cluster.firstIndex > primitive.indexCount || cluster.indexCount > primitive.indexCount - cluster.firstIndex)
+                        return false;
+                }
+            }
+
+            for (const BakedDependency& dependency: scene.dependencies)
+                if (!IsStringValid(scene, dependency.path)) return false;
+
+            return true;
+        }
+
+        static bool AreDependenciesUpToDate(const BakedScene& scene)
+        {
+            for (const BakedDependency& dependency: scene.dependencies)
+            {
+                int64_t modifiedTime = 0;
+                uint64_t size = 0;
+
+                const std::filesystem::path path(scene.GetString(dependency.path));
+                if (!GetFileStamp(path, modifiedTime, size)) return false;
+                if (modifiedTime != dependency.modifiedTime || size != dependency.size) return false;
+            }
+
+            return true;
+        }
+    }
+
+    void BakedSceneData::AddDependency(const std::filesystem::path& path)
+    {
+        BakedDependency dependency{.path = AddString(path.string())};
+        Utils::GetFileStamp(path, dependency.modifiedTime, dependency.size);
+
+        dependencies.push_back(dependency);
+    }
+
+    std::filesystem::path SceneCache::GetCachePath(const std::string& scenePath)
+    {
+        char pathHash[17];
+        snprintf(pathHash, sizeof(pathHash), "%016llx", static_cast<unsigned long long>(Utils::GetPathHash(scenePath)));
+
+        const std::string fileName = std::filesystem::path(scenePath).stem().string() + "_" + pathHash + ".mvkscene";
+        return std::filesystem::path("cache") / fileName;
+    }
+
+    bool SceneCache::Map(const std::string& scenePath, MappedFile& cacheFile, BakedScene& scene)
+    {
+        const std::filesystem::path cachePath = GetCachePath(scenePath);
+        if (!std::filesystem::exists(cachePath)) return false;
+
+        Utils::BakedSceneSource source{};
+        if (!Utils::ReadSceneSource(scenePath, source)) return false;
+
+        if (!cacheFile.Open(cachePath) || cacheFile.GetSize() < sizeof(Utils::BakedSceneHeader))
+        {
+            LOG_WARN("Failed to map scene cache: " + cachePath.string());
+            cacheFile.Close();
+            return false;
+        }
+
+        Utils::BakedSceneHeader header{};
+        memcpy(&header, cacheFile.GetData(), sizeof(header));
+
+        if (header.magic != BAKED_SCENE_MAGIC ||
+            header.version != BAKED_SCENE_VERSION ||
+            header.vertexSize != sizeof(Vertex) ||
+            header.sectionCount != Utils::BAKED_SECTION_COUNT ||
+            header.source != source)
+        {
+            LOG_INFO("Scene cache is out of date: " + cachePath.string());
+            cacheFile.Close();
+            return false;
+        }
+
+        BakedScene mappedScene{};
+        const bool sectionsValid =
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_STRINGS, mappedScene.strings) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_IMAGES, mappedScene.images) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_MATERIALS, mappedScene.materials) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_NODES, mappedScene.nodes) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_MESHES, mappedScene.meshes) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_PRIMITIVES, mappedScene.primitives) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_VERTICES, mappedScene.vertices) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_INDICES, mappedScene.indices) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_CLUSTERS, mappedScene.clusters) &&
+            Utils::GetSection(cacheFile, header, Utils::BAKED_SECTION_DEPENDENCIES, mappedScene.dependencies);
+
+        if (!sectionsValid || !Utils::IsSceneValid(mappedScene))
+        {
+            LOG_WARN("Scene cache is corrupted: " + cachePath.string());
+            cacheFile.Close();
+            return false;
+        }
+
+        if (!Utils::AreDependenciesUpToDate(mappedScene))
+        {
+            LOG_INFO("Scene cache dependencies changed: " + cachePath.string());
+            cacheFile.Close();
+            return false;
+        }
+
+        LOG_INFO("Scene cache hit: " + cachePath.string());
+        scene = mappedScene;
+
+        return true;
+    }
+
+    bool SceneCache::Write(const std::string& scenePath, const BakedScene& scene)
+    {
+        Utils::BakedSceneHeader header{};
+        if (!Utils::ReadSceneSource(scenePath, header.source)) return false;
+
+        const std::array<std::span<const std::byte>, Utils::BAKED_SECTION_COUNT> sections = {
+            std::as_bytes(scene.strings),
+            std::as_bytes(scene.images),
+            std::as_bytes(scene.materials),
+            std::as_bytes(scene.nodes),
+            std::as_bytes(scene.meshes),
+            std::as_bytes(scene.primitives),
+            std::as_bytes(scene.vertices),
+            std::as_bytes(scene.indices),
+            std::as_bytes(scene.clusters),
+            std::as_bytes(scene.dependencies),
+        };
+
+        uint64_t fileSize = Utils::AlignSectionOffset(sizeof(header));
+        for (uint32_t i = 0; i < Utils::BAKED_SECTION_COUNT; i++)
+        {
+            header.sections[i] = {fileSize, sections[i].size()};
+            fileSize = Utils::AlignSectionOffset(fileSize + sections[i].size());
+        }
+
+        const std::filesystem::path cachePath = GetCachePath(scenePath);
+        const std::filesystem::path tempPath = cachePath.string() + ".tmp";
+
+        std::error_code error;
+        std::filesystem::create_directories(cachePath.parent_path(), error);
+
+        // Written next to the final file and renamed, a crash never leaves a half written cache behind
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                LOG_WARN("Failed to create scene cache: " + tempPath.string());
+                return false;
+            }
+
+            constexpr char padding[BAKED_SCENE_SECTION_ALIGNMENT]{};
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            uint64_t written = sizeof(header);
+
+            for (uint32_t i = 0; i < Utils::BAKED_SECTION_COUNT; i++)
+            {
+                file.write(padding, static_cast<std::streamsize>(header.sections[i].offset - written));
+                file.write(reinterpret_cast<const char*>(sections[i].data()), static_cast<std::streamsize>(sections[i].size()));
+                written = header.sections[i].offset + sections[i].size();
+            }
+
+            if (!file.good())
+            {
+                LOG_WARN("Failed to write scene cache: " + tempPath.string());
+                file.close();
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            LOG_WARN("Failed to store scene cache: " + cachePath.string());
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        LOG_INFO("Baked scene cache: " + cachePath.string() + " (" + std::to_string(fileSize / (1024 * 1024)) + " MB)");
+        return true;
+    }
+
+    SceneGraph* SceneCache::CreateSceneGraph(VulkanDevice* device, const BakedScene& scene, const VertexFormat& vertexFormat)
+    {
+        // Decode every image in parallel, GPU resources are created on the calling thread in image order
+        std::vector<JobFuture<ImageResource>> imageTasks;
+        imageTasks.reserve(scene.images.size());
+
+        for (const BakedString& image: scene.images)
+        {
+            imageTasks.push_back(JobSystem::Async([imagePath = std::string(scene.GetString(image))] {
+                PROFILE_SCOPE("Decode image");
+                return ResourceManager::LoadImageResource(imagePath);
+            }));
+        }
+
+        std::vector<TextureHandle> imageTextures;
+        imageTextures.reserve(imageTasks.size());
+
+        for (auto& imageTask: imageTasks)
+        {
+            const ImageResource imageResource = imageTask.Get();
+            imageTextures.push_back(ResourceManager::CreateTextureFromImage(device, imageResource));
+            ResourceManager::ReleaseImage(imageResource);
+        }
+
+        const auto GetImageTexture = [&](const int32_t image) {
+            return image >= 0 ? imageTextures[image] : INVALID_TEXTURE_HANDLE;
+        };
+
+        const auto sceneGraph = new SceneGraph();
+        sceneGraph->vertexFormat = vertexFormat;
+
+        for (const BakedMaterial& material: scene.materials)
+        {
+            const MaterialCreateInfo materialCreateInfo = {
+                .baseColor = material.baseColor,
+                .metallic = material.metallic,
+                .roughness = material.roughness,
+                .baseColorTextureHandle = GetImageTexture(material.baseColorImage),
+                .normalMapTextureHandle = GetImageTexture(material.normalMapImage),
+                .metallicRoughnessTextureHandle = GetImageTexture(material.metallicRoughnessImage),
+                .isAlphaTested = material.alphaTested != 0,
+            };
+
+            sceneGraph->materials.push_back(device->CreateMaterial(materialCreateInfo));
+        }
+
+        // Nodes instancing the same mesh share one upload
+        std::vector<VulkanMesh*> bakedMeshes(scene.meshes.size(), nullptr);
+
+        for (const BakedNode& node: scene.nodes)
+        {
+            VulkanMesh* mesh = nullptr;
+
+            if (node.mesh >= 0 && bakedMeshes[node.mesh])
+            {
+                mesh = bakedMeshes[node.mesh];
+            } else if (node.mesh >= 0)
+            {
+                mesh = new VulkanMesh(device, vertexFormat);
+                bakedMeshes[node.mesh] = mesh;
+
+                const BakedMesh& bakedMesh = scene.meshes[node.mesh];
+                for (const BakedPrimitive& primitive: scene.primitives.subspan(bakedMesh.firstPrimitive, bakedMesh.primitiveCount))
+                {
+                    mesh->AddMeshlet(scene.vertices.subspan(primitive.firstVertex, primitive.vertexCount),
+                                     scene.indices.subspan(primitive.firstIndex, primitive.indexCount),
+                                     primitive.materialIndex >= 0
+                                         ? sceneGraph->materials[primitive.materialIndex]
+                                         : INVALID_MATERIAL_HANDLE,
+                                     {primitive.boundsMin, primitive.boundsMax},
+                                     scene.clusters.subspan(primitive.firstCluster, primitive.clusterCount));
+                }
+            }
+
+            Transform transform;
+            transform.m_Position = node.position;
+            transform.m_Rotation = node.rotation;
+            transform.m_Scale = node.scale;
+
+            sceneGraph->AddNode(node.parent, std::string(scene.GetString(node.name)), transform, mesh);
+        }
+
+        return sceneGraph;
+    }
+}
@@ -0,0 +1,283 @@
+#include "util/job_system.h"
+
+#include <stdexcept>
+
+#include "util/profiler.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        // Failed searches before an idle worker goes to sleep, short gaps between jobs are common within a frame
+        static constexpr uint32_t IDLE_SPIN_COUNT = 64;
+    }
+
+    JobSystem* JobSystem::instance = nullptr;
+    thread_local size_t JobSystem::threadIndex = INVALID_THREAD_INDEX;
+
+    bool JobDeque::Push(Job* job)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) return false;
+
+        buffer[b % CAPACITY].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    Job* JobDeque::Pop()
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = buffer[b % CAPACITY].load(std::memory_order_relaxed);
+        if (t != b) return job;
+
+        // Last job, races the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return job;
+    }
+
+    Job* JobDeque::Steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) return nullptr;
+
+        Job* job = buffer[t % CAPACITY].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return job;
+    }
+
+    JobSystem* JobSystem::Create(const size_t workerCount)
+    {
+        return new JobSystem(workerCount);
+    }
+
+    void JobSystem::Destroy()
+    {
+        delete instance;
+        instance = nullptr;
+    }
+
+    JobSystem::JobSystem(const size_t workerCount)
+    {
+        ASSERT(!instance, "Job system has been initialized already");
+        instance = this;
+        creatorThread = std::this_thread::get_id();
+
+        for (size_t i = 0; i < workerCount + 1; i++)
+            contexts.push_back(CreateScope<ThreadContext>());
+
+        for (size_t i = 0; i < workerCount; i++)
+            workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock(sleepMutex);
+            stop = true;
+        }
+
+        sleepCondition.notify_all();
+
+        for (auto& worker: workers)
+            worker.join();
+    }
+
+    void JobSystem::Wait(const JobCounter& counter)
+    {
+        // Threads outside of the job system own no deque, they can only wait
+        const bool canExecute = threadIndex != INVALID_THREAD_INDEX || std::this_thread::get_id() == creatorThread;
+
+        while (!counter.IsDone())
+        {
+            if (Job* job = canExecute ? FindJob() : nullptr)
+                Execute(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    Job* JobSystem::AllocateJob()
+    {
+        if (threadIndex == INVALID_THREAD_INDEX && std::this_thread::get_id() != creatorThread)
+            throw std::runtime_error("Jobs can only be run from the job system threads!");
+
+        ThreadContext& context = *contexts[GetThreadIndex()];
+
+        // Slots still in flight are skipped, one of them can be a job further up the stack of this thread
+        for (size_t attempt = 1;; attempt++)
+        {
+            Job* job = &context.jobs[context.nextJob++ % JOB_RING_SIZE];
+            if (!job->invoke.load(std::memory_order_acquire)) return job;
+
+            // Helps out instead of searching the whole ring, a job popped from the own deque frees its slot right away
+            if (Job* other = FindJob())
+            {
+                Execute(other);
+                if (other >= context.jobs.data() && other < context.jobs.data() + JOB_RING_SIZE) return other;
+            } else if (attempt % JOB_RING_SIZE == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::Schedule(Job* job)
+    {
+        if (job->dependency && !job->dependency->IsDone())
+        {
+            // Checked again under the lock, the last job of the dependency releases the blocked jobs after
+            // finishing and would miss one added in between
+            std::lock_guard lock(blockedMutex);
+            if (!job->dependency->IsDone())
+            {
+                blockedJobs.push_back(job);
+                blockedCount++;
+                return;
+            }
+        }
+
+        Push(job);
+    }
+
+    void JobSystem::Push(Job* job)
+    {
+        // Counted before it can be stolen so idle workers never see fewer jobs than there are
+        queuedJobs++;
+
+        // Only happens with every ring slot of the thread and all released jobs queued, not worth waiting for
+        if (!contexts[GetThreadIndex()]->deque.Push(job))
+        {
+            queuedJobs--;
+            Execute(job);
+            return;
+        }
+
+        // Taking the lock orders the wake up after a worker that is about to sleep has started waiting
+        if (sleepingWorkers.load() > 0)
+        {
+            {
+                std::lock_guard lock(sleepMutex);
+            }
+
+            sleepCondition.notify_one();
+        }
+    }
+
+    Job* JobSystem::FindJob()
+    {
+        const size_t index = GetThreadIndex();
+
+        if (Job* job = contexts[index]->deque.Pop())
+        {
+            queuedJobs--;
+            return job;
+        }
+
+        // Victims start at the next thread so the thieves spread out
+        for (size_t i = 1; i < contexts.size(); i++)
+        {
+            if (Job* job = contexts[(index + i) % contexts.size()]->deque.Steal())
+            {
+                queuedJobs--;
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void JobSystem::Execute(Job* job)
+    {
+        {
+            PROFILE_SCOPE("Job");
+            job->invoke.load(std::memory_order_acquire)(job->storage);
+        }
+
+        // The slot can be reused as soon as it is cleared
+        JobCounter* counter = job->counter;
+        job->invoke.store(nullptr, std::memory_order_release);
+
+        if (counter) counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+        if (blockedCount.load() > 0) ReleaseReadyJobs();
+    }
+
+    void JobSystem::ReleaseReadyJobs()
+    {
+        std::vector<Job*> readyJobs;
+
+        {
+            std::lock_guard lock(blockedMutex);
+
+            for (size_t i = 0; i < blockedJobs.size();)
+            {
+                if (!blockedJobs[i]->dependency->IsDone())
+                {
+                    i++;
+                    continue;
+                }
+
+                readyJobs.push_back(blockedJobs[i]);
+                blockedJobs[i] = blockedJobs.back();
+                blockedJobs.pop_back();
+            }
+
+            blockedCount = blockedJobs.size();
+        }
+
+        for (Job* job: readyJobs)
+            Push(job);
+    }
+
+    void JobSystem::WorkerLoop(const size_t index)
+    {
+        threadIndex = index;
+        PROFILE_THREAD("Worker " + std::to_string(index));
+
+        while (true)
+        {
+            Job* job = nullptr;
+            for (uint32_t spin = 0; spin < Utils::IDLE_SPIN_COUNT && !job; spin++)
+            {
+                job = FindJob();
+                if (!job) std::this_thread::yield();
+            }
+
+            if (job)
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock lock(sleepMutex);
+
+            sleepingWorkers++;
+            sleepCondition.wait(lock, [this] { return queuedJobs.load() > 0 || stop.load(); });
+            sleepingWorkers--;
+
+            // Blocked jobs are dropped, nothing is left to finish their dependencies
+            if (stop && queuedJobs.load() == 0) return;
+        }
+    }
+}
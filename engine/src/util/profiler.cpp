@@ -0,0 +1,231 @@
+#include "util/profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "util/log.h"
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        // Ring of the zones of one thread. Kept until the program exits, captures can still read zones of a thread
+        // that has already finished.
+        struct ProfilerThreadBuffer {
+            std::array<ProfileEvent, PROFILER_RING_SIZE> events{};
+            std::atomic<uint64_t> head = 0; // Zones ever written, published after the zone itself
+            uint32_t threadId = 0;
+            std::string name{};             // Guarded by the registry mutex
+        };
+
+        struct ProfilerEventCopy {
+            const char* name;
+            uint64_t start;
+            uint64_t end;
+        };
+
+        static std::mutex registryMutex;
+        static std::vector<std::unique_ptr<ProfilerThreadBuffer>> threadBuffers;
+        static thread_local ProfilerThreadBuffer* threadBuffer = nullptr;
+
+        static ProfilerThreadBuffer& GetThreadBuffer()
+        {
+            if (threadBuffer) return *threadBuffer;
+
+            std::lock_guard lock(registryMutex);
+
+            std::unique_ptr<ProfilerThreadBuffer>& buffer = threadBuffers.emplace_back(std::make_unique<ProfilerThreadBuffer>());
+            buffer->threadId = static_cast<uint32_t>(threadBuffers.size());
+            buffer->name = "Thread " + std::to_string(buffer->threadId);
+
+            threadBuffer = buffer.get();
+            return *buffer;
+        }
+
+        static std::mutex namesMutex;
+        static std::unordered_set<std::string> names;
+
+        static uint64_t lastFrameMark = 0;
+        static uint32_t captureFramesRequested = 0;
+
+        static void WriteJsonString(std::ostream& out, const std::string_view string)
+        {
+            static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+            out << '"';
+            for (const char c: string)
+            {
+                // Control characters are not allowed unescaped in JSON strings
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    out << "\\u00" << HEX_DIGITS[c >> 4] << HEX_DIGITS[c & 0xF];
+                    continue;
+                }
+
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << '"';
+        }
+
+        // Trace timestamps are in microseconds
+        static void WriteMicroseconds(std::ostream& out, const uint64_t nanoseconds)
+        {
+            out << nanoseconds / 1000 << '.' << std::setfill('0') << std::setw(3) << nanoseconds % 1000;
+        }
+    }
+
+    const std::chrono::steady_clock::time_point Profiler::epoch = std::chrono::steady_clock::now();
+
+    std::atomic<bool> Profiler::capturing = false;
+    uint64_t Profiler::captureStart = 0;
+
+    uint32_t Profiler::captureFramesLeft = 0;
+    std::string Profiler::captureFramesPath{};
+
+    void Profiler::AddZone(const char* name, const uint64_t start, const uint64_t end)
+    {
+        Utils::ProfilerThreadBuffer& buffer = Utils::GetThreadBuffer();
+
+        // Only this thread writes the head, readers check it again to drop zones overwritten while copying
+        const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        ProfileEvent& event = buffer.events[head % PROFILER_RING_SIZE];
+        event.name.store(name, std::memory_order_relaxed);
+        event.start.store(start, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::SetThreadName(const std::string& name)
+    {
+        Utils::ProfilerThreadBuffer& buffer = Utils::GetThreadBuffer();
+
+        std::lock_guard lock(Utils::registryMutex);
+        buffer.name = name;
+    }
+
+    void Profiler::MarkFrame()
+    {
+        const uint64_t now = Now();
+        if (Utils::lastFrameMark > 0)
+            AddZone("Frame", Utils::lastFrameMark, now);
+        Utils::lastFrameMark = now;
+
+        if (captureFramesLeft > 0 && --captureFramesLeft == 0)
+            EndCapture(captureFramesPath);
+
+        // Started on a frame boundary, so the capture holds whole frames only
+        if (Utils::captureFramesRequested > 0)
+        {
+            captureFramesLeft = Utils::captureFramesRequested;
+            Utils::captureFramesRequested = 0;
+            BeginCapture();
+        }
+    }
+
+    const char* Profiler::InternName(const std::string& name)
+    {
+        std::lock_guard lock(Utils::namesMutex);
+        return Utils::names.insert(name).first->c_str();
+    }
+
+    void Profiler::BeginCapture()
+    {
+        captureStart = Now();
+        capturing.store(true, std::memory_order_relaxed);
+    }
+
+    bool Profiler::EndCapture(const std::string& path)
+    {
+        if (!capturing.exchange(false, std::memory_order_relaxed)) return false;
+
+        captureFramesLeft = 0;
+        return WriteTrace(path, captureStart, Now());
+    }
+
+    void Profiler::CaptureFrames(const uint32_t frameCount, const std::string& path)
+    {
+        if (IsCapturing() || frameCount == 0) return;
+
+        Utils::captureFramesRequested = frameCount;
+        captureFramesPath = path;
+    }
+
+    bool Profiler::WriteTrace(const std::string& path, const uint64_t from, const uint64_t to)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            LOG_ERROR("Failed to open trace file: {}", path);
+            return false;
+        }
+
+        std::lock_guard lock(Utils::registryMutex);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        bool first = true;
+        size_t zoneCount = 0;
+        std::vector<Utils::ProfilerEventCopy> events{};
+
+        for (const std::unique_ptr<Utils::ProfilerThreadBuffer>& buffer: Utils::threadBuffers)
+        {
+            const uint64_t head = buffer->head.load(std::memory_order_acquire);
+            const uint64_t oldest = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+
+            events.clear();
+            for (uint64_t i = oldest; i < head; i++)
+            {
+                const ProfileEvent& event = buffer->events[i % PROFILER_RING_SIZE];
+                events.push_back({
+                    event.name.load(std::memory_order_relaxed),
+                    event.start.load(std::memory_order_relaxed),
+                    event.end.load(std::memory_order_relaxed)
+                });
+            }
+
+            // The thread kept writing while the zones were copied, the oldest ones may have been replaced since
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t newHead = buffer->head.load(std::memory_order_relaxed);
+            const uint64_t valid = newHead >= PROFILER_RING_SIZE ? newHead - PROFILER_RING_SIZE + 1 : 0;
+            const size_t skipped = valid > oldest ? std::min<size_t>(valid - oldest, events.size()) : 0;
+
+            if (skipped < events.size() && events[skipped].end > from && (oldest > 0 || skipped > 0))
+                LOG_WARN("Trace of thread {} starts late, the capture is longer than its zone buffer", buffer->name);
+
+            out << (first ? "" : ",\n") << R"({"ph":"M","pid":1,"tid":)" << buffer->threadId
+                << R"(,"name":"thread_name","args":{"name":)";
+            Utils::WriteJsonString(out, buffer->name);
+            out << "}}";
+            first = false;
+
+            for (size_t i = skipped; i < events.size(); i++)
+            {
+                const Utils::ProfilerEventCopy& event = events[i];
+                if (event.end < from || event.end > to) continue;
+
+                out << ",\n" << R"({"ph":"X","pid":1,"tid":)" << buffer->threadId << R"(,"name":)";
+                Utils::WriteJsonString(out, event.name);
+                out << R"(,"ts":)";
+                Utils::WriteMicroseconds(out, event.start);
+                out << R"(,"dur":)";
+                Utils::WriteMicroseconds(out, event.end - event.start);
+                out << "}";
+
+                zoneCount++;
+            }
+        }
+
+        out << "\n]}\n";
+
+        LOG_INFO("Wrote {} profiler zones to {}", zoneCount, path);
+        return static_cast<bool>(out);
+    }
+}
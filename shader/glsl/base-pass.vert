@@ -1,9 +1,14 @@
 #version 450
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_ARB_shading_language_include : require
+#extension GL_EXT_buffer_reference : require
+
+#include <draw_data.glslh>
+#include <vertex_input.glslh>
 
 layout(push_constant) uniform Push {
-    mat4 modelMatrix;
-    uint materialIndex;
+    DrawDataBuffer drawDataBuffer;
+    InstanceDataBuffer instanceDataBuffer;
 } push;
 
 layout(set = 2, binding = 0) uniform CameraBuffer {
@@ -12,13 +17,6 @@ layout(set = 2, binding = 0) uniform CameraBuffer {
     vec3 cameraPosition;
 } camera;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
-layout(location = 5) in vec3 inBitangent;
-
 layout(location = 0) out vec3 outFragPosition;
 layout(location = 1) out vec3 outFragColor;
 layout(location = 2) out vec2 outFragTexCoord;
@@ -26,23 +24,29 @@ layout(location = 3) out vec3 outFragNormal;
 layout(location = 4) out vec4 outWorldPosition;
 layout(location = 5) out vec3 outViewPosition;
 layout(location = 6) out mat3 TBN;
+layout(location = 9) flat out uint outMaterialIndex;
 
 
 void main() {
-    vec4 worldPosition = push.modelMatrix * vec4(inPosition, 1.0);
+    DrawData draw = push.drawDataBuffer.draws[gl_InstanceIndex];
+    mat4 modelMatrix = push.instanceDataBuffer.instances[draw.instanceIndex].modelMatrix;
+    VertexInput vertex = DecodeVertex(draw);
+
+    vec4 worldPosition = modelMatrix * vec4(vertex.position, 1.0);
     vec4 viewPosition = camera.view * vec4(worldPosition.xyz, 1.0);
 
     outWorldPosition = worldPosition;
     outViewPosition = viewPosition.xyz;
     outFragPosition = worldPosition.xyz;
 
-    outFragColor = inColor;
-    outFragTexCoord = inTexCoord;
-    outFragNormal = normalize(transpose(inverse(mat3(push.modelMatrix))) * inNormal);
+    outMaterialIndex = draw.materialIndex;
+    outFragColor = vertex.color;
+    outFragTexCoord = vertex.texCoord;
+    outFragNormal = normalize(transpose(inverse(mat3(modelMatrix))) * vertex.normal);
 
-    vec3 N = normalize(vec3(push.modelMatrix * vec4(inNormal, 0.0)));
-    vec3 T = normalize(vec3(push.modelMatrix * vec4(inTangent, 0.0)));
-    vec3 B = normalize(vec3(push.modelMatrix * vec4(inBitangent, 0.0)));
+    vec3 N = normalize(vec3(modelMatrix * vec4(vertex.normal, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix * vec4(vertex.tangent, 0.0)));
+    vec3 B = normalize(vec3(modelMatrix * vec4(vertex.bitangent, 0.0)));
     TBN = mat3(T, B, N);
 
     gl_Position = camera.projection * viewPosition;
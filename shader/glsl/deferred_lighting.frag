@@ -0,0 +1,56 @@
+#version 450
+#extension GL_EXT_scalar_block_layout : require
+#extension GL_ARB_shading_language_include : require
+
+#include <lighting.glslh>
+
+// Shades every opaque pixel of the GBuffer once, the cost no longer depends on the scene geometry
+
+// ------------------------------------------------------------------
+// INPUT VARIABLES --------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(location = 0) in vec2 inTexCoord;
+
+// ------------------------------------------------------------------
+// OUTPUT VARIABLES -------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(location = 0) out vec4 finalImage;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// GBuffer, written by gbuffer.frag
+layout(set = 2, binding = 10)   uniform sampler2D gNormal;
+layout(set = 2, binding = 11)   uniform sampler2D gPosition;
+layout(set = 2, binding = 12)   uniform sampler2D gAlbedo;
+layout(set = 2, binding = 13)   uniform sampler2D gMaterial;
+layout(set = 2, binding = 14)   uniform usampler2D gMaterialId;
+
+// ------------------------------------------------------------------
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // Zero is left by the clear, the skybox stays visible there
+    uint materialId = texelFetch(gMaterialId, texel, 0).r;
+    if (materialId == 0u) discard;
+
+    vec3 viewPosition = texelFetch(gPosition, texel, 0).xyz;
+    vec2 metallicRoughness = texelFetch(gMaterial, texel, 0).rg;
+
+    SurfaceData surface;
+    surface.albedo = pow(texelFetch(gAlbedo, texel, 0).rgb, vec3(2.2));
+    surface.metallic = metallicRoughness.r;
+    surface.roughness = metallicRoughness.g;
+    surface.normal = normalize(texelFetch(gNormal, texel, 0).xyz);
+    // The view matrix is rigid, its inverse is the transposed rotation around the camera
+    surface.worldPosition = transpose(mat3(camera.view)) * (viewPosition - camera.view[3].xyz);
+    surface.viewDepth = viewPosition.z;
+    surface.screenTexCoord = inTexCoord;
+    surface.fragCoord = gl_FragCoord.xy;
+
+    finalImage = vec4(ShadeSurface(surface), 1.0);
+}
@@ -1,11 +1,17 @@
 #version 450
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_ARB_shading_language_include : require
+#extension GL_EXT_buffer_reference : require
+
+#include <draw_data.glslh>
 
 // ------------------------------------------------------------------
 // INPUT VARIABLES --------------------------------------------------
 // ------------------------------------------------------------------
 
-layout(location = 0) in vec3 inPosition;
+// Only the position stream is fetched
+#define VERTEX_POSITION_ONLY
+#include <vertex_input.glslh>
 
 // ------------------------------------------------------------------
 // UNIFORMS ---------------------------------------------------------
@@ -13,12 +19,15 @@ layout(location = 0) in vec3 inPosition;
 
 layout(push_constant) uniform Push {
     mat4 projection;
-    mat4 modelMatrix;
+    DrawDataBuffer drawDataBuffer;
+    InstanceDataBuffer instanceDataBuffer;
 } push;
 
 // ------------------------------------------------------------------
 
 void main()
 {
-    gl_Position = push.projection * push.modelMatrix * vec4(inPosition, 1.0);
+    DrawData draw = push.drawDataBuffer.draws[gl_InstanceIndex];
+    mat4 modelMatrix = push.instanceDataBuffer.instances[draw.instanceIndex].modelMatrix;
+    gl_Position = push.projection * modelMatrix * vec4(DecodePosition(draw), 1.0);
 }
\ No newline at end of file
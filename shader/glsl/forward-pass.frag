@@ -0,0 +1,105 @@
+#version 450
+#extension GL_EXT_scalar_block_layout : require
+#extension GL_ARB_shading_language_include : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+#include <lighting.glslh>
+
+// Alpha tested surfaces are not in the GBuffer, they are shaded while rasterizing on top of the deferred resolve
+
+// ------------------------------------------------------------------
+// INPUT VARIABLES --------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(location = 0) in vec3 fragPosition;
+layout(location = 1) in vec3 fragColor;
+layout(location = 2) in vec2 fragTexCoord;
+layout(location = 3) in vec3 fragNormal;
+layout(location = 4) in vec4 inWorldPosition;
+layout(location = 5) in vec3 inViewPosition;
+layout(location = 6) in mat3 TBN;
+layout(location = 9) flat in uint materialIndex;
+
+// ------------------------------------------------------------------
+// OUTPUT VARIABLES -------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(location = 0) out vec4 finalImage;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+struct MaterialParamsObject {
+    vec4 tint;
+    vec4 baseColor;
+    float metallic;
+    float roughness;
+
+    uint baseColorTextureIndex;
+    uint normalMapTextureIndex;
+    uint metallicRoughnessTextureIndex;
+
+    bool alphaTested;
+};
+
+layout(std140,set = 1, binding = 0) readonly buffer MaterialBuffer{
+    MaterialParamsObject params[];
+} materials;
+
+// ------------------------------------------------------------------
+
+vec3 CalcSurfaceNormal(vec3 normalFromTexture, mat3 TBN)
+{
+    vec3 normal;
+    normal.xy = normalFromTexture.rg;
+    normal.xy = 2.0 * normal.xy - 1.0;
+    normal.z = sqrt(1.0 - dot(normal.xy, normal.xy));
+    return normalize(TBN * normal);
+}
+
+void main() {
+    vec3 baseColor;
+    float alpha;
+
+    MaterialParamsObject material = materials.params[materialIndex];
+
+    baseColor = material.baseColor.rgb;
+    alpha = material.baseColor.a;
+
+    if (material.baseColorTextureIndex < INVALID_TEXTURE_INDEX)
+    {
+        vec4 baseColorSampled = texture(textures[material.baseColorTextureIndex], fragTexCoord);
+        baseColor = pow(baseColorSampled.rgb, vec3(2.2));
+        alpha = baseColorSampled.a;
+    }
+
+    if (alpha < 0.5) discard;
+
+    SurfaceData surface;
+    surface.albedo = fragColor * material.tint.rgb * baseColor;
+    surface.metallic = material.metallic;
+    surface.roughness = material.roughness;
+
+    if (material.metallicRoughnessTextureIndex < INVALID_TEXTURE_INDEX)
+    {
+        vec4 metallicRoughness = texture(textures[material.metallicRoughnessTextureIndex], fragTexCoord);
+
+        surface.metallic = metallicRoughness.b;
+        surface.roughness = metallicRoughness.g;
+    }
+
+    vec3 normalMapColor = texture(textures[material.normalMapTextureIndex], fragTexCoord).rgb;
+
+    surface.normal = material.normalMapTextureIndex < INVALID_TEXTURE_INDEX
+    ? CalcSurfaceNormal(normalMapColor, TBN)
+    : fragNormal;
+    surface.worldPosition = inWorldPosition.xyz;
+    surface.viewDepth = inViewPosition.z;
+    surface.screenTexCoord = ((gl_FragCoord.xy + vec2(1.0)) * 0.5) / textureSize(SSAO, 0);
+    surface.fragCoord = gl_FragCoord.xy;
+
+    finalImage = vec4(ShadeSurface(surface), 1.0);
+}
@@ -19,6 +19,7 @@ layout(location = 1) in vec2 fragTexCoord;
 layout(location = 2) in vec3 fragNormal;
 layout(location = 3) in vec4 inWorldPosition;
 layout(location = 4) in mat3 TBN;
+layout(location = 7) flat in uint materialIndex;
 
 // ------------------------------------------------------------------
 // OUTPUT VARIABLES -------------------------------------------------
@@ -26,16 +27,14 @@ layout(location = 4) in mat3 TBN;
 
 layout(location = 0)            out vec4 normalImage;
 layout(location = 1)            out vec4 outWorldPosition;
+layout(location = 2)            out vec4 albedoImage;
+layout(location = 3)            out vec4 materialImage;
+layout(location = 4)            out uint materialIdImage;
 
 // ------------------------------------------------------------------
 // UNIFORMS ---------------------------------------------------------
 // ------------------------------------------------------------------
 
-layout(push_constant) uniform Push {
-    mat4 modelMatrix;
-    uint materialIndex;
-} push;
-
 layout(set = 0, binding = 0) uniform sampler2D textures[];
 
 
@@ -67,10 +66,22 @@ vec3 CalcSurfaceNormal(vec3 normalFromTexture, mat3 TBN)
 }
 
 void main() {
-    MaterialParamsObject material = materials.params[push.materialIndex];
+    MaterialParamsObject material = materials.params[materialIndex];
 
     vec4 baseColorSampled = texture(textures[material.baseColorTextureIndex], fragTexCoord);
     vec3 baseColor = material.baseColorTextureIndex < INVALID_TEXTURE_INDEX ? pow(baseColorSampled.rgb, vec3(2.2)) : material.baseColor.rgb;
+    vec3 albedo = fragColor * material.tint.rgb * baseColor;
+
+    float metallic = material.metallic;
+    float roughness = material.roughness;
+
+    if (material.metallicRoughnessTextureIndex < INVALID_TEXTURE_INDEX)
+    {
+        vec4 metallicRoughness = texture(textures[material.metallicRoughnessTextureIndex], fragTexCoord);
+
+        metallic = metallicRoughness.b;
+        roughness = metallicRoughness.g;
+    }
 
     vec3 normalMapColor = texture(textures[material.normalMapTextureIndex], fragTexCoord).rgb;
     vec3 N = material.normalMapTextureIndex < INVALID_TEXTURE_INDEX ? CalcSurfaceNormal(normalMapColor, TBN) : fragNormal;
@@ -78,5 +89,10 @@ void main() {
     /////////////////   GBuffer   ////////////////////////
     normalImage = vec4(N, 1.0);
     outWorldPosition = vec4(inWorldPosition.xyz, 1.0);
+    // Gamma encoded to keep the precision of dark albedo in 8 bits
+    albedoImage = vec4(pow(clamp(albedo, 0.0, 1.0), vec3(1.0 / 2.2)), 1.0);
+    materialImage = vec4(metallic, roughness, 0.0, 1.0);
+    // Offset by one, zero marks the pixels without geometry
+    materialIdImage = materialIndex + 1u;
     /////////////////////////////////////////////////////
 }
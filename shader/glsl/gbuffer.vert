@@ -1,9 +1,14 @@
 #version 450
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_ARB_shading_language_include : require
+#extension GL_EXT_buffer_reference : require
+
+#include <draw_data.glslh>
+#include <vertex_input.glslh>
 
 layout(push_constant) uniform Push {
-    mat4 modelMatrix;
-    uint materialIndex;
+    DrawDataBuffer drawDataBuffer;
+    InstanceDataBuffer instanceDataBuffer;
 } push;
 
 layout(set = 2, binding = 0) uniform Transforms {
@@ -12,29 +17,28 @@ layout(set = 2, binding = 0) uniform Transforms {
     vec3 cameraPosition;
 } transforms;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
-layout(location = 5) in vec3 inBitangent;
-
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out vec3 fragNormal;
 layout(location = 3) out vec4 viewSpacePosition;
 layout(location = 4) out mat3 TBN;
+layout(location = 7) flat out uint materialIndex;
 
 void main() {
-    viewSpacePosition = transforms.view * push.modelMatrix * vec4(inPosition, 1.0);
+    DrawData draw = push.drawDataBuffer.draws[gl_InstanceIndex];
+    mat4 modelMatrix = push.instanceDataBuffer.instances[draw.instanceIndex].modelMatrix;
+    VertexInput vertex = DecodeVertex(draw);
+
+    viewSpacePosition = transforms.view * modelMatrix * vec4(vertex.position, 1.0);
+    materialIndex = draw.materialIndex;
 
-    fragColor = inColor;
-    fragTexCoord = inTexCoord;
-    fragNormal = normalize(transpose(inverse(mat3(push.modelMatrix))) * inNormal);
+    fragColor = vertex.color;
+    fragTexCoord = vertex.texCoord;
+    fragNormal = normalize(transpose(inverse(mat3(modelMatrix))) * vertex.normal);
 
-    vec3 N = normalize(vec3(push.modelMatrix * vec4(inNormal, 0.0)));
-    vec3 T = normalize(vec3(push.modelMatrix * vec4(inTangent, 0.0)));
-    vec3 B = normalize(vec3(push.modelMatrix * vec4(inBitangent, 0.0)));
+    vec3 N = normalize(vec3(modelMatrix * vec4(vertex.normal, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix * vec4(vertex.tangent, 0.0)));
+    vec3 B = normalize(vec3(modelMatrix * vec4(vertex.bitangent, 0.0)));
     TBN = mat3(T, B, N);
 
     gl_Position = transforms.projection * viewSpacePosition;
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <thread>
+
+#include "memory/linear_arena.h"
+#include "renderer/vulkan/vulkan_device.h"
+#include "util/deletion_queue.h"
+#include "util/job_system.h"
+#include "util/profiler.h"
+
+// Replaces the global operator new to count heap allocations, then runs the CPU side of steady state frames: the
+// DrawFrame callbacks, the frame arena, pass recording jobs, parallel loops, the deletion queue and profiler zones.
+// Fails if any allocates.
+namespace
+{
+    std::atomic<bool> counting = false;
+    std::atomic<uint32_t> allocationCount = 0;
+
+    void* CountedAllocate(const size_t size, const std::align_val_t alignment)
+    {
+        if (counting.load(std::memory_order_relaxed))
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        const size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+        void* memory = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+        if (!memory) throw std::bad_alloc();
+
+        return memory;
+    }
+}
+
+void* operator new(const size_t size) { return CountedAllocate(size, std::align_val_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__)); }
+void* operator new[](const size_t size) { return CountedAllocate(size, std::align_val_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__)); }
+void* operator new(const size_t size, const std::align_val_t alignment) { return CountedAllocate(size, alignment); }
+void* operator new[](const size_t size, const std::align_val_t alignment) { return CountedAllocate(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+
+namespace MongooseVK
+{
+    namespace Utils
+    {
+        static constexpr size_t TEST_WORKER_COUNT = 3;
+        static constexpr uint32_t TEST_WARMUP_FRAMES = 4;
+        static constexpr uint32_t TEST_FRAMES = 64;
+        static constexpr uint32_t TEST_PASS_COUNT = 24;
+        static constexpr uint32_t TEST_DRAW_COUNT = 4096;
+        static constexpr uint32_t TEST_RESIZE_INTERVAL = 16; // Frames between swapchains going out of date
+
+        struct FakeHandle {
+            uint64_t handle;
+        };
+
+        // Keeps every thread busy until all of them run a job, so each has set up its profiler buffer
+        static void StartAllThreads(JobSystem* jobSystem)
+        {
+            std::atomic<size_t> started = 0;
+
+            JobCounter counter;
+            for (size_t i = 0; i < TEST_WORKER_COUNT + 1; i++)
+            {
+                jobSystem->Run([&started] {
+                    started++;
+                    while (started.load() < TEST_WORKER_COUNT + 1)
+                        std::this_thread::yield();
+                }, &counter);
+            }
+
+            jobSystem->Wait(counter);
+        }
+
+        // VulkanDevice::DrawFrame without the GPU work, takes and calls the callbacks the same way
+        static void DrawFrame(const bool outOfDate, DeletionQueue& deletionQueue, LinearArena& frameArena,
+                              DrawFrameFunction draw, OutOfDateErrorCallback errorCallback)
+        {
+            if (outOfDate)
+            {
+                errorCallback();
+                return;
+            }
+
+            deletionQueue.Flush();
+            frameArena.Reset();
+
+            draw(VK_NULL_HANDLE, 0);
+        }
+
+        // Mirrors what the frame graph does on the CPU while the frame is recorded
+        static void RecordFrame(JobSystem* jobSystem, LinearArena& frameArena, DeletionQueue& deletionQueue,
+                                std::atomic<uint64_t>& destroyed)
+        {
+            PROFILE_SCOPE("Record frame");
+
+            ArenaVector<JobCounter> recordings(TEST_PASS_COUNT, frameArena);
+            ArenaVector<uint32_t> drawCounts(TEST_PASS_COUNT, 0, frameArena);
+
+            for (uint32_t pass = 0; pass < TEST_PASS_COUNT; pass++)
+            {
+                uint32_t* drawCount = &drawCounts[pass];
+                LinearArena* arena = &frameArena;
+
+                jobSystem->Run([drawCount, arena] {
+                    PROFILE_SCOPE("Record pass");
+
+                    // The descriptor sets of every draw, like DrawCommandParams gets them
+                    for (uint32_t draw = 0; draw < TEST_DRAW_COUNT / TEST_PASS_COUNT; draw++)
+                    {
+                        const std::span<FakeHandle> descriptorSets = arena->Copy<FakeHandle>({{0}, {1}, {draw}});
+                        *drawCount += descriptorSets.back().handle == draw;
+                    }
+                }, &recordings[pass]);
+            }
+
+            for (JobCounter& recording: recordings)
+                jobSystem->Wait(recording);
+
+            ArenaVector<uint64_t> transforms(TEST_DRAW_COUNT, frameArena);
+            jobSystem->ParallelFor(TEST_DRAW_COUNT, 256, [&transforms](const uint32_t i) {
+                transforms[i] = static_cast<uint64_t>(i) * i;
+            });
+
+            // A few resources are released every frame, e.g. the staging buffers of streamed meshes
+            for (uint64_t i = 0; i < 8; i++)
+            {
+                const FakeHandle handle{i};
+                deletionQueue.Push([&destroyed, handle] { destroyed += handle.handle; });
+            }
+        }
+
+        // Passes the callbacks like VulkanRenderer::Draw, a lambda capturing by reference and a member call
+        static void Draw(const uint32_t frame, JobSystem* jobSystem, LinearArena& frameArena, DeletionQueue& deletionQueue,
+                         std::atomic<uint64_t>& destroyed, uint32_t& resizeCount)
+        {
+            PROFILE_SCOPE("Frame");
+
+            DrawFrame(frame % TEST_RESIZE_INTERVAL == TEST_RESIZE_INTERVAL - 1, deletionQueue, frameArena,
+                      [&](const VkCommandBuffer, const uint32_t) {
+                          RecordFrame(jobSystem, frameArena, deletionQueue, destroyed);
+                      },
+                      [&resizeCount] { resizeCount++; });
+
+            Profiler::MarkFrame();
+        }
+    }
+}
+
+int main()
+{
+    using namespace MongooseVK;
+
+    JobSystem* jobSystem = JobSystem::Create(Utils::TEST_WORKER_COUNT);
+    LinearArena frameArena(256 * 1024);
+    DeletionQueue deletionQueue;
+    std::atomic<uint64_t> destroyed = 0;
+    uint32_t resizeCount = 0;
+
+    Utils::StartAllThreads(jobSystem);
+
+    // Containers reach their high-water mark and every thread has touched its buffers
+    for (uint32_t i = 0; i < Utils::TEST_WARMUP_FRAMES; i++)
+        Utils::Draw(i, jobSystem, frameArena, deletionQueue, destroyed, resizeCount);
+
+    counting = true;
+    for (uint32_t i = 0; i < Utils::TEST_FRAMES; i++)
+        Utils::Draw(i, jobSystem, frameArena, deletionQueue, destroyed, resizeCount);
+    counting = false;
+
+    deletionQueue.Flush();
+    JobSystem::Destroy();
+
+    const uint32_t allocations = allocationCount.load();
+    const uint32_t overflows = frameArena.GetLastOverflowCount();
+    std::printf("%u heap allocations in %u frames, %u frame arena overflows, %u resizes, %llu deleted\n", allocations,
+                Utils::TEST_FRAMES, overflows, resizeCount, static_cast<unsigned long long>(destroyed.load()));
+
+    return allocations == 0 && overflows == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}